@@ -26,9 +26,13 @@
 #include <BRepPrimAPI_MakeCone.hxx>
 #include <BRepBndLib.hxx>
 #include <Graphic3d_ArrayOfPoints.hxx>
+#include <Graphic3d_AttribBuffer.hxx>
+#include <Message.hxx>
+#include <OSD_Timer.hxx>
 #include <Prs3d_Arrow.hxx>
 #include <Prs3d_ArrowAspect.hxx>
 #include <Prs3d_BndBox.hxx>
+#include <Prs3d_PointAspect.hxx>
 #include <Prs3d_ShadingAspect.hxx>
 #include <Prs3d_ToolCylinder.hxx>
 #include <Prs3d_ToolDisk.hxx>
@@ -41,6 +45,377 @@
 #include <Select3D_SensitivePrimitiveArray.hxx>
 #include <V3d_Viewer.hxx>
 #include <math_BullardGenerator.hxx>
+#include <NCollection_DataMap.hxx>
+#include <NCollection_Vector.hxx>
+#include <OSD_Parallel.hxx>
+#include <TColStd_MapTransientHasher.hxx>
+#include <gp_QuaternionNLerp.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+//! Number of heap allocations made by the process.
+static std::atomic<uint64_t> THE_NB_HEAP_ALLOCS (0);
+
+#if defined(__GLIBC__)
+// count heap allocations by intercepting malloc() family, including allocations made by OCCT libraries;
+// aligned allocations are intercepted as well, as they are used by OCCT (Standard::AllocateAligned())
+// and by C++17 aligned operator new, while glibc exports only __libc_memalign() to implement all of them
+extern "C" void* __libc_malloc  (size_t );
+extern "C" void* __libc_calloc  (size_t , size_t );
+extern "C" void* __libc_realloc (void* , size_t );
+extern "C" void* __libc_memalign (size_t , size_t );
+extern "C" void* malloc (size_t theSize) __THROW
+{
+  THE_NB_HEAP_ALLOCS.fetch_add (1, std::memory_order_relaxed);
+  return __libc_malloc (theSize);
+}
+extern "C" void* calloc (size_t theNb, size_t theSize) __THROW
+{
+  THE_NB_HEAP_ALLOCS.fetch_add (1, std::memory_order_relaxed);
+  return __libc_calloc (theNb, theSize);
+}
+extern "C" void* realloc (void* thePtr, size_t theSize) __THROW
+{
+  THE_NB_HEAP_ALLOCS.fetch_add (1, std::memory_order_relaxed);
+  return __libc_realloc (thePtr, theSize);
+}
+extern "C" void* memalign (size_t theAlign, size_t theSize) __THROW
+{
+  THE_NB_HEAP_ALLOCS.fetch_add (1, std::memory_order_relaxed);
+  return __libc_memalign (theAlign, theSize);
+}
+extern "C" void* aligned_alloc (size_t theAlign, size_t theSize) __THROW
+{
+  THE_NB_HEAP_ALLOCS.fetch_add (1, std::memory_order_relaxed);
+  return __libc_memalign (theAlign, theSize);
+}
+extern "C" int posix_memalign (void** thePtr, size_t theAlign, size_t theSize) __THROW
+{
+  if (theAlign % sizeof(void*) != 0
+   || (theAlign & (theAlign - 1)) != 0)
+  {
+    return EINVAL;
+  }
+
+  THE_NB_HEAP_ALLOCS.fetch_add (1, std::memory_order_relaxed);
+  void* aPtr = __libc_memalign (theAlign, theSize);
+  if (aPtr == NULL && theSize != 0)
+  {
+    return ENOMEM;
+  }
+  *thePtr = aPtr;
+  return 0;
+}
+static const bool THE_HAS_ALLOC_COUNTER = true;
+#else
+static const bool THE_HAS_ALLOC_COUNTER = false;
+#endif
+
+//! Heap allocation statistics of hover highlighting, printed periodically to verify
+//! that steady-state hover does not allocate memory.
+struct MyHoverStats
+{
+  uint64_t NbUpdates       = 0; //!< number of hover highlight updates
+  uint64_t NbOwnerAllocs   = 0; //!< allocations within owner highlighting code (arrow update)
+  uint64_t NbImmediateAllocs = 0; //!< allocations within AddToImmediateList()
+  uint64_t NbFrames        = 0; //!< number of frames with hover updates
+  uint64_t NbFrameAllocs   = 0; //!< allocations within frames with hover updates (picking + redraw)
+  int      NbReports       = 0; //!< number of printed reports
+
+  //! Return global instance.
+  static MyHoverStats& Get() { static MyHoverStats THE_STATS; return THE_STATS; }
+
+  //! Return current number of heap allocations.
+  static uint64_t NbHeapAllocs() { return THE_NB_HEAP_ALLOCS.load (std::memory_order_relaxed); }
+
+  //! Print statistics after every 100 updates and reset counters.
+  void Report()
+  {
+    if (NbUpdates < 100 || !THE_HAS_ALLOC_COUNTER)
+    {
+      return;
+    }
+
+    const double aNbUpdates = double(NbUpdates), aNbFrames = double(std::max (NbFrames, uint64_t(1)));
+    Message::SendInfo() << "Hover: " << NbUpdates << " updates, heap allocations per update: owner "
+                        << double(NbOwnerAllocs) / aNbUpdates << ", immediate list " << double(NbImmediateAllocs) / aNbUpdates
+                        << "; per frame " << double(NbFrameAllocs) / aNbFrames
+                        << (NbReports == 0 ? " (including warm-up)" : "");
+    *this = MyHoverStats();
+    NbReports = 1;
+  }
+};
+
+//! Object animation which could be reinitialized with new end points, so that it is reused across clicks.
+class MyAnimationObject : public AIS_AnimationObject
+{
+  DEFINE_STANDARD_RTTI_INLINE(MyAnimationObject, AIS_AnimationObject)
+public:
+  MyAnimationObject (const Handle(AIS_InteractiveContext)& theCtx,
+                     const Handle(AIS_InteractiveObject)& theObj)
+  : AIS_AnimationObject ("MyAnim", theCtx, theObj, gp_Trsf(), gp_Trsf()) {}
+
+  //! Reset start and end transformations.
+  void SetEndPoints (const gp_Trsf& theTrsfFrom, const gp_Trsf& theTrsfTo) { myTrsfLerp.Init (theTrsfFrom, theTrsfTo); }
+};
+
+//! Pool of transient presentation data of interactive owners and animations.
+//! Data is allocated on first use (warm-up) and then updated in place:
+//! the hover arrow is a single mutable vertex buffer transformed from a template,
+//! and animations are taken from a free list reset per interaction.
+class MyTransientPool : public Standard_Transient
+{
+  DEFINE_STANDARD_RTTI_INLINE(MyTransientPool, Standard_Transient)
+public:
+  MyTransientPool() : myNbUsedAnims (0) {}
+
+  //! Return arrow array; should be called after UpdateArrow().
+  const Handle(Graphic3d_ArrayOfTriangles)& ArrowArray() const { return myArrow; }
+
+  //! Place arrow at specified axis by updating vertex buffer in place.
+  void UpdateArrow (const gp_Ax1& theAxis);
+
+  //! Return animation from pool initialized with new end points.
+  const Handle(MyAnimationObject)& AcquireAnimation (const Handle(AIS_InteractiveContext)& theCtx,
+                                                     const Handle(AIS_InteractiveObject)& theObj,
+                                                     const gp_Trsf& theTrsfFrom,
+                                                     const gp_Trsf& theTrsfTo);
+
+  //! Release all animations taken from pool; should be called when starting a new interaction.
+  void ResetInteraction() { myNbUsedAnims = 0; }
+private:
+  Handle(Graphic3d_ArrayOfTriangles) myArrowTmpl; //!< arrow along Z axis at origin
+  Handle(Graphic3d_ArrayOfTriangles) myArrow;     //!< arrow with mutable vertex attributes
+  NCollection_Vector<Handle(MyAnimationObject)> myAnims; //!< pool of animations
+  int myNbUsedAnims;                              //!< number of animations in use by current interaction
+};
+
+void MyTransientPool::UpdateArrow (const gp_Ax1& theAxis)
+{
+  if (myArrow.IsNull())
+  {
+    myArrowTmpl = Prs3d_Arrow::DrawShaded (gp_Ax1 (gp::Origin(), gp::DZ()), 1.0, 15.0, 3.0, 4.0, 10);
+    myArrow = new Graphic3d_ArrayOfTriangles (myArrowTmpl->VertexNumber(), myArrowTmpl->EdgeNumber(),
+                                              Graphic3d_ArrayFlags_VertexNormal | Graphic3d_ArrayFlags_AttribsMutable);
+    for (int aVertIter = 1; aVertIter <= myArrowTmpl->VertexNumber(); ++aVertIter)
+    {
+      myArrow->AddVertex (myArrowTmpl->Vertice (aVertIter), myArrowTmpl->VertexNormal (aVertIter));
+    }
+    for (int anEdgeIter = 1; anEdgeIter <= myArrowTmpl->EdgeNumber(); ++anEdgeIter)
+    {
+      myArrow->AddEdge (myArrowTmpl->Edge (anEdgeIter));
+    }
+  }
+
+  gp_Trsf aTrsf;
+  aTrsf.SetTransformation (gp_Ax3 (theAxis.Location(), theAxis.Direction()), gp::XOY());
+  for (int aVertIter = 1; aVertIter <= myArrowTmpl->VertexNumber(); ++aVertIter)
+  {
+    myArrow->SetVertice (aVertIter, myArrowTmpl->Vertice (aVertIter).Transformed (aTrsf));
+    myArrow->SetVertexNormal (aVertIter, myArrowTmpl->VertexNormal (aVertIter).Transformed (aTrsf));
+  }
+  // only modified range of vertex buffer is re-uploaded to GPU
+  Handle(Graphic3d_AttribBuffer)::DownCast (myArrow->Attributes())->Invalidate (0, myArrow->VertexNumber() - 1);
+}
+
+const Handle(MyAnimationObject)& MyTransientPool::AcquireAnimation (const Handle(AIS_InteractiveContext)& theCtx,
+                                                                    const Handle(AIS_InteractiveObject)& theObj,
+                                                                    const gp_Trsf& theTrsfFrom,
+                                                                    const gp_Trsf& theTrsfTo)
+{
+  if (myNbUsedAnims >= myAnims.Length())
+  {
+    myAnims.Append (new MyAnimationObject (theCtx, theObj));
+  }
+
+  const Handle(MyAnimationObject)& anAnim = myAnims.Value (myNbUsedAnims++);
+  anAnim->SetEndPoints (theTrsfFrom, theTrsfTo);
+  return anAnim;
+}
+
+//! Own duration of animation playing until stopped.
+static const double THE_INFINITE_DURATION = 1.0e9;
+
+//! Animation of many objects evaluated in one pass over contiguous arrays (optionally in parallel).
+//! Resulting transformations are applied in bulk and the viewer is invalidated once per frame.
+//! Selection of an object is synchronized when its animation is finished.
+class MyBatchAnimation : public AIS_Animation
+{
+  DEFINE_STANDARD_RTTI_INLINE(MyBatchAnimation, AIS_Animation)
+public:
+  //! Main constructor; animation plays until stopped.
+  MyBatchAnimation (const Handle(AIS_InteractiveContext)& theCtx)
+  : AIS_Animation ("MyBatchAnim"), myContext (theCtx), myCurrentTime (0.0), myUpdateTime (0.0), myIsParallel (true)
+  {
+    SetOwnDuration (THE_INFINITE_DURATION);
+  }
+
+  //! Set if transformations should be evaluated in parallel threads.
+  void SetParallel (bool theIsParallel) { myIsParallel = theIsParallel; }
+
+  //! Return number of objects.
+  int NbObjects() const { return (int )myObjects.size(); }
+
+  //! Return local time of the last update.
+  double CurrentTime() const { return myCurrentTime; }
+
+  //! Return time spent by the last update in seconds.
+  double UpdateTime() const { return myUpdateTime; }
+
+  //! Add or restart object animation; entry of already added object is reused.
+  //! @param[in] theObj      object to animate
+  //! @param[in] theTrsfFrom start transformation
+  //! @param[in] theTrsfTo   end transformation
+  //! @param[in] theStart    local time to start animation, see CurrentTime()
+  //! @param[in] theDuration animation duration
+  //! @param[in] theToLoop   play animation back and forth until stopped
+  void AddObject (const Handle(AIS_InteractiveObject)& theObj,
+                  const gp_Trsf& theTrsfFrom,
+                  const gp_Trsf& theTrsfTo,
+                  double theStart,
+                  double theDuration,
+                  bool theToLoop);
+protected:
+  //! Evaluate and apply transformations of all objects.
+  virtual void update (const AIS_AnimationProgress& theProgress) override;
+
+  //! Evaluate transformations within range [theFrom, theTo).
+  void evaluate (int theFrom, int theTo);
+private:
+  //! Item state.
+  enum MyState { MyState_Idle = 0, MyState_Active, MyState_Looped };
+
+  //! Per-frame update flag.
+  enum MyUpdate { MyUpdate_None = 0, MyUpdate_Apply, MyUpdate_Finish };
+
+  //! Number of items evaluated by a single parallel task.
+  enum { THE_BLOCK_SIZE = 1024 };
+private:
+  Handle(AIS_InteractiveContext) myContext;
+  NCollection_DataMap<Handle(AIS_InteractiveObject), int, TColStd_MapTransientHasher> myIndices;
+  std::vector<Handle(AIS_InteractiveObject)> myObjects;
+  std::vector<gp_XYZ>        myLocFrom,   myLocTo;
+  std::vector<gp_Quaternion> myRotFrom,   myRotTo;
+  std::vector<double>        myScaleFrom, myScaleTo;
+  std::vector<double>        myStarts,    myDurations;
+  std::vector<uint8_t>       myStates;  //!< item states (MyState)
+  std::vector<uint8_t>       myUpdates; //!< item updates within current frame (MyUpdate)
+  std::vector<gp_Trsf>       myResults; //!< evaluated transformations
+  double myCurrentTime;
+  double myUpdateTime;
+  bool   myIsParallel;
+};
+
+void MyBatchAnimation::AddObject (const Handle(AIS_InteractiveObject)& theObj,
+                                  const gp_Trsf& theTrsfFrom,
+                                  const gp_Trsf& theTrsfTo,
+                                  double theStart,
+                                  double theDuration,
+                                  bool theToLoop)
+{
+  int anIndex = -1;
+  if (!myIndices.Find (theObj, anIndex))
+  {
+    anIndex = NbObjects();
+    myIndices.Bind (theObj, anIndex);
+    myObjects.push_back (theObj);
+    myLocFrom.emplace_back();   myLocTo.emplace_back();
+    myRotFrom.emplace_back();   myRotTo.emplace_back();
+    myScaleFrom.emplace_back(); myScaleTo.emplace_back();
+    myStarts.emplace_back();    myDurations.emplace_back();
+    myStates.emplace_back();
+    myUpdates.emplace_back();
+    myResults.emplace_back();
+  }
+
+  myLocFrom[anIndex]   = theTrsfFrom.TranslationPart();
+  myLocTo[anIndex]     = theTrsfTo.TranslationPart();
+  myRotFrom[anIndex]   = theTrsfFrom.GetRotation();
+  myRotTo[anIndex]     = theTrsfTo.GetRotation();
+  myScaleFrom[anIndex] = theTrsfFrom.ScaleFactor();
+  myScaleTo[anIndex]   = theTrsfTo.ScaleFactor();
+  myStarts[anIndex]    = theStart;
+  myDurations[anIndex] = std::max (theDuration, 0.001);
+  myStates[anIndex]    = theToLoop ? MyState_Looped : MyState_Active;
+}
+
+void MyBatchAnimation::evaluate (int theFrom, int theTo)
+{
+  for (int anIter = theFrom; anIter < theTo; ++anIter)
+  {
+    myUpdates[anIter] = MyUpdate_None;
+    if (myStates[anIter] == MyState_Idle)
+    {
+      continue;
+    }
+
+    double aT = (myCurrentTime - myStarts[anIter]) / myDurations[anIter];
+    if (aT < 0.0)
+    {
+      continue;
+    }
+
+    myUpdates[anIter] = MyUpdate_Apply;
+    if (myStates[anIter] == MyState_Looped)
+    {
+      aT = std::fmod (aT, 2.0);
+      aT = aT > 1.0 ? 2.0 - aT : aT;
+    }
+    else if (aT >= 1.0)
+    {
+      aT = 1.0;
+      myUpdates[anIter] = MyUpdate_Finish;
+    }
+
+    gp_Trsf& aTrsf = myResults[anIter];
+    aTrsf.SetRotation (gp_QuaternionNLerp::Interpolate (myRotFrom[anIter], myRotTo[anIter], aT));
+    aTrsf.SetTranslationPart (gp_Vec (myLocFrom[anIter] + (myLocTo[anIter] - myLocFrom[anIter]) * aT));
+    aTrsf.SetScaleFactor (myScaleFrom[anIter] + (myScaleTo[anIter] - myScaleFrom[anIter]) * aT);
+  }
+}
+
+void MyBatchAnimation::update (const AIS_AnimationProgress& theProgress)
+{
+  OSD_Timer aTimer;
+  aTimer.Start();
+  myCurrentTime = theProgress.LocalPts;
+
+  const int aNbObjects = NbObjects();
+  const int aNbBlocks = (aNbObjects + THE_BLOCK_SIZE - 1) / THE_BLOCK_SIZE;
+  OSD_Parallel::For (0, aNbBlocks, [this, aNbObjects](int theBlock)
+  {
+    evaluate (theBlock * THE_BLOCK_SIZE, std::min ((theBlock + 1) * THE_BLOCK_SIZE, aNbObjects));
+  }, !myIsParallel || aNbBlocks < 2);
+
+  // presentations are not thread-safe, so that transformations are applied in a single thread
+  bool isUpdated = false;
+  for (int anIter = 0; anIter < aNbObjects; ++anIter)
+  {
+    if (myUpdates[anIter] == MyUpdate_None)
+    {
+      continue;
+    }
+
+    isUpdated = true;
+    myObjects[anIter]->SetLocalTransformation (myResults[anIter]);
+    if (myUpdates[anIter] == MyUpdate_Finish)
+    {
+      myStates[anIter] = MyState_Idle;
+      myContext->SelectionManager()->Update (myObjects[anIter], false);
+    }
+  }
+  if (isUpdated)
+  {
+    myContext->CurrentViewer()->Invalidate();
+  }
+  myUpdateTime = aTimer.ElapsedTime();
+}
 
 //! Custom AIS object.
 class MyAisObject : public AIS_InteractiveObject
@@ -51,6 +426,15 @@ public:
 public:
   MyAisObject();
   void SetAnimation (const Handle(AIS_Animation)& theAnim) { myAnim = theAnim; }
+
+  //! Return pool of transient presentation data shared by owners.
+  const Handle(MyTransientPool)& TransientPool() const { return myPool; }
+
+  //! Return batched animation used instead of individual animations on click.
+  const Handle(MyBatchAnimation)& BatchAnimation() const { return myBatch; }
+
+  //! Set batched animation.
+  void SetBatchAnimation (const Handle(MyBatchAnimation)& theBatch) { myBatch = theBatch; }
 public:
   virtual void Compute (const Handle(PrsMgr_PresentationManager)& thePrsMgr,
                         const Handle(Prs3d_Presentation)& thePrs,
@@ -65,10 +449,13 @@ public:
   }
 protected:
   Handle(AIS_Animation) myAnim;
+  Handle(MyTransientPool) myPool;
+  Handle(MyBatchAnimation) myBatch;
   gp_Pnt myDragPntFrom;
 };
 
 MyAisObject::MyAisObject()
+: myPool (new MyTransientPool())
 {
   //SetHilightMode (MyDispMode_Highlight);
   myDrawer->SetupOwnShadingAspect();
@@ -146,6 +533,7 @@ public:
 protected:
   Handle(Prs3d_Presentation) myPrs;
   Handle(AIS_Animation) myAnim;
+  Handle(AIS_Animation) myLastAnim; //!< animation currently added to myAnim
 };
 
 void MyAisOwner::HilightWithColor (const Handle(PrsMgr_PresentationManager)& thePM,
@@ -171,22 +559,30 @@ void MyAisOwner::HilightWithColor (const Handle(PrsMgr_PresentationManager)& the
       }
     }
 
+    const uint64_t aNbAllocsBefore = MyHoverStats::NbHeapAllocs();
     Handle(Prs3d_Presentation) aPrs = mySelectable->GetHilightPresentation (thePM);
-    aPrs->Clear();
-    Handle(Graphic3d_Group) aGroupPnt = aPrs->NewGroup();
-    aGroupPnt->SetGroupPrimitivesAspect (theStyle->ArrowAspect()->Aspect());
-
+    const Handle(MyTransientPool)& aPool = anObj->TransientPool();
     gp_Trsf aTrsfInv (mySelectable->InversedTransformation().Trsf());
     gp_Dir  aNorm (aPickPnt.Normal.x(), aPickPnt.Normal.y(), aPickPnt.Normal.z());
-    Handle(Graphic3d_ArrayOfTriangles) aTris =
-      Prs3d_Arrow::DrawShaded (gp_Ax1(aPickPnt.Point, aNorm).Transformed (aTrsfInv),
-                               1.0, 15.0,
-                               3.0, 4.0, 10);
-    aGroupPnt->AddPrimitiveArray (aTris);
+    aPool->UpdateArrow (gp_Ax1(aPickPnt.Point, aNorm).Transformed (aTrsfInv));
+    if (aPrs->NumberOfGroups() == 0)
+    {
+      // group is created once and then reused by following hover updates
+      Handle(Graphic3d_Group) aGroupPnt = aPrs->NewGroup();
+      aGroupPnt->SetGroupPrimitivesAspect (theStyle->ArrowAspect()->Aspect());
+      aGroupPnt->AddPrimitiveArray (aPool->ArrowArray());
+      aPrs->SetInfiniteState (true); // bounds of arrow modified in place are not tracked
+      aPrs->SetZLayer (Graphic3d_ZLayerId_Top);
+    }
 
-    aPrs->SetZLayer (Graphic3d_ZLayerId_Top);
+    const uint64_t aNbAllocsOwner = MyHoverStats::NbHeapAllocs();
     thePM->AddToImmediateList (aPrs);
 
+    MyHoverStats& aStats = MyHoverStats::Get();
+    ++aStats.NbUpdates;
+    aStats.NbOwnerAllocs     += aNbAllocsOwner - aNbAllocsBefore;
+    aStats.NbImmediateAllocs += MyHoverStats::NbHeapAllocs() - aNbAllocsOwner;
+
     //Handle(Prs3d_PresentationShadow) aShadow = new Prs3d_PresentationShadow (thePM->StructureManager(), myPrs);
     //aShadow->SetZLayer (Graphic3d_ZLayerId_Top);
     //aShadow->Highlight (theStyle);
@@ -232,12 +628,45 @@ bool MyAisOwner::HandleMouseClick (const Graphic3d_Vec2i& thePoint,
     gp_Trsf aTrsfTo;
     aTrsfTo.SetRotation (gp_Ax1 (gp::Origin(), gp::DX()), isFirst ? M_PI * 0.5 : -M_PI * 0.5);
     gp_Trsf aTrsfFrom = anObj->LocalTransformation();
-    Handle(AIS_AnimationObject) anAnim = new AIS_AnimationObject ("MyAnim", anObj->InteractiveContext(), anObj, aTrsfFrom, aTrsfTo);
+    const Handle(MyBatchAnimation)& aBatch = anObj->BatchAnimation();
+    if (!aBatch.IsNull())
+    {
+      aBatch->AddObject (anObj, aTrsfFrom, aTrsfTo, aBatch->CurrentTime(), 2.0, false);
+      return true;
+    }
+
+    // previous animation is replaced, so that its pool entry is released
+    const Handle(MyTransientPool)& aPool = anObj->TransientPool();
+    aPool->ResetInteraction();
+    const Handle(MyAnimationObject)& anAnim = aPool->AcquireAnimation (anObj->InteractiveContext(), anObj, aTrsfFrom, aTrsfTo);
     anAnim->SetOwnDuration (2.0);
 
-    myAnim->Clear();
-    myAnim->Add (anAnim);
-    myAnim->StartTimer (0.0, 1.0, true);
+    // parent animation might also play per-object benchmark animations (-nobatch),
+    // so that only click animation is replaced and started at current time without restarting the others
+    const bool isPlaying = !myAnim->IsStopped();
+    anAnim->SetStartPts (isPlaying ? myAnim->ElapsedTime() : 0.0);
+    if (myLastAnim != anAnim
+    && !myLastAnim.IsNull())
+    {
+      myAnim->Remove (myLastAnim);
+    }
+    myLastAnim = anAnim;
+
+    // parent might have been cleared meanwhile (e.g. by AddAnimatedObjects())
+    bool isAdded = false;
+    for (NCollection_Sequence<Handle(AIS_Animation)>::Iterator aChildIter (myAnim->Children()); aChildIter.More() && !isAdded; aChildIter.Next())
+    {
+      isAdded = aChildIter.Value() == anAnim;
+    }
+    if (!isAdded)
+    {
+      myAnim->Add (anAnim);
+    }
+    myAnim->UpdateTotalDuration();
+    if (!isPlaying)
+    {
+      myAnim->StartTimer (0.0, 1.0, true);
+    }
   }
 
   return true;
@@ -263,12 +692,267 @@ void MyAisObject::ComputeSelection (const Handle(SelectMgr_Selection)& theSel,
   //theSel->Add (aSensBox);
 }
 
+//! Chunk of a point cloud.
+//! Each chunk is a separate interactive object, so that chunks out of view are skipped
+//! by frustum culling of structures and picking traverses BVH of chunk boxes before points.
+class MyPointCloudChunk : public AIS_InteractiveObject
+{
+  DEFINE_STANDARD_RTTI_INLINE(MyPointCloudChunk, AIS_InteractiveObject)
+public:
+  enum MyDispMode { MyDispMode_Full = 0, MyDispMode_Decimated = 1 };
+public:
+  //! Main constructor.
+  //! @param[in] thePoints     points with per-vertex colors
+  //! @param[in] theDecimation step between points in decimated display mode
+  MyPointCloudChunk (const Handle(Graphic3d_ArrayOfPoints)& thePoints, int theDecimation)
+  : myPoints (thePoints), myDecimation (theDecimation)
+  {
+    myDrawer->SetPointAspect (new Prs3d_PointAspect (Aspect_TOM_POINT, Quantity_NOC_WHITE, 1.0));
+  }
+
+  //! Return number of points.
+  int NbPoints() const { return myPoints->VertexNumber(); }
+
+  virtual void Compute (const Handle(PrsMgr_PresentationManager)& thePrsMgr,
+                        const Handle(Prs3d_Presentation)& thePrs,
+                        const Standard_Integer theMode) override;
+
+  virtual void ComputeSelection (const Handle(SelectMgr_Selection)& theSel,
+                                 const Standard_Integer theMode) override;
+
+  virtual bool AcceptDisplayMode (const Standard_Integer theMode) const override
+  {
+    return theMode == MyDispMode_Full || theMode == MyDispMode_Decimated;
+  }
+protected:
+  Handle(Graphic3d_ArrayOfPoints) myPoints;
+  int myDecimation;
+};
+
+void MyPointCloudChunk::Compute (const Handle(PrsMgr_PresentationManager)& ,
+                                 const Handle(Prs3d_Presentation)& thePrs,
+                                 const Standard_Integer theMode)
+{
+  Handle(Graphic3d_ArrayOfPoints) aPoints = myPoints;
+  if (theMode == MyDispMode_Decimated && myDecimation > 1)
+  {
+    const int aNbPoints = myPoints->VertexNumber() / myDecimation;
+    aPoints = new Graphic3d_ArrayOfPoints (std::max (aNbPoints, 1), Graphic3d_ArrayFlags_VertexColor);
+    for (int aPntIter = 1; aPntIter <= myPoints->VertexNumber(); aPntIter += myDecimation)
+    {
+      Graphic3d_Vec4ub aColor;
+      myPoints->VertexColor (aPntIter, aColor);
+      const int aNewIndex = aPoints->AddVertex (myPoints->Vertice (aPntIter));
+      aPoints->SetVertexColor (aNewIndex, aColor);
+      if (aNewIndex == aPoints->VertexNumberAllocated()) { break; }
+    }
+  }
+
+  Handle(Graphic3d_Group) aGroup = thePrs->NewGroup();
+  aGroup->SetGroupPrimitivesAspect (myDrawer->PointAspect()->Aspect());
+  aGroup->AddPrimitiveArray (aPoints);
+}
+
+void MyPointCloudChunk::ComputeSelection (const Handle(SelectMgr_Selection)& theSel,
+                                          const Standard_Integer theMode)
+{
+  if (theMode != 0)
+  {
+    return;
+  }
+
+  // points BVH is built on first detection within this chunk
+  Handle(SelectMgr_EntityOwner) anOwner = new SelectMgr_EntityOwner (this);
+  Handle(Select3D_SensitivePrimitiveArray) aSensPnts = new Select3D_SensitivePrimitiveArray (anOwner);
+  aSensPnts->SetSensitivityFactor (4);
+  if (aSensPnts->InitPoints (myPoints->Attributes(), TopLoc_Location()))
+  {
+    theSel->Add (aSensPnts);
+  }
+}
+
+//! Synthetic terrain scan split into square tiles, which are generated and displayed incrementally
+//! within a per-frame point budget starting from the center, so that first points appear immediately.
+//! The object itself presents bounding box of the whole cloud.
+class MyPointCloudObject : public AIS_InteractiveObject
+{
+  DEFINE_STANDARD_RTTI_INLINE(MyPointCloudObject, AIS_InteractiveObject)
+public:
+  //! Main constructor.
+  //! @param[in] theNbPoints    total number of points
+  //! @param[in] theRenderBudget maximum number of points drawn per frame while camera is moving
+  MyPointCloudObject (int64_t theNbPoints, int64_t theRenderBudget);
+
+  //! Return TRUE if some chunks are not yet displayed.
+  bool HasPendingChunks() const { return myNextTile < (int )myTiles.size(); }
+
+  //! Generate and display next chunks up to specified number of points.
+  void StreamChunks (const Handle(AIS_InteractiveContext)& theCtx, int64_t theBudget);
+
+  //! Switch chunks to decimated presentation while camera is moving and back to full detail at rest.
+  //! @return TRUE if another frame is required to restore full detail
+  bool UpdateLevelOfDetail (const Handle(AIS_InteractiveContext)& theCtx,
+                            const Handle(V3d_View)& theView);
+
+  virtual void Compute (const Handle(PrsMgr_PresentationManager)& thePrsMgr,
+                        const Handle(Prs3d_Presentation)& thePrs,
+                        const Standard_Integer theMode) override;
+
+  virtual void ComputeSelection (const Handle(SelectMgr_Selection)& ,
+                                 const Standard_Integer ) override {}
+
+  virtual bool AcceptDisplayMode (const Standard_Integer theMode) const override { return theMode == 0; }
+private:
+  //! Generate points of specified tile.
+  Handle(Graphic3d_ArrayOfPoints) generateTile (int theTile, int theNbPoints) const;
+private:
+  std::vector<Handle(MyPointCloudChunk)> myChunks;
+  std::vector<int> myTiles;    //!< indexes of tiles within grid sorted by distance to center
+  int     myNbTilesX;          //!< number of tiles along each side of terrain
+  int     myNextTile;          //!< next tile to display
+  int64_t myNbPoints;          //!< total number of points
+  int64_t myNbPointsPerTile;   //!< number of points within tile
+  int     myDecimation;        //!< step between points while camera is moving
+  bool    myIsDecimated;       //!< flag indicating that chunks are displayed in decimated mode
+  OSD_Timer myIdleTimer;       //!< time since last camera change
+  gp_Pnt  myLastEye, myLastCenter;
+  double  myLastScale;
+  OSD_Timer myStreamTimer;     //!< streaming timer
+};
+
+//! Terrain size.
+static const double THE_TERRAIN_SIZE = 1000.0;
+
+//! Terrain height.
+static double terrainHeight (double theX, double theY)
+{
+  return 40.0 * std::sin (theX * 0.01) * std::cos (theY * 0.013) + 10.0 * std::sin ((theX + theY) * 0.05);
+}
+
+MyPointCloudObject::MyPointCloudObject (int64_t theNbPoints, int64_t theRenderBudget)
+: myNbTilesX (1), myNextTile (0), myNbPoints (theNbPoints), myNbPointsPerTile (65536),
+  myDecimation (1), myIsDecimated (false), myLastScale (0.0)
+{
+  // take tiles within a disk of the smallest square grid having enough tiles
+  const int aNbTiles = (int )((theNbPoints + myNbPointsPerTile - 1) / myNbPointsPerTile);
+  myNbTilesX = (int )std::ceil (std::sqrt (double(aNbTiles) * 4.0 / M_PI));
+  std::vector<int> aGrid (myNbTilesX * myNbTilesX);
+  for (int aTileIter = 0; aTileIter < (int )aGrid.size(); ++aTileIter) { aGrid[aTileIter] = aTileIter; }
+  const double aHalf = 0.5 * (myNbTilesX - 1);
+  std::sort (aGrid.begin(), aGrid.end(), [this, aHalf](int theLeft, int theRight)
+  {
+    const double aDxL = theLeft  % myNbTilesX - aHalf, aDyL = theLeft  / myNbTilesX - aHalf;
+    const double aDxR = theRight % myNbTilesX - aHalf, aDyR = theRight / myNbTilesX - aHalf;
+    return aDxL * aDxL + aDyL * aDyL < aDxR * aDxR + aDyR * aDyR;
+  });
+  myTiles.assign (aGrid.begin(), aGrid.begin() + std::min (aNbTiles, (int )aGrid.size()));
+  myChunks.reserve (myTiles.size());
+
+  myDecimation = theRenderBudget > 0 ? (int )std::max (int64_t(1), (theNbPoints + theRenderBudget - 1) / theRenderBudget) : 1;
+  myDrawer->SetLineAspect (new Prs3d_LineAspect (Quantity_NOC_GRAY70, Aspect_TOL_DOT, 1.0));
+  myIdleTimer.Start();
+}
+
+void MyPointCloudObject::Compute (const Handle(PrsMgr_PresentationManager)& ,
+                                  const Handle(Prs3d_Presentation)& thePrs,
+                                  const Standard_Integer )
+{
+  const double aHalf = 0.5 * THE_TERRAIN_SIZE;
+  Bnd_Box aBox (gp_Pnt (-aHalf, -aHalf, -50.0), gp_Pnt (aHalf, aHalf, 50.0));
+  Prs3d_BndBox::Add (thePrs, aBox, myDrawer);
+}
+
+Handle(Graphic3d_ArrayOfPoints) MyPointCloudObject::generateTile (int theTile, int theNbPoints) const
+{
+  const double aTileSize = THE_TERRAIN_SIZE / myNbTilesX;
+  const double aX0 = (theTile % myNbTilesX) * aTileSize - 0.5 * THE_TERRAIN_SIZE;
+  const double aY0 = (theTile / myNbTilesX) * aTileSize - 0.5 * THE_TERRAIN_SIZE;
+  math_BullardGenerator aRandom (theTile);
+  Handle(Graphic3d_ArrayOfPoints) aPoints = new Graphic3d_ArrayOfPoints (theNbPoints, Graphic3d_ArrayFlags_VertexColor);
+  for (int aPntIter = 0; aPntIter < theNbPoints; ++aPntIter)
+  {
+    const double aX = aX0 + aRandom.NextReal() * aTileSize;
+    const double aY = aY0 + aRandom.NextReal() * aTileSize;
+    const double aZ = terrainHeight (aX, aY) + aRandom.NextReal() * 0.5;
+    const int anIndex = aPoints->AddVertex (aX, aY, aZ);
+
+    // color by height from blue to yellow
+    const double aT = std::max (0.0, std::min (1.0, (aZ + 50.0) / 100.0));
+    aPoints->SetVertexColor (anIndex, Graphic3d_Vec4ub ((uint8_t )(255.0 * aT), (uint8_t )(200.0 * aT + 55.0),
+                                                        (uint8_t )(255.0 * (1.0 - aT)), 255));
+  }
+  return aPoints;
+}
+
+void MyPointCloudObject::StreamChunks (const Handle(AIS_InteractiveContext)& theCtx, int64_t theBudget)
+{
+  if (myNextTile == 0) { myStreamTimer.Start(); }
+
+  int64_t aNbStreamed = 0;
+  while (HasPendingChunks() && aNbStreamed < theBudget)
+  {
+    const int64_t aFirstPoint = int64_t(myNextTile) * myNbPointsPerTile;
+    const int aNbPoints = (int )std::min (myNbPointsPerTile, myNbPoints - aFirstPoint);
+    Handle(MyPointCloudChunk) aChunk = new MyPointCloudChunk (generateTile (myTiles[myNextTile++], aNbPoints), myDecimation);
+    AddChild (aChunk); // share transformation with the whole cloud
+    theCtx->Display (aChunk, myIsDecimated ? MyPointCloudChunk::MyDispMode_Decimated : MyPointCloudChunk::MyDispMode_Full,
+                     0, false);
+    myChunks.push_back (aChunk);
+    aNbStreamed += aNbPoints;
+  }
+
+  if (!HasPendingChunks())
+  {
+    myStreamTimer.Stop();
+    Message::SendInfo() << "Point cloud: " << (double )myNbPoints << " points in " << (int )myChunks.size()
+                        << " chunks streamed in " << myStreamTimer.ElapsedTime() << " s";
+  }
+}
+
+bool MyPointCloudObject::UpdateLevelOfDetail (const Handle(AIS_InteractiveContext)& theCtx,
+                                              const Handle(V3d_View)& theView)
+{
+  const Handle(Graphic3d_Camera)& aCam = theView->Camera();
+  if (!aCam->Eye().IsEqual (myLastEye, 0.0)
+   || !aCam->Center().IsEqual (myLastCenter, 0.0)
+   || aCam->Scale() != myLastScale)
+  {
+    myLastEye    = aCam->Eye();
+    myLastCenter = aCam->Center();
+    myLastScale  = aCam->Scale();
+    myIdleTimer.Reset();
+    myIdleTimer.Start();
+  }
+
+  const bool toDecimate = myDecimation > 1 && myIdleTimer.ElapsedTime() < 0.3;
+  if (toDecimate != myIsDecimated)
+  {
+    myIsDecimated = toDecimate;
+    for (const Handle(MyPointCloudChunk)& aChunk : myChunks)
+    {
+      theCtx->SetDisplayMode (aChunk, myIsDecimated ? MyPointCloudChunk::MyDispMode_Decimated : MyPointCloudChunk::MyDispMode_Full, false);
+    }
+    theView->Invalidate();
+  }
+  return myIsDecimated;
+}
+
 //! Sample single-window viewer class.
 class MyViewer : public AIS_ViewController
 {
 public:
   //! Main constructor.
-  MyViewer()
+  //! @param[in] theNbCloudPoints number of points in synthetic point cloud to display (0 for none)
+  //! @param[in] theUploadBudget  number of points to generate and upload per frame while streaming
+  //! @param[in] theRenderBudget  maximum number of points to draw per frame while camera is moving
+  MyViewer (int64_t theNbCloudPoints = 0,
+            int64_t theUploadBudget = 2000000,
+            int64_t theRenderBudget = 5000000)
+  : myUploadBudget (theUploadBudget),
+    myNbAnimObjects (0),
+    myNbAnimFrames (0),
+    myAnimRedrawTime (0.0),
+    myAnimUpdateTime (0.0)
   {
     // graphic driver setup
     Handle(Aspect_DisplayConnection) aDisplay = new Aspect_DisplayConnection();
@@ -308,9 +992,15 @@ public:
     // interactive context and demo scene
     myContext = new AIS_InteractiveContext (aViewer);
 
-    Handle(MyAisObject) aPrs = new MyAisObject();
-    aPrs->SetAnimation (AIS_ViewController::ObjectsAnimation());
-    myContext->Display (aPrs, MyAisObject::MyDispMode_Main, 0, false);
+    myObject = new MyAisObject();
+    myObject->SetAnimation (AIS_ViewController::ObjectsAnimation());
+    myContext->Display (myObject, MyAisObject::MyDispMode_Main, 0, false);
+    if (theNbCloudPoints > 0)
+    {
+      // chunks are displayed incrementally by handleViewRedraw()
+      myCloud = new MyPointCloudObject (theNbCloudPoints, theRenderBudget);
+      myContext->Display (myCloud, 0, -1, false);
+    }
     myView->FitAll (0.01, false);
 
     aWindow->Map();
@@ -323,13 +1013,92 @@ public:
   //! Return view.
   const Handle(V3d_View)& View() const { return myView; }
 
+  //! Display a grid of boxes rotating back and forth and start their animation.
+  //! @param[in] theNbObjects  number of objects
+  //! @param[in] theToBatch    animate objects by a single MyBatchAnimation or by separate AIS_AnimationObject
+  //! @param[in] theIsParallel evaluate batched animation in parallel threads
+  void AddAnimatedObjects (int theNbObjects, bool theToBatch, bool theIsParallel);
+
 private:
+  //! Handle view redraw - stream pending point cloud chunks within per-frame budget.
+  virtual void handleViewRedraw (const Handle(AIS_InteractiveContext)& theCtx,
+                                 const Handle(V3d_View)& theView) override
+  {
+    bool toAskNextFrame = false;
+    if (!myCloud.IsNull())
+    {
+      if (myCloud->HasPendingChunks())
+      {
+        myCloud->StreamChunks (theCtx, myUploadBudget);
+        theView->Invalidate();
+        toAskNextFrame = true;
+      }
+      if (myCloud->UpdateLevelOfDetail (theCtx, theView))
+      {
+        toAskNextFrame = true;
+      }
+    }
+
+    OSD_Timer aRedrawTimer;
+    aRedrawTimer.Start();
+    AIS_ViewController::handleViewRedraw (theCtx, theView);
+    if (myNbAnimObjects > 0
+     && !ObjectsAnimation()->IsStopped())
+    {
+      reportAnimationFrame (aRedrawTimer.ElapsedTime());
+    }
+    if (toAskNextFrame)
+    {
+      theView->Window()->InvalidateContent (Handle(Aspect_DisplayConnection)());
+    }
+  }
+
+  //! Accumulate animation frame statistics and print them after every 100 frames.
+  void reportAnimationFrame (double theRedrawTime)
+  {
+    if (myNbAnimFrames == 0)
+    {
+      myAnimFrameTimer.Reset();
+      myAnimFrameTimer.Start();
+    }
+    ++myNbAnimFrames;
+    myAnimRedrawTime += theRedrawTime;
+    const Handle(MyBatchAnimation)& aBatch = myObject->BatchAnimation();
+    myAnimUpdateTime += !aBatch.IsNull() ? aBatch->UpdateTime() : 0.0;
+    if (myNbAnimFrames < 100)
+    {
+      return;
+    }
+
+    Message_Messenger::StreamBuffer aMsg = Message::SendInfo();
+    aMsg << "Animation: " << myNbAnimObjects << " objects"
+         << (aBatch.IsNull() ? " (separate animations)" : " (batched)")
+         << ", frame " << 1000.0 * myAnimFrameTimer.ElapsedTime() / myNbAnimFrames << " ms"
+         << ", update+redraw " << 1000.0 * myAnimRedrawTime / myNbAnimFrames << " ms";
+    if (!aBatch.IsNull())
+    {
+      aMsg << ", batch update " << 1000.0 * myAnimUpdateTime / myNbAnimFrames << " ms";
+    }
+    myNbAnimFrames = 0;
+    myAnimRedrawTime = 0.0;
+    myAnimUpdateTime = 0.0;
+  }
+
   //! Handle expose event.
   virtual void ProcessExpose() override
   {
     if (!myView.IsNull())
     {
+      MyHoverStats& aStats = MyHoverStats::Get();
+      const uint64_t aNbUpdatesBefore = aStats.NbUpdates;
+      const uint64_t aNbAllocsBefore  = MyHoverStats::NbHeapAllocs();
       FlushViewEvents (myContext, myView, true);
+      if (aStats.NbUpdates != aNbUpdatesBefore)
+      {
+        ++aStats.NbFrames;
+        aStats.NbFrameAllocs += MyHoverStats::NbHeapAllocs() - aNbAllocsBefore;
+        aStats.Report();
+      }
     }
   }
 
@@ -380,13 +1149,116 @@ private:
 
   Handle(AIS_InteractiveContext) myContext;
   Handle(V3d_View) myView;
+  Handle(MyAisObject) myObject;
+  Handle(MyPointCloudObject) myCloud;
+  int64_t myUploadBudget;
+  int       myNbAnimObjects;  //!< number of objects displayed by AddAnimatedObjects()
+  int       myNbAnimFrames;   //!< number of animation frames since last report
+  double    myAnimRedrawTime; //!< accumulated time of animation update and redraw
+  double    myAnimUpdateTime; //!< accumulated time of batched animation update
+  OSD_Timer myAnimFrameTimer; //!< timer since last report
 };
 
-int main()
+void MyViewer::AddAnimatedObjects (int theNbObjects, bool theToBatch, bool theIsParallel)
+{
+  const Handle(AIS_Animation)& aParentAnim = ObjectsAnimation();
+  aParentAnim->Clear();
+
+  Handle(MyBatchAnimation) aBatch;
+  if (theToBatch)
+  {
+    aBatch = new MyBatchAnimation (myContext);
+    aBatch->SetParallel (theIsParallel);
+    aParentAnim->Add (aBatch);
+  }
+  myObject->SetBatchAnimation (aBatch);
+
+  // boxes share the same shape (and triangulation), selection is not activated
+  const TopoDS_Shape aBox = BRepPrimAPI_MakeBox (gp_Pnt (-5.0, -5.0, -5.0), 10.0, 10.0, 10.0).Shape();
+  const int aNbX = (int )std::ceil (std::sqrt (double(theNbObjects)));
+  for (int anObjIter = 0; anObjIter < theNbObjects; ++anObjIter)
+  {
+    gp_Trsf aTrsfFrom, aRot;
+    aTrsfFrom.SetTranslation (gp_Vec (20.0 * (anObjIter % aNbX - 0.5 * aNbX), 20.0 * (anObjIter / aNbX - 0.5 * aNbX), -50.0));
+    aRot.SetRotation (gp_Ax1 (gp::Origin(), gp::DZ()), M_PI * 0.5);
+    const gp_Trsf aTrsfTo = aTrsfFrom * aRot;
+    const double aStartTime = 0.01 * (anObjIter % 100);
+
+    Handle(AIS_Shape) aShape = new AIS_Shape (aBox);
+    aShape->SetLocalTransformation (aTrsfFrom);
+    myContext->Display (aShape, AIS_Shaded, -1, false);
+    if (!aBatch.IsNull())
+    {
+      aBatch->AddObject (aShape, aTrsfFrom, aTrsfTo, aStartTime, 2.0, true);
+    }
+    else
+    {
+      // AIS_AnimationObject cannot loop, so that it plays a single longer rotation
+      Handle(AIS_AnimationObject) anAnim = new AIS_AnimationObject ("MyObjAnim", myContext, aShape, aTrsfFrom, aTrsfTo);
+      anAnim->SetStartPts (aStartTime);
+      anAnim->SetOwnDuration (10.0);
+      aParentAnim->Add (anAnim);
+    }
+  }
+  myNbAnimObjects = theNbObjects;
+
+  myView->FitAll (0.01, false);
+  aParentAnim->StartTimer (0.0, 1.0, true);
+}
+
+int main (int theNbArgs, char** theArgVec)
 {
   OSD::SetSignal (false);
 
-  MyViewer aViewer;
+  int64_t aNbPoints = 0, anUploadBudget = 2000000, aRenderBudget = 5000000;
+  int  aNbAnimObjects = 0;
+  bool toBatchAnim = true, isParallelAnim = true;
+  for (int anArgIter = 1; anArgIter < theNbArgs; ++anArgIter)
+  {
+    TCollection_AsciiString anArg (theArgVec[anArgIter]);
+    anArg.LowerCase();
+    if (anArg == "-points"
+     && anArgIter + 1 < theNbArgs)
+    {
+      aNbPoints = (int64_t )std::atof (theArgVec[++anArgIter]);
+    }
+    else if (anArg == "-upload"
+          && anArgIter + 1 < theNbArgs)
+    {
+      anUploadBudget = std::max ((int64_t )std::atof (theArgVec[++anArgIter]), int64_t(1));
+    }
+    else if (anArg == "-budget"
+          && anArgIter + 1 < theNbArgs)
+    {
+      aRenderBudget = (int64_t )std::atof (theArgVec[++anArgIter]);
+    }
+    else if (anArg == "-objects"
+          && anArgIter + 1 < theNbArgs)
+    {
+      aNbAnimObjects = std::max (std::atoi (theArgVec[++anArgIter]), 0);
+    }
+    else if (anArg == "-nobatch")
+    {
+      toBatchAnim = false;
+    }
+    else if (anArg == "-serial")
+    {
+      isParallelAnim = false;
+    }
+    else
+    {
+      Message::SendFail() << "Syntax error at '" << theArgVec[anArgIter] << "'\n"
+                          << "Usage: " << theArgVec[0] << " [-points N] [-upload N=2000000] [-budget N=5000000]"
+                          << " [-objects N] [-nobatch] [-serial]";
+      return 1;
+    }
+  }
+
+  MyViewer aViewer (aNbPoints, anUploadBudget, aRenderBudget);
+  if (aNbAnimObjects > 0)
+  {
+    aViewer.AddAnimatedObjects (aNbAnimObjects, toBatchAnim, isParallelAnim);
+  }
 #ifdef _WIN32
   // WinAPI message loop
   for (;;)
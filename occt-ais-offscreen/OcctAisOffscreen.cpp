@@ -2,14 +2,24 @@
   #include <windows.h>
 #endif
 
+#include "OcctImageRegression.hxx"
+#include "OcctModelCache.hxx"
+#include "OcctOffscreenPool.hxx"
+#include "OcctOffscreenViewer.hxx"
+#include "OcctProgressiveRenderer.hxx"
+#include "OcctRawFrameWriter.hxx"
+#include "OcctRenderServer.hxx"
+
 #include <AIS_InteractiveContext.hxx>
 #include <AIS_Shape.hxx>
 #include <BRepPrimAPI_MakeCone.hxx>
 #include <Geom_Circle.hxx>
 #include <Geom_Line.hxx>
 #include <Image_AlienPixMap.hxx>
-#include <OpenGl_GraphicDriver.hxx>
+#include <Message_PrinterOStream.hxx>
 #include <OSD.hxx>
+#include <OSD_Parallel.hxx>
+#include <OSD_Timer.hxx>
 #include <PrsDim_DiameterDimension.hxx>
 #include <PrsDim_LengthDimension.hxx>
 #include <TopExp.hxx>
@@ -18,110 +28,468 @@
 #include <V3d_View.hxx>
 #include <V3d_Viewer.hxx>
 
-#ifdef _WIN32
-  #include <WNT_WClass.hxx>
-  #include <WNT_Window.hxx>
-#elif defined(__APPLE__)
+#ifdef __APPLE__
   #include <Cocoa_LocalPool.hxx>
-  #include <Cocoa_Window.hxx>
-#else
-  #include <Xw_Window.hxx>
-  #include <X11/Xlib.h>
 #endif
 
-//! Sample offscreen viewer class.
-class OcctOffscreenViewer
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#ifdef __APPLE__
+void occtNSAppCreate(); // implemented in .mm file
+#endif
+
+//! Print messages into standard error instead of standard output.
+static void redirectMessagesToStderr()
+{
+  const Handle(Message_Messenger)& aMsgr = Message::DefaultMessenger();
+  aMsgr->RemovePrinters (STANDARD_TYPE(Message_PrinterOStream));
+  aMsgr->AddPrinter (new Message_PrinterOStream ("cerr", false));
+}
+
+//! Display sample scene - cone with dimensions.
+static void displaySampleScene (const Handle(AIS_InteractiveContext)& theCtx)
+{
+  const Handle(Prs3d_Drawer)& aDrawer = theCtx->DefaultDrawer();
+  aDrawer->ShadingAspect()->SetMaterial (Graphic3d_NameOfMaterial_Glass);
+  aDrawer->SetFaceBoundaryDraw (true);
+
+  TopoDS_Shape aShape = BRepPrimAPI_MakeCone (100, 10, 100).Solid();
+  Handle(AIS_InteractiveObject) aShapePrs = new AIS_Shape (aShape);
+  theCtx->Display (aShapePrs, AIS_Shaded, -1, false);
+
+  TopTools_IndexedMapOfShape anEdges;
+  TopExp::MapShapes (aShape, TopAbs_EDGE, anEdges);
+  for (TopTools_IndexedMapOfShape::Iterator anEdgeIter (anEdges); anEdgeIter.More(); anEdgeIter.Next())
+  {
+    const TopoDS_Edge& anEdge = TopoDS::Edge (anEdgeIter.Value());
+    Standard_Real aParRange[2] = {};
+    Handle(Geom_Curve) aCurve = BRep_Tool::Curve (anEdge, aParRange[0], aParRange[1]);
+    if (Handle(Geom_Circle) aCircle = Handle(Geom_Circle)::DownCast (aCurve))
+    {
+      Handle(PrsDim_DiameterDimension) aDiamDim = new PrsDim_DiameterDimension (anEdge);
+      aDiamDim->SetFlyout (aCircle->Radius() + 20.0);
+      theCtx->Display (aDiamDim, 0, -1, false);
+    }
+    else if (Handle(Geom_Line) aLine = Handle(Geom_Line)::DownCast (aCurve))
+    {
+      gp_Pln aPln (aLine->Value (aParRange[0]), gp::DY());
+      Handle(PrsDim_LengthDimension) aLenDim = new PrsDim_LengthDimension (anEdge, aPln);
+      aLenDim->SetFlyout (20.0);
+      theCtx->Display (aLenDim, 0, -1, false);
+    }
+  }
+}
+
+//! Render the same set of jobs by pools of 1 to N workers and report throughput scaling.
+//! @param[in] theMaxWorkers  maximum number of workers
+//! @param[in] theNbJobs      number of images to render by each pool
+//! @param[in] theModels      models to render in round-robin order
+//! @param[in] theCache       model cache
+//! @param[in] thePrsCacheSize number of presentations kept by each worker
+//! @param[in] theSize        image dimensions
+//! @param[in] theOutFolder   folder to save images, or empty string to keep images in memory
+static int runPoolScaling (int theMaxWorkers,
+                           int theNbJobs,
+                           const std::vector<TCollection_AsciiString>& theModels,
+                           OcctModelCache& theCache,
+                           int thePrsCacheSize,
+                           const Graphic3d_Vec2i& theSize,
+                           const TCollection_AsciiString& theOutFolder)
 {
-public:
-
-  //! Return view instance.
-  const Handle(V3d_View)& View() const { return myView; }
-
-  //! Return AIS context.
-  const Handle(AIS_InteractiveContext)& Context() const { return myContext; }
-
-  //! Initialize offscreen viewer.
-  //! @param[in] theWinSize view dimensions
-  //! @return FALSE in case of initialization error
-  bool InitOffscreenViewer (const Graphic3d_Vec2i& theWinSize)
-  {
-    try
-    {
-      OCC_CATCH_SIGNALS
-
-      // create graphic driver
-      Handle(Aspect_DisplayConnection) aDispConnection = new Aspect_DisplayConnection();
-      Handle(OpenGl_GraphicDriver) aDriver = new OpenGl_GraphicDriver (aDispConnection, true);
-      aDriver->ChangeOptions().ffpEnable    = false;
-      aDriver->ChangeOptions().swapInterval = 0;
-
-      // create viewer and AIS context
-      myViewer  = new V3d_Viewer (aDriver);
-      myContext = new AIS_InteractiveContext (myViewer);
-
-      // light sources setup
-      myViewer->SetDefaultLights();
-      myViewer->SetLightOn();
-
-      // create offscreen window
-      const TCollection_AsciiString aWinName ("OCCT offscreen window");
-    #ifdef __ANDROID__
-      Handle(Aspect_NeutralWindow) aWindow = new Aspect_NeutralWindow();
-      aWindow->SetSize (theWinSize.x(), theWinSize.y());
-    #elif defined(_WIN32)
-      const TCollection_AsciiString aClassName ("OffscreenClass");
-      Handle(WNT_WClass) aWinClass = new WNT_WClass (aClassName.ToCString(), NULL, 0); // empty callback!
-      Handle(WNT_Window) aWindow   = new WNT_Window (aWinName.ToCString(), aWinClass, 0x80000000L, //WS_POPUP,
-                                                     64, 64, 64, 64, Quantity_NOC_BLACK);
-      aWindow->SetVirtual (true);
-      aWindow->SetPos (0, 0, theWinSize.x(), theWinSize.y());
-    #elif defined(__APPLE__)
-      Handle(Cocoa_Window) aWindow = new Cocoa_Window (aWinName.ToCString(), 64, 64, theWinSize.x(), theWinSize.y());
-    #else
-      Handle(Xw_Window) aWindow = new Xw_Window (aDispConnection, aWinName.ToCString(),
-                                                 64, 64, theWinSize.x(), theWinSize.y());
-    #endif
-      aWindow->SetVirtual (true);
-
-      // create 3D view from offscreen window
-      myView = new V3d_View (myViewer);
-      myView->SetWindow (aWindow);
-    }
-    catch (const Standard_Failure& theErr)
-    {
-      Message::SendFail() << "Offscreen Viewer creation FAILED:\n" << theErr;
-      return false;
-    }
-    return true;
-  }
-
-  //! Print information about graphics context.
-  void DumpGlInfo()
-  {
-    TColStd_IndexedDataMapOfStringString aGlCapsDict;
-    myView->DiagnosticInformation (aGlCapsDict, Graphic3d_DiagnosticInfo_Basic);
-    TCollection_AsciiString anInfo = "OpenGL info:\n";
-    for (TColStd_IndexedDataMapOfStringString::Iterator aValueIter (aGlCapsDict); aValueIter.More(); aValueIter.Next())
-    {
-      if (!aValueIter.Value().IsEmpty())
+  OcctOffscreenPool::InitThreads();
+
+  // models are loaded and meshed in advance to measure rendering only
+  std::vector<TopoDS_Shape> aShapes;
+  std::vector<TCollection_AsciiString> aKeys;
+  OSD_Timer aLoadTimer;
+  aLoadTimer.Start();
+  for (int aJobIter = 0; aJobIter < theNbJobs; ++aJobIter)
+  {
+    TCollection_AsciiString aKey, anError;
+    TopoDS_Shape aShape;
+    if (!theCache.Find (theModels[aJobIter % theModels.size()], aKey, aShape, anError))
+    {
+      Message::SendFail() << "Error: " << anError;
+      return 1;
+    }
+    aShapes.push_back (aShape);
+    aKeys.push_back (aKey);
+  }
+  Message::SendInfo() << "Loaded models for " << theNbJobs << " jobs in " << aLoadTimer.ElapsedTime() << " s";
+  theCache.DumpStats();
+
+  std::vector<int> aNbWorkersList;
+  for (int aNbWorkers = 1; aNbWorkers < theMaxWorkers; aNbWorkers *= 2)
+  {
+    aNbWorkersList.push_back (aNbWorkers);
+  }
+  aNbWorkersList.push_back (theMaxWorkers);
+
+  const V3d_TypeOfOrientation anOrients[4] = { V3d_TypeOfOrientation_Zup_AxoRight, V3d_TypeOfOrientation_Zup_AxoLeft,
+                                               V3d_TypeOfOrientation_Zup_Front,    V3d_TypeOfOrientation_Zup_Top };
+  double aBaseRate = 0.0;
+  for (int aNbWorkers : aNbWorkersList)
+  {
+    OcctOffscreenPool aPool;
+    aPool.SetPrsCacheSize (thePrsCacheSize);
+    OSD_Timer aStartTimer;
+    aStartTimer.Start();
+    if (!aPool.Start (aNbWorkers))
+    {
+      Message::SendFail() << "Error: unable to start pool of " << aNbWorkers << " offscreen viewers";
+      return 1;
+    }
+    aStartTimer.Stop();
+    if (aBaseRate == 0.0)
+    {
+      Message::SendInfo() << "Renderer: " << aPool.GlRenderer();
+    }
+
+    OSD_Timer aTimer;
+    aTimer.Start();
+    std::vector<std::future<OcctRenderResult>> aResults;
+    for (int aJobIter = 0; aJobIter < theNbJobs; ++aJobIter)
+    {
+      OcctRenderJob aJob;
+      aJob.Shape = aShapes[aJobIter];
+      aJob.ModelKey = aKeys[aJobIter];
+      aJob.Size  = theSize;
+      aJob.Orientation = anOrients[aJobIter % 4];
+      if (!theOutFolder.IsEmpty())
       {
-        anInfo += TCollection_AsciiString("  ") + aValueIter.Key() + ": " + aValueIter.Value() + "\n";
+        aJob.OutputPath = theOutFolder + "/thumb_" + aJobIter + ".png";
       }
+      aResults.push_back (aPool.Submit (aJob));
     }
-    Message::SendInfo (anInfo);
-  }
 
-private:
+    int aNbFailed = 0, aNbPrsHits = 0;
+    for (std::future<OcctRenderResult>& aResult : aResults)
+    {
+      const OcctRenderResult aRes = aResult.get();
+      if (!aRes.IsDone)     { ++aNbFailed; }
+      if (aRes.IsPrsCached) { ++aNbPrsHits; }
+    }
+    aTimer.Stop();
+
+    const double aRate = theNbJobs / aTimer.ElapsedTime();
+    aBaseRate = aBaseRate == 0.0 ? aRate : aBaseRate;
+    Message::SendInfo() << "Workers " << aNbWorkers << ": startup " << aStartTimer.ElapsedTime() << " s, "
+                        << theNbJobs << " images " << theSize.x() << "x" << theSize.y() << " in " << aTimer.ElapsedTime() << " s, "
+                        << aRate << " images/s, speedup " << aRate / aBaseRate << ", reused presentations " << aNbPrsHits
+                        << (aNbFailed != 0 ? TCollection_AsciiString (", FAILED ") + aNbFailed : TCollection_AsciiString());
+    if (aNbFailed != 0)
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
 
-  Handle(V3d_Viewer) myViewer;
-  Handle(V3d_View)   myView;
-  Handle(AIS_InteractiveContext) myContext;
+//! Frame rate statistics of rendering into PNG or raw output.
+struct MyFrameStats
+{
+  double Fps;          //!< frames per second including output, or 0 in case of error
+  double ReadbackTime; //!< mean time of rendering and read-back of a frame in seconds
+  double OutputTime;   //!< mean time of encoding and writing of a frame in seconds
 
+  MyFrameStats() : Fps (0.0), ReadbackTime (0.0), OutputTime (0.0) {}
 };
 
-#ifdef __APPLE__
-void occtNSAppCreate(); // implemented in .mm file
+//! Render frames of sample scene orbiting around and read them back.
+//! @param[in] theViewer   offscreen viewer with displayed scene
+//! @param[in] theFormat   "png" or raw frame format
+//! @param[in] theSize     frame dimensions
+//! @param[in] theNbFrames number of frames
+//! @param[in] theTarget   PNG file path or raw output target; empty string to skip output
+//! @return frame rate statistics (zero frame rate in case of error)
+static MyFrameStats renderFrames (OcctOffscreenViewer& theViewer,
+                            const TCollection_AsciiString& theFormat,
+                            const Graphic3d_Vec2i& theSize,
+                            int theNbFrames,
+                            const TCollection_AsciiString& theTarget)
+{
+  const Handle(V3d_View)& aView = theViewer.View();
+  const bool isPng = theFormat == "png";
+  OcctRawFrameFormat aRawFormat = OcctRawFrameFormat_RGBA;
+  if (!isPng
+   && !OcctRawFrameWriter::FormatFromString (theFormat, aRawFormat))
+  {
+    Message::SendFail() << "Error: unknown frame format '" << theFormat << "'";
+    return MyFrameStats();
+  }
+
+  OcctRawFrameWriter aWriter;
+  if (!isPng
+   && !theTarget.IsEmpty()
+   && !aWriter.Open (theTarget, aRawFormat, theSize))
+  {
+    return MyFrameStats();
+  }
+
+  // raw frames are read back into preallocated image keeping bottom-up row order of OpenGL,
+  // so that neither rows flipping nor pixel format conversion is performed
+  Image_AlienPixMap aPngImage;
+  Image_PixMap aRawImage;
+  aRawImage.SetTopDown (false);
+  if (!isPng
+   && !aRawImage.InitZero (OcctRawFrameWriter::ImageFormat (aRawFormat), theSize.x(), theSize.y()))
+  {
+    Message::SendFail() << "Error: unable to allocate frame " << theSize.x() << "x" << theSize.y();
+    return MyFrameStats();
+  }
+  Image_PixMap& anImage = isPng ? (Image_PixMap& )aPngImage : aRawImage;
+
+  V3d_ImageDumpOptions aDumpParams;
+  aDumpParams.Width  = theSize.x();
+  aDumpParams.Height = theSize.y();
+  aDumpParams.BufferType = isPng ? Graphic3d_BT_RGB : OcctRawFrameWriter::BufferType (aRawFormat);
+  aDumpParams.ToAdjustAspect = true;
+
+  // keep the same offscreen framebuffer instead of creating a new one by each dump
+  Handle(Standard_Transient) aFbo = aView->View()->FBOCreate (theSize.x(), theSize.y());
+  aView->View()->SetFBO (aFbo);
+
+  const Handle(Graphic3d_Camera)& aCam = aView->Camera();
+  gp_Trsf anOrbit;
+  anOrbit.SetRotation (gp_Ax1 (aCam->Center(), gp::DZ()), 2.0 * M_PI / theNbFrames);
+
+  // read-back and output are timed separately, as PNG output includes encoding while raw output is a plain copy
+  bool isDone = true;
+  OSD_Timer aTimer, aReadbackTimer, anOutputTimer;
+  aTimer.Start();
+  for (int aFrameIter = 0; aFrameIter < theNbFrames && isDone; ++aFrameIter)
+  {
+    aCam->Transform (anOrbit);
+    aReadbackTimer.Start();
+    const bool isDumped = aView->ToPixMap (anImage, aDumpParams);
+    aReadbackTimer.Stop();
+    if (!isDumped)
+    {
+      Message::SendFail() << "View dump FAILED";
+      isDone = false;
+      continue;
+    }
+    if (theTarget.IsEmpty())
+    {
+      continue;
+    }
+
+    anOutputTimer.Start();
+    isDone = isPng
+           ? aPngImage.Save (theTarget)
+           : aWriter.Write (aRawImage);
+    anOutputTimer.Stop();
+  }
+  aTimer.Stop();
+
+  aView->View()->SetFBO (Handle(Standard_Transient)());
+  aView->View()->FBORelease (aFbo);
+  aWriter.Close();
+
+  MyFrameStats aStats;
+  if (isDone)
+  {
+    aStats.Fps = theNbFrames / aTimer.ElapsedTime();
+    aStats.ReadbackTime = aReadbackTimer.ElapsedTime() / theNbFrames;
+    aStats.OutputTime   = anOutputTimer .ElapsedTime() / theNbFrames;
+  }
+  return aStats;
+}
+
+//! Render frames into PNG or raw output, or compare frame rates of output formats.
+//! @param[in] theTarget   PNG file path or raw output target
+//! @param[in] theFormat   "png" or raw frame format
+//! @param[in] theSize     frame dimensions
+//! @param[in] theNbFrames number of frames
+//! @param[in] theToBench  compare PNG and raw formats at 1080p and 4K instead of rendering into target
+static int runFrames (const TCollection_AsciiString& theTarget,
+                      const TCollection_AsciiString& theFormat,
+                      const Graphic3d_Vec2i& theSize,
+                      int theNbFrames,
+                      bool theToBench)
+{
+  if (theTarget == "-")
+  {
+    // standard output is reserved for frames
+    redirectMessagesToStderr();
+  }
+
+  OcctOffscreenViewer aViewer;
+  if (!aViewer.InitOffscreenViewer (Graphic3d_Vec2i (64, 64)))
+  {
+    return 1;
+  }
+  aViewer.View()->SetBackgroundColor (Quantity_NOC_BLACK);
+  displaySampleScene (aViewer.Context());
+  aViewer.View()->SetProj (V3d_TypeOfOrientation_Zup_AxoRight);
+  aViewer.View()->FitAll (0.01, false);
+  Message::SendInfo() << "Renderer: " << aViewer.GlRenderer();
+
+  if (!theToBench)
+  {
+    const MyFrameStats aStats = renderFrames (aViewer, theFormat, theSize, theNbFrames, theTarget);
+    if (aStats.Fps <= 0.0)
+    {
+      return 1;
+    }
+    Message::SendInfo() << theNbFrames << " frames " << theSize.x() << "x" << theSize.y() << "@" << theFormat << ": " << aStats.Fps << " FPS"
+                        << " (read-back " << aStats.ReadbackTime * 1000.0 << " ms, output " << aStats.OutputTime * 1000.0 << " ms per frame)";
+    return 0;
+  }
+
+  // every format writes each frame somewhere: PNG is encoded into a file,
+  // and raw frames are written into specified target or discarded by null device
+#ifdef _WIN32
+  const TCollection_AsciiString aRawTarget = !theTarget.IsEmpty() ? theTarget : TCollection_AsciiString ("NUL");
+#else
+  const TCollection_AsciiString aRawTarget = !theTarget.IsEmpty() ? theTarget : TCollection_AsciiString ("/dev/null");
 #endif
+  const Graphic3d_Vec2i aSizes[2] = { Graphic3d_Vec2i (1920, 1080), Graphic3d_Vec2i (3840, 2160) };
+  const char* aFormats[4] = { "png", "rgba", "rgb", "depth" };
+  for (const Graphic3d_Vec2i& aSize : aSizes)
+  {
+    for (const char* aFormat : aFormats)
+    {
+      const TCollection_AsciiString aFormatName (aFormat);
+      const MyFrameStats aStats = renderFrames (aViewer, aFormatName, aSize, theNbFrames,
+                                                aFormatName == "png" ? TCollection_AsciiString ("bench.png") : aRawTarget);
+      if (aStats.Fps <= 0.0)
+      {
+        return 1;
+      }
+      Message::SendInfo() << aSize.x() << "x" << aSize.y() << "@" << aFormatName << ": " << aStats.Fps << " FPS"
+                          << " (read-back " << aStats.ReadbackTime * 1000.0 << " ms, output " << aStats.OutputTime * 1000.0 << " ms per frame)";
+    }
+  }
+  return 0;
+}
+
+//! Render still image of sample scene by progressive path tracing.
+//! @param[in] theRenderer configured progressive renderer
+//! @param[in] theSize     image dimensions
+//! @param[in] theOutPath  image file path
+static int runPathTrace (OcctProgressiveRenderer& theRenderer,
+                         const Graphic3d_Vec2i& theSize,
+                         const TCollection_AsciiString& theOutPath)
+{
+  // view has the same dimensions as image to keep camera aspect between samples
+  OcctOffscreenViewer aViewer;
+  if (!aViewer.InitOffscreenViewer (theSize))
+  {
+    return 1;
+  }
+  aViewer.View()->SetBackgroundColor (Quantity_NOC_BLACK);
+  displaySampleScene (aViewer.Context());
+  aViewer.View()->SetProj (V3d_TypeOfOrientation_Zup_AxoRight);
+  aViewer.View()->FitAll (0.01, false);
+  Message::SendInfo() << "Renderer: " << aViewer.GlRenderer();
+
+  if (!theRenderer.Perform (aViewer.View(), theSize, theOutPath))
+  {
+    return 1;
+  }
+  theRenderer.DumpStats (theSize);
+  return 0;
+}
+
+//! Render set of scenes with different camera orientations and anti-aliasing modes and compare images with references.
+//! @param[in] theRegression regression checker
+//! @param[in] theSize       image dimensions
+static int runRegression (OcctImageRegression& theRegression,
+                          const Graphic3d_Vec2i& theSize)
+{
+  OcctOffscreenViewer aViewer;
+  if (!aViewer.InitOffscreenViewer (theSize))
+  {
+    return 1;
+  }
+  const Handle(V3d_View)& aView = aViewer.View();
+  aView->SetBackgroundColor (Quantity_NOC_BLACK);
+  Message::SendInfo() << "Renderer: " << aViewer.GlRenderer();
+
+  const char* aSceneNames[4] = { "cone", "box", "sphere", "torus" };
+  const char* anOrientNames[3] = { "axo", "front", "top" };
+  const V3d_TypeOfOrientation anOrients[3] = { V3d_TypeOfOrientation_Zup_AxoRight, V3d_TypeOfOrientation_Zup_Front,
+                                               V3d_TypeOfOrientation_Zup_Top };
+  const char* aModeNames[3] = { "noaa", "msaa4", "ssaa2" };
+  Image_AlienPixMap anImage;
+  for (int aSceneIter = 0; aSceneIter < 4; ++aSceneIter)
+  {
+    aViewer.Context()->RemoveAll (false);
+    if (aSceneIter == 0)
+    {
+      displaySampleScene (aViewer.Context());
+    }
+    else
+    {
+      aViewer.Context()->Display (new AIS_Shape (OcctModelCache::MakeSampleShape (aSceneIter)), AIS_Shaded, -1, false);
+    }
+
+    for (int anOrientIter = 0; anOrientIter < 3; ++anOrientIter)
+    {
+      aView->SetProj (anOrients[anOrientIter]);
+      aView->FitAll (0.01, false);
+      for (int aModeIter = 0; aModeIter < 3; ++aModeIter)
+      {
+        Graphic3d_RenderingParams& aParams = aView->ChangeRenderingParams();
+        aParams.NbMsaaSamples = aModeIter == 1 ? 4 : 0;
+        aParams.RenderResolutionScale = aModeIter == 2 ? 2.0f : 1.0f;
+
+        OSD_Timer aTimer;
+        aTimer.Start();
+        if (!aView->ToPixMap (anImage, theSize.x(), theSize.y()))
+        {
+          Message::SendFail() << "View dump FAILED";
+          return 1;
+        }
+        aTimer.Stop();
+
+        const TCollection_AsciiString aName = TCollection_AsciiString (aSceneNames[aSceneIter]) + "_"
+                                            + anOrientNames[anOrientIter] + "_" + aModeNames[aModeIter];
+        theRegression.Check (aName, anImage, aTimer.ElapsedTime());
+      }
+    }
+  }
+
+  theRegression.DumpStats();
+  if (!theRegression.SaveReport())
+  {
+    return 1;
+  }
+  return theRegression.NbFailed() == 0 ? 0 : 1;
+}
+
+//! Run render server keeping offscreen viewers warm between requests.
+//! @param[in] theNbWorkers number of offscreen viewers
+//! @param[in] theEndpoint  "stdio" or Unix socket path
+//! @param[in] theCacheBudget  memory budget of model cache in bytes
+//! @param[in] thePrsCacheSize number of presentations kept by each worker
+static int runServer (int theNbWorkers,
+                      const TCollection_AsciiString& theEndpoint,
+                      size_t theCacheBudget,
+                      int thePrsCacheSize)
+{
+  const bool isStdio = theEndpoint == "stdio";
+  if (isStdio)
+  {
+    // standard output is reserved for replies
+    redirectMessagesToStderr();
+  }
+
+  OcctOffscreenPool::InitThreads();
+  OcctRenderServer aServer (theCacheBudget, thePrsCacheSize);
+  OSD_Timer aTimer;
+  aTimer.Start();
+  if (!aServer.Start (theNbWorkers))
+  {
+    Message::SendFail() << "Error: unable to start pool of " << theNbWorkers << " offscreen viewers";
+    return 1;
+  }
+  Message::SendInfo() << "Started " << theNbWorkers << " offscreen viewers in " << aTimer.ElapsedTime() << " s, renderer: " << aServer.GlRenderer();
+  return isStdio ? aServer.ServeStdio() : aServer.ServeSocket (theEndpoint);
+}
 
 int main(int argc, const char** argv)
 {
@@ -131,6 +499,188 @@ int main(int argc, const char** argv)
   occtNSAppCreate();
 #endif
 
+  int aNbPoolWorkers = 0, aNbPoolJobs = 256;
+  Graphic3d_Vec2i aPoolImageSize (256, 256);
+  TCollection_AsciiString aPoolOutFolder, aServeEndpoint, aClientSocket;
+  std::vector<TCollection_AsciiString> aModels;
+  int aNbClients = 8, aNbClientRequests = 50, aPrsCacheSize = 8;
+  size_t aCacheBudget = size_t(512) * 1024 * 1024;
+  TCollection_AsciiString aFrameTarget, aFrameFormat ("rgba");
+  int aNbFrames = 120;
+  bool toOpenImage = true, hasSize = false, toBenchFrames = false;
+  TCollection_AsciiString aPathTraceOut, aCompareFolder;
+  double aCompareTolerance = 0.05, aCompareMaxDiff = 0.0005;
+  bool toUpdateRefs = false;
+  OcctProgressiveRenderer aPathTracer;
+  for (int anArgIter = 1; anArgIter < argc; ++anArgIter)
+  {
+    TCollection_AsciiString anArg (argv[anArgIter]);
+    anArg.LowerCase();
+    const bool hasNext = anArgIter + 1 < argc;
+    if (anArg == "-noopen")
+    {
+      toOpenImage = false;
+    }
+    else if (anArg == "-pool" && hasNext)
+    {
+      aNbPoolWorkers = std::atoi (argv[++anArgIter]);
+      if (aNbPoolWorkers <= 0) { aNbPoolWorkers = OSD_Parallel::NbLogicalProcessors(); }
+    }
+    else if (anArg == "-jobs" && hasNext)
+    {
+      aNbPoolJobs = std::max (1, std::atoi (argv[++anArgIter]));
+    }
+    else if (anArg == "-size" && hasNext)
+    {
+      TCollection_AsciiString aSize (argv[++anArgIter]);
+      aPoolImageSize.SetValues (aSize.Token ("x", 1).IntegerValue(), aSize.Token ("x", 2).IntegerValue());
+      if (aPoolImageSize.x() <= 0 || aPoolImageSize.y() <= 0)
+      {
+        Message::SendFail() << "Syntax error: invalid image size '" << aSize << "'";
+        return 1;
+      }
+      hasSize = true;
+    }
+    else if (anArg == "-raw" && hasNext)
+    {
+      aFrameTarget = argv[++anArgIter];
+    }
+    else if (anArg == "-format" && hasNext)
+    {
+      aFrameFormat = argv[++anArgIter];
+      aFrameFormat.LowerCase();
+    }
+    else if (anArg == "-frames" && hasNext)
+    {
+      aNbFrames = std::max (1, std::atoi (argv[++anArgIter]));
+    }
+    else if (anArg == "-rawbench")
+    {
+      toBenchFrames = true;
+    }
+    else if (anArg == "-pathtrace" && hasNext)
+    {
+      aPathTraceOut = argv[++anArgIter];
+    }
+    else if (anArg == "-spp" && hasNext)
+    {
+      aPathTracer.SetMaxSamples (std::max (1, std::atoi (argv[++anArgIter])));
+    }
+    else if (anArg == "-budget" && hasNext)
+    {
+      aPathTracer.SetTimeBudget (std::max (0.0, std::atof (argv[++anArgIter])));
+    }
+    else if (anArg == "-noise" && hasNext)
+    {
+      aPathTracer.SetNoiseThreshold (std::max (0.0, std::atof (argv[++anArgIter])));
+    }
+    else if (anArg == "-checkpoints" && hasNext)
+    {
+      aPathTracer.SetCheckpointPrefix (argv[++anArgIter]);
+    }
+    else if (anArg == "-compare" && hasNext)
+    {
+      aCompareFolder = argv[++anArgIter];
+    }
+    else if (anArg == "-update")
+    {
+      toUpdateRefs = true;
+    }
+    else if (anArg == "-tolerance" && hasNext)
+    {
+      aCompareTolerance = std::max (0.0, std::atof (argv[++anArgIter]));
+    }
+    else if (anArg == "-maxdiff" && hasNext)
+    {
+      aCompareMaxDiff = std::max (0.0, std::atof (argv[++anArgIter]));
+    }
+    else if (anArg == "-out" && hasNext)
+    {
+      aPoolOutFolder = argv[++anArgIter];
+    }
+    else if (anArg == "-serve" && hasNext)
+    {
+      aServeEndpoint = argv[++anArgIter];
+    }
+    else if (anArg == "-client" && hasNext)
+    {
+      aClientSocket = argv[++anArgIter];
+    }
+    else if (anArg == "-clients" && hasNext)
+    {
+      aNbClients = std::max (1, std::atoi (argv[++anArgIter]));
+    }
+    else if (anArg == "-requests" && hasNext)
+    {
+      aNbClientRequests = std::max (1, std::atoi (argv[++anArgIter]));
+    }
+    else if (anArg == "-model" && hasNext)
+    {
+      aModels.push_back (argv[++anArgIter]);
+    }
+    else if (anArg == "-cache" && hasNext)
+    {
+      aCacheBudget = size_t(std::max (1, std::atoi (argv[++anArgIter]))) * 1024 * 1024;
+    }
+    else if (anArg == "-prscache" && hasNext)
+    {
+      aPrsCacheSize = std::max (0, std::atoi (argv[++anArgIter]));
+    }
+    else
+    {
+      Message::SendFail() << "Syntax error at '" << argv[anArgIter] << "'\n"
+                          << "Usage: " << argv[0] << " [-noopen] [-pool N [-jobs N=256] [-model name]... [-size WxH=256x256] [-out folder]]\n"
+                          << "       " << argv[0] << " -serve {stdio|socketPath} [-pool N]\n"
+                          << "       " << argv[0] << " -client socketPath [-clients N=8] [-requests N=50] [-model name=sample:0] [-size WxH=256x256]\n"
+                          << "       " << argv[0] << " -raw {file|-|shm:/name} [-format {rgba|rgb|depth|png}=rgba] [-frames N=120] [-size WxH=1920x1080]\n"
+                          << "       " << argv[0] << " -rawbench [-raw {file|-|shm:/name}] [-frames N=120]\n"
+                          << "       " << argv[0] << " -pathtrace image.png [-spp N=1024] [-budget seconds=0] [-noise threshold=0.005] [-checkpoints prefix] [-size WxH=1920x1080]\n"
+                          << "       " << argv[0] << " -compare refFolder [-out folder=.] [-update] [-tolerance 0.05] [-maxdiff 0.0005] [-size WxH=640x480]\n"
+                          << "Model cache options: [-cache MiB=512] [-prscache N=8]";
+      return 1;
+    }
+  }
+
+  if (!aCompareFolder.IsEmpty())
+  {
+    OcctImageRegression aRegression (aCompareFolder, !aPoolOutFolder.IsEmpty() ? aPoolOutFolder : TCollection_AsciiString ("."));
+    aRegression.SetColorTolerance (aCompareTolerance);
+    aRegression.SetMaxDiffRatio (aCompareMaxDiff);
+    aRegression.SetToUpdate (toUpdateRefs);
+    return runRegression (aRegression, hasSize ? aPoolImageSize : Graphic3d_Vec2i (640, 480));
+  }
+  if (!aPathTraceOut.IsEmpty())
+  {
+    return runPathTrace (aPathTracer, hasSize ? aPoolImageSize : Graphic3d_Vec2i (1920, 1080), aPathTraceOut);
+  }
+  if (toBenchFrames
+  || !aFrameTarget.IsEmpty())
+  {
+    return runFrames (aFrameTarget, aFrameFormat, hasSize ? aPoolImageSize : Graphic3d_Vec2i (1920, 1080), aNbFrames, toBenchFrames);
+  }
+  if (!aClientSocket.IsEmpty())
+  {
+    return OcctRenderServer::RunClient (aClientSocket, aNbClients, aNbClientRequests,
+                                        !aModels.empty() ? aModels.front() : TCollection_AsciiString ("sample:0"), aPoolImageSize);
+  }
+  if (!aServeEndpoint.IsEmpty())
+  {
+    return runServer (aNbPoolWorkers > 0 ? aNbPoolWorkers : OSD_Parallel::NbLogicalProcessors(), aServeEndpoint,
+                      aCacheBudget, aPrsCacheSize);
+  }
+  if (aNbPoolWorkers > 0)
+  {
+    if (aModels.empty())
+    {
+      for (int aSampleIter = 0; aSampleIter < 28; ++aSampleIter)
+      {
+        aModels.push_back (TCollection_AsciiString ("sample:") + aSampleIter);
+      }
+    }
+    OcctModelCache aCache (aCacheBudget);
+    return runPoolScaling (aNbPoolWorkers, aNbPoolJobs, aModels, aCache, aPrsCacheSize, aPoolImageSize, aPoolOutFolder);
+  }
+
   // image dimensions
   Graphic3d_Vec2i aWinSize (1920, 1080);
   double aScaleRatio = 2.0;
@@ -153,38 +703,7 @@ int main(int argc, const char** argv)
   // display something
   aView->SetBackgroundColor (Quantity_NOC_BLACK);
   aView->TriedronDisplay (Aspect_TOTP_LEFT_LOWER, Quantity_NOC_WHITE, aScaleRatio * 0.1);
-  {
-    const Handle(AIS_InteractiveContext)& aCtx = aViewer.Context();
-    const Handle(Prs3d_Drawer)& aDrawer = aCtx->DefaultDrawer();
-    aDrawer->ShadingAspect()->SetMaterial (Graphic3d_NameOfMaterial_Glass);
-    aDrawer->SetFaceBoundaryDraw (true);
-
-    TopoDS_Shape aShape = BRepPrimAPI_MakeCone (100, 10, 100).Solid();
-    Handle(AIS_InteractiveObject) aShapePrs = new AIS_Shape (aShape);
-    aCtx->Display (aShapePrs, AIS_Shaded, -1, false);
-
-    TopTools_IndexedMapOfShape anEdges;
-    TopExp::MapShapes (aShape, TopAbs_EDGE, anEdges);
-    for (TopTools_IndexedMapOfShape::Iterator anEdgeIter (anEdges); anEdgeIter.More(); anEdgeIter.Next())
-    {
-      const TopoDS_Edge& anEdge = TopoDS::Edge (anEdgeIter.Value());
-      Standard_Real aParRange[2] = {};
-      Handle(Geom_Curve) aCurve = BRep_Tool::Curve (anEdge, aParRange[0], aParRange[1]);
-      if (Handle(Geom_Circle) aCircle = Handle(Geom_Circle)::DownCast (aCurve))
-      {
-        Handle(PrsDim_DiameterDimension) aDiamDim = new PrsDim_DiameterDimension (anEdge);
-        aDiamDim->SetFlyout (aCircle->Radius() + 20.0);
-        aCtx->Display (aDiamDim, 0, -1, false);
-      }
-      else if (Handle(Geom_Line) aLine = Handle(Geom_Line)::DownCast (aCurve))
-      {
-        gp_Pln aPln (aLine->Value (aParRange[0]), gp::DY());
-        Handle(PrsDim_LengthDimension) aLenDim = new PrsDim_LengthDimension (anEdge, aPln);
-        aLenDim->SetFlyout (20.0);
-        aCtx->Display (aLenDim, 0, -1, false);
-      }
-    }
-  }
+  displaySampleScene (aViewer.Context());
 
   // setup camera orientation
   aView->SetProj (V3d_TypeOfOrientation_Zup_AxoRight);
@@ -210,12 +729,9 @@ int main(int argc, const char** argv)
                       << " saved into file '" << anImageName << "'";
 
   // use default application to open image
-  for (int anArgIter = 1; anArgIter < argc; ++anArgIter)
+  if (!toOpenImage)
   {
-    if (TCollection_AsciiString::IsSameString (argv[anArgIter], "-noopen", false))
-    {
-      return 0;
-    }
+    return 0;
   }
 #if defined(_WIN32)
   ShellExecuteW(NULL, L"open", TCollection_ExtendedString(anImageName).ToWideString(), NULL, NULL, SW_SHOWNORMAL);
@@ -0,0 +1,195 @@
+#include "OcctImageRegression.hxx"
+
+#include <Image_Diff.hxx>
+#include <Message.hxx>
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+namespace
+{
+  //! Return status name.
+  static const char* statusName (OcctRegressionStatus theStatus)
+  {
+    switch (theStatus)
+    {
+      case OcctRegressionStatus_Passed:  return "passed";
+      case OcctRegressionStatus_Failed:  return "failed";
+      case OcctRegressionStatus_Missing: return "missing";
+      case OcctRegressionStatus_Updated: return "updated";
+      case OcctRegressionStatus_Error:   return "error";
+    }
+    return "error";
+  }
+
+  //! Compute peak signal-to-noise ratio of RGB components of two images of the same dimensions.
+  static double computePsnr (const Image_PixMap& theImage1,
+                             const Image_PixMap& theImage2)
+  {
+    double aSum = 0.0;
+    for (size_t aRowIter = 0; aRowIter < theImage1.SizeY(); ++aRowIter)
+    {
+      for (size_t aColIter = 0; aColIter < theImage1.SizeX(); ++aColIter)
+      {
+        const Quantity_Color aColor1 = theImage1.PixelColor ((int )aColIter, (int )aRowIter).GetRGB();
+        const Quantity_Color aColor2 = theImage2.PixelColor ((int )aColIter, (int )aRowIter).GetRGB();
+        const double aDiffR = aColor1.Red()   - aColor2.Red();
+        const double aDiffG = aColor1.Green() - aColor2.Green();
+        const double aDiffB = aColor1.Blue()  - aColor2.Blue();
+        aSum += aDiffR * aDiffR + aDiffG * aDiffG + aDiffB * aDiffB;
+      }
+    }
+    const double aMse = aSum / (3.0 * double(theImage1.SizeX() * theImage1.SizeY()));
+    return aMse > 0.0 ? 10.0 * std::log10 (1.0 / aMse) : std::numeric_limits<double>::infinity();
+  }
+}
+
+// Main constructor.
+OcctImageRegression::OcctImageRegression (const TCollection_AsciiString& theRefFolder,
+                                          const TCollection_AsciiString& theOutFolder)
+: myRefFolder (theRefFolder),
+  myOutFolder (theOutFolder),
+  myColorTolerance (0.05),
+  myMaxDiffRatio (0.0005),
+  myToUpdate (false)
+{
+  //
+}
+
+// Return number of failed cases.
+int OcctImageRegression::NbFailed() const
+{
+  int aNbFailed = 0;
+  for (const OcctRegressionCase& aCase : myCases)
+  {
+    if (aCase.Status == OcctRegressionStatus_Failed
+     || aCase.Status == OcctRegressionStatus_Missing
+     || aCase.Status == OcctRegressionStatus_Error)
+    {
+      ++aNbFailed;
+    }
+  }
+  return aNbFailed;
+}
+
+// Save rendered image of the case and compare it with reference.
+bool OcctImageRegression::Check (const TCollection_AsciiString& theName,
+                                 Image_AlienPixMap& theImage,
+                                 double theRenderTime)
+{
+  myCases.push_back (OcctRegressionCase());
+  OcctRegressionCase& aCase = myCases.back();
+  aCase.Name = theName;
+  aCase.RenderTime = theRenderTime;
+
+  const TCollection_AsciiString aRefPath = myRefFolder + "/" + theName + ".png";
+  const TCollection_AsciiString anOutPath = myOutFolder + "/" + theName + ".png";
+  if (!theImage.Save (anOutPath))
+  {
+    Message::SendFail() << "Error: unable to save image '" << anOutPath << "'";
+    return false;
+  }
+  if (myToUpdate)
+  {
+    aCase.Status = theImage.Save (aRefPath) ? OcctRegressionStatus_Updated : OcctRegressionStatus_Error;
+    return aCase.Status == OcctRegressionStatus_Updated;
+  }
+  if (!std::ifstream (aRefPath.ToCString()).good())
+  {
+    Message::SendFail() << "Error: reference image '" << aRefPath << "' does not exist";
+    aCase.Status = OcctRegressionStatus_Missing;
+    return false;
+  }
+
+  // both images are read by the same loader to get the same pixel format
+  Handle(Image_AlienPixMap) aRefImage = new Image_AlienPixMap(), aNewImage = new Image_AlienPixMap();
+  if (!aRefImage->Load (aRefPath)
+   || !aNewImage->Load (anOutPath))
+  {
+    return false;
+  }
+  if (aRefImage->SizeX() != aNewImage->SizeX()
+   || aRefImage->SizeY() != aNewImage->SizeY())
+  {
+    Message::SendFail() << "Error: image '" << theName << "' has dimensions " << (int )aNewImage->SizeX() << "x" << (int )aNewImage->SizeY()
+                        << " different from reference " << (int )aRefImage->SizeX() << "x" << (int )aRefImage->SizeY();
+    aCase.Status = OcctRegressionStatus_Failed;
+    aCase.NbDiffPixels = (int )(aNewImage->SizeX() * aNewImage->SizeY());
+    aCase.DiffRatio = 1.0;
+    return false;
+  }
+
+  Image_Diff aComparer;
+  if (!aComparer.Init (aRefImage, aNewImage))
+  {
+    return false;
+  }
+  aComparer.SetColorTolerance (myColorTolerance);
+  aComparer.SetBorderFilterOn (true);
+  aCase.NbDiffPixels = aComparer.Compare();
+  if (aCase.NbDiffPixels < 0)
+  {
+    return false;
+  }
+
+  aCase.DiffRatio = double(aCase.NbDiffPixels) / double(aNewImage->SizeX() * aNewImage->SizeY());
+  aCase.Psnr = computePsnr (*aRefImage, *aNewImage);
+  aCase.Status = aCase.DiffRatio <= myMaxDiffRatio ? OcctRegressionStatus_Passed : OcctRegressionStatus_Failed;
+  if (aCase.Status == OcctRegressionStatus_Failed)
+  {
+    const TCollection_AsciiString aDiffPath = myOutFolder + "/" + theName + "_diff.png";
+    if (!aComparer.SaveDiffImage (aDiffPath))
+    {
+      Message::SendFail() << "Error: unable to save difference image '" << aDiffPath << "'";
+    }
+  }
+  return aCase.Status == OcctRegressionStatus_Passed;
+}
+
+// Save report into output folder.
+bool OcctImageRegression::SaveReport() const
+{
+  const TCollection_AsciiString aPath = myOutFolder + "/regression.json";
+  std::ofstream aFile (aPath.ToCString(), std::ios::out | std::ios::trunc);
+  if (!aFile.is_open())
+  {
+    Message::SendFail() << "Error: unable to save report '" << aPath << "'";
+    return false;
+  }
+
+  aFile << "[";
+  for (size_t aCaseIter = 0; aCaseIter < myCases.size(); ++aCaseIter)
+  {
+    const OcctRegressionCase& aCase = myCases[aCaseIter];
+    aFile << (aCaseIter > 0 ? "," : "") << "\n  { \"name\": \"" << aCase.Name.ToCString()
+          << "\", \"status\": \"" << statusName (aCase.Status)
+          << "\", \"renderMs\": " << 1000.0 * aCase.RenderTime
+          << ", \"diffPixels\": " << aCase.NbDiffPixels << ", \"diffRatio\": " << aCase.DiffRatio << ", \"psnr\": ";
+    if (std::isinf (aCase.Psnr)) { aFile << "null"; }
+    else                         { aFile << aCase.Psnr; }
+    aFile << " }";
+  }
+  aFile << "\n]\n";
+  return aFile.good();
+}
+
+// Print summary.
+void OcctImageRegression::DumpStats() const
+{
+  int aNbPerStatus[OcctRegressionStatus_Error + 1] = {};
+  double aRenderTime = 0.0;
+  for (const OcctRegressionCase& aCase : myCases)
+  {
+    ++aNbPerStatus[aCase.Status];
+    aRenderTime += aCase.RenderTime;
+    Message::SendInfo() << "  " << aCase.Name << ": " << statusName (aCase.Status) << ", render " << 1000.0 * aCase.RenderTime << " ms"
+                        << ", different pixels " << aCase.NbDiffPixels << ", PSNR " << aCase.Psnr << " dB";
+  }
+  Message::SendInfo() << "Regression: " << (int )myCases.size() << " cases, "
+                      << aNbPerStatus[OcctRegressionStatus_Passed]  << " passed, "
+                      << aNbPerStatus[OcctRegressionStatus_Failed]  << " failed, "
+                      << aNbPerStatus[OcctRegressionStatus_Missing] << " missing, "
+                      << aNbPerStatus[OcctRegressionStatus_Updated] << " updated, "
+                      << aNbPerStatus[OcctRegressionStatus_Error]   << " errors; total render time " << aRenderTime << " s";
+}
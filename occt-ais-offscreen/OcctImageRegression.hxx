@@ -0,0 +1,88 @@
+#ifndef _OcctImageRegression_HeaderFile
+#define _OcctImageRegression_HeaderFile
+
+#include <Image_AlienPixMap.hxx>
+#include <TCollection_AsciiString.hxx>
+
+#include <vector>
+
+//! Status of regression case.
+enum OcctRegressionStatus
+{
+  OcctRegressionStatus_Passed,  //!< image matches reference within tolerance
+  OcctRegressionStatus_Failed,  //!< image differs from reference
+  OcctRegressionStatus_Missing, //!< reference image does not exist (counted as failure)
+  OcctRegressionStatus_Updated, //!< reference image has been (re)written
+  OcctRegressionStatus_Error    //!< image could not be saved or compared
+};
+
+//! Result of regression case.
+struct OcctRegressionCase
+{
+  TCollection_AsciiString Name;         //!< case name (image file name without extension)
+  OcctRegressionStatus    Status;       //!< comparison status
+  double                  RenderTime;   //!< render time in seconds
+  int                     NbDiffPixels; //!< number of pixels different beyond tolerance (border filter applied)
+  double                  DiffRatio;    //!< ratio of different pixels
+  double                  Psnr;         //!< peak signal-to-noise ratio in dB (infinite for identical images)
+
+  OcctRegressionCase() : Status (OcctRegressionStatus_Error), RenderTime (0.0), NbDiffPixels (0), DiffRatio (0.0), Psnr (0.0) {}
+};
+
+//! Comparison of rendered images with stored references.
+//! Images are compared by Image_Diff with color tolerance and border filter,
+//! which ignores isolated differences along edges (typically caused by rasterization and anti-aliasing details);
+//! PSNR is computed in addition to quantify differences of images passing the check.
+//! Rendered image of every case is saved into output folder as "<name>.png", and difference image as "<name>_diff.png" on failure.
+class OcctImageRegression
+{
+public:
+
+  //! Main constructor.
+  //! @param[in] theRefFolder folder with reference images "<name>.png"
+  //! @param[in] theOutFolder folder for rendered and difference images and report
+  OcctImageRegression (const TCollection_AsciiString& theRefFolder,
+                       const TCollection_AsciiString& theOutFolder);
+
+  //! Set color tolerance within [0, 1] range (difference between black and white); 0.05 by default.
+  void SetColorTolerance (double theTolerance) { myColorTolerance = theTolerance; }
+
+  //! Set maximum ratio of different pixels to pass the check; 0.0005 by default.
+  void SetMaxDiffRatio (double theRatio) { myMaxDiffRatio = theRatio; }
+
+  //! Set if reference images should be overwritten by rendered ones instead of comparison; FALSE by default.
+  void SetToUpdate (bool theToUpdate) { myToUpdate = theToUpdate; }
+
+  //! Return checked cases.
+  const std::vector<OcctRegressionCase>& Cases() const { return myCases; }
+
+  //! Return number of failed cases (including missing references and errors).
+  int NbFailed() const;
+
+  //! Save rendered image of the case and compare it with reference.
+  //! @param[in] theName       case name
+  //! @param[in] theImage      rendered image
+  //! @param[in] theRenderTime render time in seconds
+  //! @return FALSE if case failed
+  bool Check (const TCollection_AsciiString& theName,
+              Image_AlienPixMap& theImage,
+              double theRenderTime);
+
+  //! Save report "regression.json" into output folder.
+  bool SaveReport() const;
+
+  //! Print summary.
+  void DumpStats() const;
+
+private:
+
+  TCollection_AsciiString         myRefFolder;      //!< folder with reference images
+  TCollection_AsciiString         myOutFolder;      //!< output folder
+  std::vector<OcctRegressionCase> myCases;          //!< checked cases
+  double                          myColorTolerance; //!< color tolerance
+  double                          myMaxDiffRatio;   //!< maximum ratio of different pixels
+  bool                            myToUpdate;       //!< overwrite reference images
+
+};
+
+#endif // _OcctImageRegression_HeaderFile
@@ -0,0 +1,247 @@
+#include "OcctModelCache.hxx"
+
+#include "OcctOffscreenPool.hxx"
+
+#include <BRep_Builder.hxx>
+#include <BRep_Tool.hxx>
+#include <BRepPrimAPI_MakeBox.hxx>
+#include <BRepPrimAPI_MakeCone.hxx>
+#include <BRepPrimAPI_MakeSphere.hxx>
+#include <BRepPrimAPI_MakeTorus.hxx>
+#include <BRepTools.hxx>
+#include <Message.hxx>
+#include <Poly_Triangulation.hxx>
+#include <TopExp.hxx>
+#include <TopoDS.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <sys/stat.h>
+
+// Build built-in sample shape.
+TopoDS_Shape OcctModelCache::MakeSampleShape (int theIndex)
+{
+  const double aSize = 50.0 + 10.0 * (theIndex % 7);
+  switch (theIndex % 4)
+  {
+    case 0:  return BRepPrimAPI_MakeCone   (aSize, aSize * 0.1, aSize).Shape();
+    case 1:  return BRepPrimAPI_MakeBox    (aSize, aSize * 0.5, aSize * 0.3).Shape();
+    case 2:  return BRepPrimAPI_MakeSphere (aSize).Shape();
+    default: return BRepPrimAPI_MakeTorus  (aSize, aSize * 0.2).Shape();
+  }
+}
+
+// Compute 64-bit FNV-1a hash of data.
+TCollection_AsciiString OcctModelCache::ContentHash (const char* theData, size_t theSize)
+{
+  uint64_t aHash = 14695981039346656037ULL;
+  for (size_t aByteIter = 0; aByteIter < theSize; ++aByteIter)
+  {
+    aHash ^= (unsigned char )theData[aByteIter];
+    aHash *= 1099511628211ULL;
+  }
+
+  char aHashStr[32];
+  snprintf (aHashStr, sizeof(aHashStr), "%016llx", (unsigned long long )aHash);
+  return aHashStr;
+}
+
+// Estimate memory used by shape geometry and triangulation.
+size_t OcctModelCache::EstimateMemory (const TopoDS_Shape& theShape)
+{
+  // rough per-item sizes of topology, geometry and triangulation arrays
+  TopTools_IndexedMapOfShape aSubShapes;
+  TopExp::MapShapes (theShape, aSubShapes);
+  size_t aMemory = aSubShapes.Extent() * 256;
+
+  TopTools_IndexedMapOfShape aFaces;
+  TopExp::MapShapes (theShape, TopAbs_FACE, aFaces);
+  for (TopTools_IndexedMapOfShape::Iterator aFaceIter (aFaces); aFaceIter.More(); aFaceIter.Next())
+  {
+    TopLoc_Location aLoc;
+    const Handle(Poly_Triangulation)& aTris = BRep_Tool::Triangulation (TopoDS::Face (aFaceIter.Value()), aLoc);
+    if (aTris.IsNull())
+    {
+      continue;
+    }
+
+    size_t aNodeSize = sizeof(gp_Pnt);
+    if (aTris->HasNormals()) { aNodeSize += 3 * sizeof(float); }
+    if (aTris->HasUVNodes()) { aNodeSize += sizeof(gp_Pnt2d); }
+    aMemory += aTris->NbNodes() * aNodeSize + aTris->NbTriangles() * 3 * sizeof(int);
+  }
+  return aMemory;
+}
+
+// Main constructor.
+OcctModelCache::OcctModelCache (size_t theBudget)
+{
+  myStats.Budget = theBudget;
+}
+
+// Move entry to the front of LRU list.
+bool OcctModelCache::touch (const std::string& theKey, TopoDS_Shape& theShape)
+{
+  auto anIndexIter = myIndex.find (theKey);
+  if (anIndexIter == myIndex.end())
+  {
+    return false;
+  }
+
+  myEntries.splice (myEntries.begin(), myEntries, anIndexIter->second);
+  theShape = anIndexIter->second->Shape;
+  return true;
+}
+
+// Insert a new entry and evict least recently used ones exceeding budget.
+void OcctModelCache::insert (const TCollection_AsciiString& theKey, const TopoDS_Shape& theShape, size_t theMemory)
+{
+  Entry anEntry;
+  anEntry.Key    = theKey;
+  anEntry.Shape  = theShape;
+  anEntry.Memory = theMemory;
+  myEntries.push_front (anEntry);
+  myIndex[theKey.ToCString()] = myEntries.begin();
+  myStats.Memory += theMemory;
+
+  // the new entry is kept even if it alone exceeds the budget
+  while (myStats.Memory > myStats.Budget
+      && myEntries.size() > 1)
+  {
+    const Entry& anOldest = myEntries.back();
+    myStats.Memory -= anOldest.Memory;
+    myIndex.erase (anOldest.Key.ToCString());
+    myEntries.pop_back();
+    ++myStats.NbEvictions;
+  }
+  myStats.NbEntries = myEntries.size();
+}
+
+// Find resident model by key.
+bool OcctModelCache::FindKey (const TCollection_AsciiString& theKey,
+                              TopoDS_Shape& theShape)
+{
+  std::lock_guard<std::mutex> aLock (myMutex);
+  if (!touch (theKey.ToCString(), theShape))
+  {
+    return false;
+  }
+  ++myStats.NbHits;
+  return true;
+}
+
+// Find resident model or load a new one.
+bool OcctModelCache::Find (const TCollection_AsciiString& theName,
+                           TCollection_AsciiString& theKey,
+                           TopoDS_Shape& theShape,
+                           TCollection_AsciiString& theError)
+{
+  const bool isSample = theName.Search ("sample:") == 1;
+  struct stat aFileStat;
+  if (!isSample
+   && stat (theName.ToCString(), &aFileStat) != 0)
+  {
+    theError = TCollection_AsciiString ("unable to open file '") + theName + "'";
+    return false;
+  }
+
+  // unchanged file memorized by path doesn't need to be read and hashed again
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+    if (isSample)
+    {
+      theKey = theName;
+    }
+    else
+    {
+      auto aFileIter = myFiles.find (theName.ToCString());
+      if (aFileIter != myFiles.end()
+       && aFileIter->second.ModTime == (long long )aFileStat.st_mtime
+       && aFileIter->second.Size    == (long long )aFileStat.st_size)
+      {
+        theKey = aFileIter->second.Key;
+      }
+    }
+    if (!theKey.IsEmpty()
+     && touch (theKey.ToCString(), theShape))
+    {
+      ++myStats.NbHits;
+      return true;
+    }
+  }
+
+  // load model outside of lock, so that other requests are not blocked
+  TopoDS_Shape aShape;
+  size_t aMemory = 0;
+  if (isSample)
+  {
+    aShape = MakeSampleShape (theName.Length() > 7 ? theName.SubString (8, theName.Length()).IntegerValue() : 0);
+  }
+  else
+  {
+    std::ifstream aFile (theName.ToCString(), std::ios::in | std::ios::binary);
+    std::stringstream aContent;
+    aContent << aFile.rdbuf();
+    const std::string aData = aContent.str();
+    theKey = ContentHash (aData.data(), aData.size());
+    aMemory = aData.size();
+    {
+      std::lock_guard<std::mutex> aLock (myMutex);
+      FileState& aState = myFiles[theName.ToCString()];
+      aState.Key     = theKey;
+      aState.ModTime = (long long )aFileStat.st_mtime;
+      aState.Size    = (long long )aFileStat.st_size;
+      if (touch (theKey.ToCString(), theShape))
+      {
+        // the same content is already resident under another path
+        ++myStats.NbHits;
+        return true;
+      }
+    }
+
+    BRep_Builder aBuilder;
+    BRepTools::Read (aShape, aContent, aBuilder);
+    if (aShape.IsNull())
+    {
+      theError = TCollection_AsciiString ("unable to read BREP file '") + theName + "'";
+      return false;
+    }
+  }
+
+  OcctOffscreenPool::MeshShape (aShape);
+  aMemory += EstimateMemory (aShape);
+
+  std::lock_guard<std::mutex> aLock (myMutex);
+  ++myStats.NbMisses;
+  if (touch (theKey.ToCString(), theShape))
+  {
+    // loaded concurrently by another request
+    return true;
+  }
+  insert (theKey, aShape, aMemory);
+  theShape = aShape;
+  return true;
+}
+
+// Return statistics.
+OcctModelCacheStats OcctModelCache::Stats() const
+{
+  std::lock_guard<std::mutex> aLock (myMutex);
+  return myStats;
+}
+
+// Print statistics.
+void OcctModelCache::DumpStats() const
+{
+  const OcctModelCacheStats aStats = Stats();
+  const size_t aNbLookups = aStats.NbHits + aStats.NbMisses;
+  Message::SendInfo() << "Model cache: " << (int )aStats.NbEntries << " models, "
+                      << double(aStats.Memory) / (1024.0 * 1024.0) << " of " << double(aStats.Budget) / (1024.0 * 1024.0) << " MiB, "
+                      << (int )aStats.NbHits << " hits, " << (int )aStats.NbMisses << " misses (hit rate "
+                      << (aNbLookups != 0 ? 100.0 * aStats.NbHits / aNbLookups : 0.0) << "%), "
+                      << (int )aStats.NbEvictions << " evictions";
+}
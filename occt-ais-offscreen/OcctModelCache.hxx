@@ -0,0 +1,109 @@
+#ifndef _OcctModelCache_HeaderFile
+#define _OcctModelCache_HeaderFile
+
+#include <TCollection_AsciiString.hxx>
+#include <TopoDS_Shape.hxx>
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+//! Cache statistics.
+struct OcctModelCacheStats
+{
+  size_t NbEntries;   //!< number of resident models
+  size_t Memory;      //!< estimated memory used by resident models in bytes
+  size_t Budget;      //!< memory budget in bytes
+  size_t NbHits;      //!< number of lookups found resident model
+  size_t NbMisses;    //!< number of lookups loaded model
+  size_t NbEvictions; //!< number of models evicted to fit into budget
+
+  OcctModelCacheStats() : NbEntries (0), Memory (0), Budget (0), NbHits (0), NbMisses (0), NbEvictions (0) {}
+};
+
+//! LRU cache of loaded and meshed models keyed by file content hash, limited by memory budget.
+//! Files are identified by content, so that the same model under different paths shares the same entry;
+//! file path is additionally memorized with modification time and size to skip reading unchanged files.
+class OcctModelCache
+{
+public:
+
+  //! Build built-in sample shape.
+  static TopoDS_Shape MakeSampleShape (int theIndex);
+
+  //! Compute 64-bit FNV-1a hash of data and return it as hex string.
+  static TCollection_AsciiString ContentHash (const char* theData, size_t theSize);
+
+  //! Estimate memory used by shape geometry and triangulation.
+  static size_t EstimateMemory (const TopoDS_Shape& theShape);
+
+public:
+
+  //! Main constructor.
+  //! @param[in] theBudget memory budget in bytes
+  OcctModelCache (size_t theBudget);
+
+  //! Find resident model or load a new one; thread-safe.
+  //! Models are either BREP files or built-in "sample:N" shapes.
+  //! @param[in]  theName  model path or sample name
+  //! @param[out] theKey   model key (content hash)
+  //! @param[out] theShape meshed model shape
+  //! @param[out] theError error message
+  bool Find (const TCollection_AsciiString& theName,
+             TCollection_AsciiString& theKey,
+             TopoDS_Shape& theShape,
+             TCollection_AsciiString& theError);
+
+  //! Find resident model by key; thread-safe.
+  bool FindKey (const TCollection_AsciiString& theKey,
+                TopoDS_Shape& theShape);
+
+  //! Return statistics.
+  OcctModelCacheStats Stats() const;
+
+  //! Print statistics.
+  void DumpStats() const;
+
+private:
+
+  //! Resident model.
+  struct Entry
+  {
+    TCollection_AsciiString Key;    //!< content hash
+    TopoDS_Shape            Shape;  //!< meshed shape
+    size_t                  Memory; //!< estimated memory
+  };
+
+  //! Memorized file state.
+  struct FileState
+  {
+    TCollection_AsciiString Key;     //!< content hash
+    long long               ModTime; //!< modification time
+    long long               Size;    //!< file size
+  };
+
+private:
+
+  //! Move entry to the front of LRU list and return its shape; should be called under lock.
+  bool touch (const std::string& theKey, TopoDS_Shape& theShape);
+
+  //! Insert a new entry and evict least recently used ones exceeding budget; should be called under lock.
+  void insert (const TCollection_AsciiString& theKey, const TopoDS_Shape& theShape, size_t theMemory);
+
+private:
+
+  OcctModelCache (const OcctModelCache& ) = delete;
+  OcctModelCache& operator= (const OcctModelCache& ) = delete;
+
+private:
+
+  std::list<Entry> myEntries;                                          //!< resident models, most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> myIndex; //!< entries by key
+  std::unordered_map<std::string, FileState> myFiles;                  //!< memorized file states by path
+  mutable std::mutex  myMutex;                                         //!< cache lock
+  OcctModelCacheStats myStats;                                         //!< statistics
+
+};
+
+#endif // _OcctModelCache_HeaderFile
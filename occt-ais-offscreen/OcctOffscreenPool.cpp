@@ -0,0 +1,249 @@
+#include "OcctOffscreenPool.hxx"
+
+#include "OcctOffscreenViewer.hxx"
+
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRepTools.hxx>
+#include <Font_FontMgr.hxx>
+#include <Message.hxx>
+#include <OSD_Timer.hxx>
+#include <Prs3d_Drawer.hxx>
+#include <StdPrs_ToolTriangulatedShape.hxx>
+
+#include <exception>
+
+#if !defined(_WIN32) && !defined(__APPLE__) && !defined(__ANDROID__)
+  #include <X11/Xlib.h>
+#endif
+
+// Prepare process for multi-threaded rendering.
+void OcctOffscreenPool::InitThreads()
+{
+#if !defined(_WIN32) && !defined(__APPLE__) && !defined(__ANDROID__)
+  // each worker opens its own X display connection, but Xlib still requires global initialization
+  XInitThreads();
+#endif
+  // font manager is a lazily initialized singleton shared by all viewers
+  Font_FontMgr::GetInstance();
+}
+
+// Mesh shape for rendering.
+void OcctOffscreenPool::MeshShape (const TopoDS_Shape& theShape)
+{
+  // use the same deflection as default AIS presentation
+  Handle(Prs3d_Drawer) aDrawer = new Prs3d_Drawer();
+  const double aDeflection = StdPrs_ToolTriangulatedShape::GetDeflection (theShape, aDrawer);
+  if (!BRepTools::Triangulation (theShape, aDeflection))
+  {
+    BRepMesh_IncrementalMesh aMesher (theShape, aDeflection, false, aDrawer->DeviationAngle(), false);
+  }
+}
+
+// Empty constructor.
+OcctOffscreenPool::OcctOffscreenPool()
+: myPrsCacheSize (0), myNbReady (0), myNbFailed (0), myToStop (false)
+{
+  //
+}
+
+// Start worker threads.
+bool OcctOffscreenPool::Start (int theNbWorkers)
+{
+  Stop();
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+    myToStop   = false;
+    myNbReady  = 0;
+    myNbFailed = 0;
+  }
+
+  for (int aWorkerIter = 0; aWorkerIter < theNbWorkers; ++aWorkerIter)
+  {
+    myThreads.emplace_back (&OcctOffscreenPool::workerThread, this, aWorkerIter);
+  }
+
+  std::unique_lock<std::mutex> aLock (myMutex);
+  myReadyCond.wait (aLock, [this, theNbWorkers]() { return myNbReady + myNbFailed == theNbWorkers; });
+  const bool isOk = myNbFailed == 0;
+  aLock.unlock();
+  if (!isOk)
+  {
+    Stop();
+  }
+  return isOk;
+}
+
+// Render pending jobs and stop worker threads.
+void OcctOffscreenPool::Stop()
+{
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+    myToStop = true;
+  }
+  myQueueCond.notify_all();
+  for (std::thread& aThread : myThreads)
+  {
+    aThread.join();
+  }
+  myThreads.clear();
+}
+
+// Submit job to the queue.
+std::future<OcctRenderResult> OcctOffscreenPool::Submit (const OcctRenderJob& theJob)
+{
+  {
+    std::lock_guard<std::mutex> aMeshLock (myMeshMutex);
+    MeshShape (theJob.Shape);
+  }
+
+  std::future<OcctRenderResult> aFuture;
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+    myQueue.emplace_back();
+    myQueue.back().Job = theJob;
+    aFuture = myQueue.back().Promise.get_future();
+  }
+  myQueueCond.notify_one();
+  return aFuture;
+}
+
+// Worker thread function.
+void OcctOffscreenPool::workerThread (int theWorker)
+{
+  // viewer and its OpenGL context are created, used and destroyed by this thread only
+  OcctOffscreenViewer aViewer;
+  const bool isInitialized = aViewer.InitOffscreenViewer (Graphic3d_Vec2i (64, 64));
+  if (isInitialized)
+  {
+    // shapes are meshed in advance by Submit()
+    aViewer.Context()->DefaultDrawer()->SetAutoTriangulation (false);
+  }
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+    if (!isInitialized)
+    {
+      ++myNbFailed;
+    }
+    else
+    {
+      if (theWorker == 0) { myGlRenderer = aViewer.GlRenderer(); }
+      ++myNbReady;
+    }
+  }
+  myReadyCond.notify_all();
+  if (!isInitialized)
+  {
+    return;
+  }
+
+  PrsCache aPrsCache;
+  for (;;)
+  {
+    QueuedJob aJob;
+    {
+      std::unique_lock<std::mutex> aLock (myMutex);
+      myQueueCond.wait (aLock, [this]() { return myToStop || !myQueue.empty(); });
+      if (myQueue.empty())
+      {
+        return;
+      }
+      aJob = std::move (myQueue.front());
+      myQueue.pop_front();
+    }
+
+    OcctRenderResult aResult;
+    aResult.Worker = theWorker;
+    OSD_Timer aTimer;
+    aTimer.Start();
+    aResult.IsDone = renderJob (aViewer, aPrsCache, aJob.Job, aResult);
+    aResult.RenderTime = aTimer.ElapsedTime();
+    aJob.Promise.set_value (aResult);
+  }
+}
+
+// Render job by worker viewer.
+bool OcctOffscreenPool::renderJob (OcctOffscreenViewer& theViewer,
+                                   PrsCache& thePrsCache,
+                                   const OcctRenderJob& theJob,
+                                   OcctRenderResult& theResult) const
+{
+  const Handle(AIS_InteractiveContext)& aCtx  = theViewer.Context();
+  const Handle(V3d_View)&               aView = theViewer.View();
+  try
+  {
+    OCC_CATCH_SIGNALS
+    // cached presentations of previous jobs are hidden, others have been removed after rendering
+    aCtx->EraseAll (false);
+
+    Handle(AIS_Shape) aShapePrs;
+    const bool toCache = myPrsCacheSize > 0 && !theJob.ModelKey.IsEmpty();
+    if (toCache)
+    {
+      for (PrsCache::iterator aPrsIter = thePrsCache.begin(); aPrsIter != thePrsCache.end(); ++aPrsIter)
+      {
+        if (aPrsIter->first == theJob.ModelKey)
+        {
+          aShapePrs = aPrsIter->second;
+          thePrsCache.splice (thePrsCache.begin(), thePrsCache, aPrsIter);
+          theResult.IsPrsCached = true;
+          break;
+        }
+      }
+    }
+    if (aShapePrs.IsNull())
+    {
+      aShapePrs = new AIS_Shape (theJob.Shape);
+      if (toCache)
+      {
+        thePrsCache.emplace_front (theJob.ModelKey, aShapePrs);
+        if ((int )thePrsCache.size() > myPrsCacheSize)
+        {
+          aCtx->Remove (thePrsCache.back().second, false);
+          thePrsCache.pop_back();
+        }
+      }
+    }
+    aCtx->Display (aShapePrs, AIS_Shaded, -1, false);
+    aView->SetProj (theJob.Orientation);
+    aView->FitAll (0.01, false);
+
+    Handle(Image_AlienPixMap) anImage = new Image_AlienPixMap();
+    const bool isDumped = aView->ToPixMap (*anImage, theJob.Size.x(), theJob.Size.y());
+    if (!toCache)
+    {
+      aCtx->Remove (aShapePrs, false);
+    }
+    if (!isDumped)
+    {
+      Message::SendFail() << "View dump FAILED";
+      return false;
+    }
+
+    if (theJob.OutputPath.IsEmpty())
+    {
+      theResult.Image = anImage;
+    }
+    else if (!anImage->Save (theJob.OutputPath))
+    {
+      Message::SendFail() << "Unable to save image into file '" << theJob.OutputPath << "'";
+      return false;
+    }
+  }
+  catch (const Standard_Failure& theErr)
+  {
+    Message::SendFail() << "Render job FAILED:\n" << theErr;
+    return false;
+  }
+  // exception escaping worker thread would terminate the process and leave the job's promise unset
+  catch (const std::exception& theErr)
+  {
+    Message::SendFail() << "Render job FAILED: " << theErr.what();
+    return false;
+  }
+  catch (...)
+  {
+    Message::SendFail() << "Render job FAILED: unknown exception";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,136 @@
+#ifndef _OcctOffscreenPool_HeaderFile
+#define _OcctOffscreenPool_HeaderFile
+
+#include <AIS_Shape.hxx>
+#include <Graphic3d_Vec2.hxx>
+#include <Image_AlienPixMap.hxx>
+#include <TCollection_AsciiString.hxx>
+#include <TopoDS_Shape.hxx>
+#include <V3d_TypeOfOrientation.hxx>
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class OcctOffscreenViewer;
+
+//! Render job - image of a shape.
+struct OcctRenderJob
+{
+  TopoDS_Shape            Shape;       //!< shape to render
+  Graphic3d_Vec2i         Size;        //!< image dimensions
+  V3d_TypeOfOrientation   Orientation; //!< camera orientation
+  TCollection_AsciiString OutputPath;  //!< image file to save; when empty, image is returned within result
+  TCollection_AsciiString ModelKey;    //!< key to reuse shape presentation within worker; empty to disable reuse
+
+  OcctRenderJob() : Size (256, 256), Orientation (V3d_TypeOfOrientation_Zup_AxoRight) {}
+};
+
+//! Render job result.
+struct OcctRenderResult
+{
+  Handle(Image_AlienPixMap) Image;       //!< rendered image, NULL if it was saved into file
+  double                    RenderTime;  //!< time spent by worker on this job in seconds
+  int                       Worker;      //!< index of worker processed the job
+  bool                      IsDone;      //!< job completion status
+  bool                      IsPrsCached; //!< presentation was reused from worker cache
+
+  OcctRenderResult() : RenderTime (0.0), Worker (-1), IsDone (false), IsPrsCached (false) {}
+};
+
+//! Pool of independent offscreen viewers for concurrent rendering within a single process.
+//! Each worker thread owns its own graphic driver, viewer and OpenGL context created on that thread,
+//! so that jobs are rendered in parallel without sharing any OpenGL state.
+class OcctOffscreenPool
+{
+public:
+
+  //! Prepare process for multi-threaded rendering; should be called before any other graphic calls.
+  //! Enables Xlib multi-threading and initializes global font manager.
+  static void InitThreads();
+
+  //! Mesh shape for rendering; shapes are meshed before submitting, as workers do not modify shared shapes.
+  static void MeshShape (const TopoDS_Shape& theShape);
+
+public:
+
+  //! Empty constructor.
+  OcctOffscreenPool();
+
+  //! Destructor stopping workers.
+  ~OcctOffscreenPool() { Stop(); }
+
+  //! Return number of running workers.
+  int NbWorkers() const { return (int )myThreads.size(); }
+
+  //! Return number of presentations kept by each worker for jobs with model key.
+  int PrsCacheSize() const { return myPrsCacheSize; }
+
+  //! Set number of presentations kept by each worker; should be called before Start().
+  //! Cached presentations are hidden instead of removed, so that repeated jobs skip presentation computation.
+  void SetPrsCacheSize (int theSize) { myPrsCacheSize = theSize; }
+
+  //! Return OpenGL renderer name of the first worker.
+  const TCollection_AsciiString& GlRenderer() const { return myGlRenderer; }
+
+  //! Start worker threads and wait for their viewers to be initialized.
+  //! @param[in] theNbWorkers number of workers
+  //! @return FALSE if any viewer cannot be initialized
+  bool Start (int theNbWorkers);
+
+  //! Render pending jobs and stop worker threads.
+  void Stop();
+
+  //! Submit job to the queue; thread-safe.
+  //! Shape is meshed by the calling thread, if it was not meshed before.
+  std::future<OcctRenderResult> Submit (const OcctRenderJob& theJob);
+
+private:
+
+  //! Worker thread function.
+  void workerThread (int theWorker);
+
+  //! Presentations of recently rendered models, most recently used first.
+  typedef std::list<std::pair<TCollection_AsciiString, Handle(AIS_Shape)>> PrsCache;
+
+  //! Render job by worker viewer.
+  bool renderJob (OcctOffscreenViewer& theViewer,
+                  PrsCache& thePrsCache,
+                  const OcctRenderJob& theJob,
+                  OcctRenderResult& theResult) const;
+
+private:
+
+  OcctOffscreenPool (const OcctOffscreenPool& ) = delete;
+  OcctOffscreenPool& operator= (const OcctOffscreenPool& ) = delete;
+
+private:
+
+  //! Queued job.
+  struct QueuedJob
+  {
+    OcctRenderJob                  Job;
+    std::promise<OcctRenderResult> Promise;
+  };
+
+private:
+
+  std::vector<std::thread> myThreads;      //!< worker threads
+  std::deque<QueuedJob>    myQueue;        //!< pending jobs
+  std::mutex               myMutex;        //!< lock for queue and worker states
+  std::mutex               myMeshMutex;    //!< lock for meshing shapes
+  std::condition_variable  myQueueCond;    //!< signal for new jobs
+  std::condition_variable  myReadyCond;    //!< signal for worker initialization
+  TCollection_AsciiString  myGlRenderer;   //!< OpenGL renderer name
+  int                      myPrsCacheSize; //!< number of presentations kept by each worker
+  int                      myNbReady;      //!< number of initialized workers
+  int                      myNbFailed;     //!< number of workers failed initialization
+  bool                     myToStop;       //!< flag to stop workers
+
+};
+
+#endif // _OcctOffscreenPool_HeaderFile
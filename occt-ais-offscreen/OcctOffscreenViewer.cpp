@@ -0,0 +1,98 @@
+#ifdef _WIN32
+  #include <windows.h>
+#endif
+
+#include "OcctOffscreenViewer.hxx"
+
+#include <Message.hxx>
+#include <OpenGl_GraphicDriver.hxx>
+#include <TColStd_IndexedDataMapOfStringString.hxx>
+
+#ifdef _WIN32
+  #include <WNT_WClass.hxx>
+  #include <WNT_Window.hxx>
+#elif defined(__APPLE__)
+  #include <Cocoa_Window.hxx>
+#elif defined(__ANDROID__)
+  #include <Aspect_NeutralWindow.hxx>
+#else
+  #include <Xw_Window.hxx>
+#endif
+
+// Initialize offscreen viewer.
+bool OcctOffscreenViewer::InitOffscreenViewer (const Graphic3d_Vec2i& theWinSize)
+{
+  try
+  {
+    OCC_CATCH_SIGNALS
+
+    // create graphic driver
+    Handle(Aspect_DisplayConnection) aDispConnection = new Aspect_DisplayConnection();
+    Handle(OpenGl_GraphicDriver) aDriver = new OpenGl_GraphicDriver (aDispConnection, true);
+    aDriver->ChangeOptions().ffpEnable    = false;
+    aDriver->ChangeOptions().swapInterval = 0;
+
+    // create viewer and AIS context
+    myViewer  = new V3d_Viewer (aDriver);
+    myContext = new AIS_InteractiveContext (myViewer);
+
+    // light sources setup
+    myViewer->SetDefaultLights();
+    myViewer->SetLightOn();
+
+    // create offscreen window
+    const TCollection_AsciiString aWinName ("OCCT offscreen window");
+  #ifdef __ANDROID__
+    Handle(Aspect_NeutralWindow) aWindow = new Aspect_NeutralWindow();
+    aWindow->SetSize (theWinSize.x(), theWinSize.y());
+  #elif defined(_WIN32)
+    const TCollection_AsciiString aClassName ("OffscreenClass");
+    Handle(WNT_WClass) aWinClass = new WNT_WClass (aClassName.ToCString(), NULL, 0); // empty callback!
+    Handle(WNT_Window) aWindow   = new WNT_Window (aWinName.ToCString(), aWinClass, 0x80000000L, //WS_POPUP,
+                                                   64, 64, 64, 64, Quantity_NOC_BLACK);
+    aWindow->SetVirtual (true);
+    aWindow->SetPos (0, 0, theWinSize.x(), theWinSize.y());
+  #elif defined(__APPLE__)
+    Handle(Cocoa_Window) aWindow = new Cocoa_Window (aWinName.ToCString(), 64, 64, theWinSize.x(), theWinSize.y());
+  #else
+    Handle(Xw_Window) aWindow = new Xw_Window (aDispConnection, aWinName.ToCString(),
+                                               64, 64, theWinSize.x(), theWinSize.y());
+  #endif
+    aWindow->SetVirtual (true);
+
+    // create 3D view from offscreen window
+    myView = new V3d_View (myViewer);
+    myView->SetWindow (aWindow);
+  }
+  catch (const Standard_Failure& theErr)
+  {
+    Message::SendFail() << "Offscreen Viewer creation FAILED:\n" << theErr;
+    return false;
+  }
+  return true;
+}
+
+// Print information about graphics context.
+void OcctOffscreenViewer::DumpGlInfo()
+{
+  TColStd_IndexedDataMapOfStringString aGlCapsDict;
+  myView->DiagnosticInformation (aGlCapsDict, Graphic3d_DiagnosticInfo_Basic);
+  TCollection_AsciiString anInfo = "OpenGL info:\n";
+  for (TColStd_IndexedDataMapOfStringString::Iterator aValueIter (aGlCapsDict); aValueIter.More(); aValueIter.Next())
+  {
+    if (!aValueIter.Value().IsEmpty())
+    {
+      anInfo += TCollection_AsciiString("  ") + aValueIter.Key() + ": " + aValueIter.Value() + "\n";
+    }
+  }
+  Message::SendInfo (anInfo);
+}
+
+// Return OpenGL renderer name.
+TCollection_AsciiString OcctOffscreenViewer::GlRenderer() const
+{
+  TColStd_IndexedDataMapOfStringString aGlCapsDict;
+  myView->DiagnosticInformation (aGlCapsDict, Graphic3d_DiagnosticInfo_Basic);
+  const TCollection_AsciiString* aRenderer = aGlCapsDict.Seek ("GLrenderer");
+  return aRenderer != NULL ? *aRenderer : TCollection_AsciiString ("unknown");
+}
@@ -0,0 +1,40 @@
+#ifndef _OcctOffscreenViewer_HeaderFile
+#define _OcctOffscreenViewer_HeaderFile
+
+#include <AIS_InteractiveContext.hxx>
+#include <V3d_View.hxx>
+#include <V3d_Viewer.hxx>
+
+//! Sample offscreen viewer class.
+//! Each instance owns its own graphic driver and OpenGL context,
+//! so that several instances could be used from different threads.
+class OcctOffscreenViewer
+{
+public:
+
+  //! Return view instance.
+  const Handle(V3d_View)& View() const { return myView; }
+
+  //! Return AIS context.
+  const Handle(AIS_InteractiveContext)& Context() const { return myContext; }
+
+  //! Initialize offscreen viewer.
+  //! @param[in] theWinSize view dimensions
+  //! @return FALSE in case of initialization error
+  bool InitOffscreenViewer (const Graphic3d_Vec2i& theWinSize);
+
+  //! Print information about graphics context.
+  void DumpGlInfo();
+
+  //! Return OpenGL renderer name.
+  TCollection_AsciiString GlRenderer() const;
+
+private:
+
+  Handle(V3d_Viewer) myViewer;
+  Handle(V3d_View)   myView;
+  Handle(AIS_InteractiveContext) myContext;
+
+};
+
+#endif // _OcctOffscreenViewer_HeaderFile
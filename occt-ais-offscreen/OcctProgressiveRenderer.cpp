@@ -0,0 +1,175 @@
+#include "OcctProgressiveRenderer.hxx"
+
+#include <Image_AlienPixMap.hxx>
+#include <Message.hxx>
+#include <OpenGl_Context.hxx>
+#include <OpenGl_GraphicDriver.hxx>
+#include <OSD_Timer.hxx>
+#include <V3d_Viewer.hxx>
+
+#include <cmath>
+#include <utility>
+
+namespace
+{
+  //! Return RMS of per-channel difference between two RGB images of the same dimensions within [0, 1] range.
+  static double imageNoise (const Image_PixMap& theImage1,
+                            const Image_PixMap& theImage2)
+  {
+    const size_t aRowLen = theImage1.SizeX() * 3;
+    double aSum = 0.0;
+    for (size_t aRowIter = 0; aRowIter < theImage1.SizeY(); ++aRowIter)
+    {
+      const Standard_Byte* aRow1 = theImage1.Row (aRowIter);
+      const Standard_Byte* aRow2 = theImage2.Row (aRowIter);
+      for (size_t aByteIter = 0; aByteIter < aRowLen; ++aByteIter)
+      {
+        const double aDiff = (double(aRow1[aByteIter]) - double(aRow2[aByteIter])) / 255.0;
+        aSum += aDiff * aDiff;
+      }
+    }
+    return std::sqrt (aSum / double(aRowLen * theImage1.SizeY()));
+  }
+}
+
+// Empty constructor.
+OcctProgressiveRenderer::OcctProgressiveRenderer()
+: myTimeBudget (0.0),
+  myNoiseThreshold (0.005),
+  myMaxSamples (1024),
+  myFirstCheckpoint (16),
+  myRayDepth (8)
+{
+  //
+}
+
+// Render view into image file.
+bool OcctProgressiveRenderer::Perform (const Handle(V3d_View)& theView,
+                                       const Graphic3d_Vec2i& theSize,
+                                       const TCollection_AsciiString& theOutPath)
+{
+  myResult = OcctProgressiveResult();
+
+  // double-buffered read-back images to compare consecutive checkpoints
+  Handle(Image_AlienPixMap) anImage = new Image_AlienPixMap(), aPrevImage = new Image_AlienPixMap();
+  if (!anImage   ->InitZero (Image_Format_RGB, theSize.x(), theSize.y())
+   || !aPrevImage->InitZero (Image_Format_RGB, theSize.x(), theSize.y()))
+  {
+    Message::SendFail() << "Error: unable to allocate image " << theSize.x() << "x" << theSize.y();
+    return false;
+  }
+
+  // OpenGl_View silently falls back to rasterization when ray tracing is unsupported
+  Handle(OpenGl_GraphicDriver) aDriver = Handle(OpenGl_GraphicDriver)::DownCast (theView->Viewer()->Driver());
+  const Handle(OpenGl_Context)& aGlCtx = !aDriver.IsNull() ? aDriver->GetSharedContext() : Handle(OpenGl_Context)();
+  if (aGlCtx.IsNull()
+  || !aGlCtx->HasRayTracing())
+  {
+    Message::SendFail() << "Error: path tracing is not supported by OpenGL context";
+    return false;
+  }
+
+  Graphic3d_RenderingParams& aParams = theView->ChangeRenderingParams();
+  const Graphic3d_RenderingParams aPrevParams = aParams;
+  aParams.Method = Graphic3d_RM_RAYTRACING;
+  aParams.IsGlobalIlluminationEnabled = true;
+  aParams.CoherentPathTracingMode = false;
+  aParams.AdaptiveScreenSampling  = false;
+  aParams.IsTransparentShadowEnabled = true;
+  aParams.RaytracingDepth = myRayDepth;
+  aParams.NbMsaaSamples   = 0;
+  aParams.RenderResolutionScale = 1.0f; // anti-aliasing comes from accumulated samples
+
+  // image is read back directly from the framebuffer (V3d_View::ToPixMap() would redraw it and might reset accumulation)
+  Handle(Standard_Transient) aFbo = theView->View()->FBOCreate (theSize.x(), theSize.y());
+  theView->View()->SetFBO (aFbo);
+
+  bool isDone = true;
+  int aNextCheckpoint = myFirstCheckpoint;
+  OSD_Timer aTimer;
+  aTimer.Start();
+  for (;;)
+  {
+    theView->Redraw();
+    aGlCtx->core11fwd->glFinish(); // for accurate time budget
+    ++myResult.NbSamples;
+
+    const double anElapsed = aTimer.ElapsedTime();
+    const bool isSamplesSpent = myResult.NbSamples >= myMaxSamples;
+    const bool isTimeSpent = myTimeBudget > 0.0 && anElapsed >= myTimeBudget;
+    if (myResult.NbSamples < aNextCheckpoint
+     && !isSamplesSpent
+     && !isTimeSpent)
+    {
+      continue;
+    }
+
+    while (aNextCheckpoint <= myResult.NbSamples) { aNextCheckpoint *= 2; }
+    if (!theView->View()->BufferDump (*anImage, Graphic3d_BT_RGB))
+    {
+      Message::SendFail() << "Error: unable to read back image at " << myResult.NbSamples << " samples";
+      isDone = false;
+      break;
+    }
+
+    myResult.Noise = myResult.NbSamples > myFirstCheckpoint ? imageNoise (*anImage, *aPrevImage) : -1.0;
+    const bool isConverged = myNoiseThreshold > 0.0
+                          && myResult.Noise >= 0.0
+                          && myResult.Noise <= myNoiseThreshold;
+    Message::SendInfo() << "Checkpoint " << myResult.NbSamples << " samples, " << anElapsed << " s, noise " << myResult.Noise;
+    if (myResult.Noise == 0.0)
+    {
+      // accumulation always changes the image, so that identical checkpoints mean rasterization fallback
+      // (e.g. ray tracing shaders failed to compile)
+      Message::SendFail() << "Error: path tracing is inactive (image did not change between checkpoints)";
+      isDone = false;
+      break;
+    }
+    if (isConverged || isSamplesSpent || isTimeSpent)
+    {
+      myResult.TimeToThreshold = isConverged ? anElapsed : -1.0;
+      myResult.StopReason = isConverged ? "noise" : (isSamplesSpent ? "samples" : "time");
+      break;
+    }
+
+    if (!myCheckpointPrefix.IsEmpty())
+    {
+      const TCollection_AsciiString aPath = myCheckpointPrefix + "_" + myResult.NbSamples + ".png";
+      if (!anImage->Save (aPath))
+      {
+        Message::SendFail() << "Error: unable to save checkpoint image '" << aPath << "'";
+        isDone = false;
+        break;
+      }
+    }
+    std::swap (anImage, aPrevImage);
+  }
+  aTimer.Stop();
+  myResult.Time = aTimer.ElapsedTime();
+
+  theView->View()->SetFBO (Handle(Standard_Transient)());
+  theView->View()->FBORelease (aFbo);
+  aParams = aPrevParams;
+  if (!isDone)
+  {
+    return false;
+  }
+  if (!anImage->Save (theOutPath))
+  {
+    Message::SendFail() << "Error: unable to save image '" << theOutPath << "'";
+    return false;
+  }
+  return true;
+}
+
+// Print samples per second and convergence statistics.
+void OcctProgressiveRenderer::DumpStats (const Graphic3d_Vec2i& theSize) const
+{
+  const double aTime = myResult.Time > 0.0 ? myResult.Time : 1.0;
+  Message::SendInfo() << "Path tracing " << theSize.x() << "x" << theSize.y() << ": " << myResult.NbSamples << " samples in "
+                      << myResult.Time << " s, " << myResult.NbSamples / aTime << " samples/s ("
+                      << double(myResult.NbSamples) * theSize.x() * theSize.y() / aTime * 1.0e-6 << " Mpx samples/s), noise "
+                      << myResult.Noise << ", time to noise threshold "
+                      << (myResult.TimeToThreshold >= 0.0 ? TCollection_AsciiString (myResult.TimeToThreshold) + " s" : TCollection_AsciiString ("not reached"))
+                      << ", stopped by " << myResult.StopReason;
+}
@@ -0,0 +1,82 @@
+#ifndef _OcctProgressiveRenderer_HeaderFile
+#define _OcctProgressiveRenderer_HeaderFile
+
+#include <Graphic3d_Vec2.hxx>
+#include <TCollection_AsciiString.hxx>
+#include <V3d_View.hxx>
+
+//! Result of progressive rendering.
+struct OcctProgressiveResult
+{
+  int                     NbSamples;       //!< accumulated samples per pixel
+  double                  Time;            //!< rendering time in seconds
+  double                  Noise;           //!< estimated noise of the last checkpoint, or -1 if unknown
+  double                  TimeToThreshold; //!< time when noise fell below threshold, or -1 if not reached
+  TCollection_AsciiString StopReason;      //!< "samples", "time" or "noise"
+
+  OcctProgressiveResult() : NbSamples (0), Time (0.0), Noise (-1.0), TimeToThreshold (-1.0) {}
+};
+
+//! Progressive path tracing of still images into offscreen framebuffer.
+//! Each redraw of unchanged scene accumulates one more sample per pixel;
+//! image is read back only at checkpoints placed at doubling sample counts (e.g. 16, 32, 64, ...),
+//! where noise is estimated as RMS difference from the previous checkpoint
+//! (as the latter contains half of the samples, the difference approximates standard deviation of the current image).
+//! Rendering stops on the first of sample count, time budget or noise threshold criteria,
+//! so that batch jobs have predictable upper cost.
+//! Rendering fails when ray tracing is not supported by OpenGL context
+//! or when two checkpoints are identical (OpenGl_View falls back to rasterization without reporting an error).
+class OcctProgressiveRenderer
+{
+public:
+
+  //! Empty constructor.
+  OcctProgressiveRenderer();
+
+  //! Set maximum number of samples per pixel; 1024 by default.
+  void SetMaxSamples (int theNbSamples) { myMaxSamples = theNbSamples; }
+
+  //! Set time budget in seconds; 0 (default) means no limit.
+  void SetTimeBudget (double theSeconds) { myTimeBudget = theSeconds; }
+
+  //! Set noise threshold within [0, 1] color range; 0 disables convergence criterion; 0.005 by default.
+  void SetNoiseThreshold (double theThreshold) { myNoiseThreshold = theThreshold; }
+
+  //! Set number of samples of the first checkpoint; 16 by default.
+  void SetFirstCheckpoint (int theNbSamples) { myFirstCheckpoint = theNbSamples; }
+
+  //! Set path prefix of intermediate images saved at checkpoints as "<prefix>_<samples>.png"; empty (default) to skip.
+  void SetCheckpointPrefix (const TCollection_AsciiString& thePrefix) { myCheckpointPrefix = thePrefix; }
+
+  //! Set maximum ray depth; 8 by default.
+  void SetRayDepth (int theDepth) { myRayDepth = theDepth; }
+
+  //! Return result of the last rendering.
+  const OcctProgressiveResult& Result() const { return myResult; }
+
+  //! Render view into image file.
+  //! View should be of the same dimensions as image to keep camera aspect (and accumulated samples) unchanged.
+  //! Rendering parameters of the view are restored afterwards.
+  //! @param[in] theView    view with displayed scene
+  //! @param[in] theSize    image dimensions
+  //! @param[in] theOutPath final image path
+  bool Perform (const Handle(V3d_View)& theView,
+                const Graphic3d_Vec2i& theSize,
+                const TCollection_AsciiString& theOutPath);
+
+  //! Print samples per second and convergence statistics.
+  void DumpStats (const Graphic3d_Vec2i& theSize) const;
+
+private:
+
+  TCollection_AsciiString myCheckpointPrefix; //!< path prefix of intermediate images
+  OcctProgressiveResult   myResult;           //!< result of the last rendering
+  double                  myTimeBudget;       //!< time budget in seconds
+  double                  myNoiseThreshold;   //!< noise threshold
+  int                     myMaxSamples;       //!< maximum number of samples per pixel
+  int                     myFirstCheckpoint;  //!< samples of the first checkpoint
+  int                     myRayDepth;         //!< maximum ray depth
+
+};
+
+#endif // _OcctProgressiveRenderer_HeaderFile
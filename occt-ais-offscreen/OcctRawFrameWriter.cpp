@@ -0,0 +1,250 @@
+#include "OcctRawFrameWriter.hxx"
+
+#include <Message.hxx>
+
+#include <cstring>
+
+#ifdef _WIN32
+  #include <fcntl.h>
+  #include <io.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+  //! Shared memory ring magic.
+  static const char THE_RING_MAGIC[8] = { 'O', 'C', 'C', 'T', 'F', 'B', '2', '\0' };
+
+  //! Offset of slot sequence counters within shared memory ring.
+  static const size_t THE_RING_HEADER_SIZE = 64;
+}
+
+// Parse format name.
+bool OcctRawFrameWriter::FormatFromString (const TCollection_AsciiString& theName,
+                                           OcctRawFrameFormat& theFormat)
+{
+  TCollection_AsciiString aName (theName);
+  aName.LowerCase();
+  if (aName == "rgba")
+  {
+    theFormat = OcctRawFrameFormat_RGBA;
+  }
+  else if (aName == "rgb")
+  {
+    theFormat = OcctRawFrameFormat_RGB;
+  }
+  else if (aName == "depth")
+  {
+    theFormat = OcctRawFrameFormat_Depth;
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+// Return buffer type to dump.
+Graphic3d_BufferType OcctRawFrameWriter::BufferType (OcctRawFrameFormat theFormat)
+{
+  switch (theFormat)
+  {
+    case OcctRawFrameFormat_RGBA:  return Graphic3d_BT_RGBA;
+    case OcctRawFrameFormat_RGB:   return Graphic3d_BT_RGB;
+    case OcctRawFrameFormat_Depth: return Graphic3d_BT_Depth;
+  }
+  return Graphic3d_BT_RGBA;
+}
+
+// Return image format of dumped buffer.
+Image_Format OcctRawFrameWriter::ImageFormat (OcctRawFrameFormat theFormat)
+{
+  switch (theFormat)
+  {
+    case OcctRawFrameFormat_RGBA:  return Image_Format_RGBA;
+    case OcctRawFrameFormat_RGB:   return Image_Format_RGB;
+    case OcctRawFrameFormat_Depth: return Image_Format_GrayF;
+  }
+  return Image_Format_RGBA;
+}
+
+// Empty constructor.
+OcctRawFrameWriter::OcctRawFrameWriter()
+: myFile (NULL), myRing (NULL), myRingSize (0), myFrameSize (0), myRowSize (0), myNbFrames (0), myIsStdout (false)
+{
+  //
+}
+
+// Open output target.
+bool OcctRawFrameWriter::Open (const TCollection_AsciiString& theTarget,
+                               OcctRawFrameFormat theFormat,
+                               const Graphic3d_Vec2i& theSize,
+                               int theNbSlots)
+{
+  Close();
+  myRowSize   = Image_PixMap::SizePixelBytes (ImageFormat (theFormat)) * theSize.x();
+  myFrameSize = myRowSize * theSize.y();
+  myNbFrames  = 0;
+  if (theTarget == "-")
+  {
+  #ifdef _WIN32
+    _setmode (_fileno (stdout), _O_BINARY);
+  #endif
+    myFile = stdout;
+    myIsStdout = true;
+    return true;
+  }
+  else if (theTarget.Search ("shm:") == 1)
+  {
+  #ifdef _WIN32
+    Message::SendFail() << "Error: shared memory output is not implemented on this platform";
+    (void )theNbSlots;
+    return false;
+  #else
+    // frames are aligned to cache line after slot sequence counters
+    const size_t aFramesOffset = THE_RING_HEADER_SIZE + ((sizeof(uint64_t) * theNbSlots + 63) / 64) * 64;
+    myShmName  = theTarget.SubString (5, theTarget.Length());
+    myRingSize = aFramesOffset + myFrameSize * theNbSlots;
+    const int aShm = shm_open (myShmName.ToCString(), O_CREAT | O_RDWR, 0600);
+    if (aShm == -1
+     || ftruncate (aShm, (off_t )myRingSize) != 0)
+    {
+      Message::SendFail() << "Error: unable to create shared memory '" << myShmName << "'";
+      if (aShm != -1)
+      {
+        ::close (aShm);
+      }
+      myShmName.Clear();
+      return false;
+    }
+
+    void* aData = mmap (NULL, myRingSize, PROT_READ | PROT_WRITE, MAP_SHARED, aShm, 0);
+    ::close (aShm);
+    if (aData == MAP_FAILED)
+    {
+      Message::SendFail() << "Error: unable to map shared memory '" << myShmName << "'";
+      shm_unlink (myShmName.ToCString());
+      myShmName.Clear();
+      return false;
+    }
+
+    myRing = (OcctRawFrameRingHeader* )aData;
+    memcpy (myRing->Magic, THE_RING_MAGIC, sizeof(THE_RING_MAGIC));
+    myRing->Width     = (uint32_t )theSize.x();
+    myRing->Height    = (uint32_t )theSize.y();
+    myRing->Format    = (uint32_t )theFormat;
+    myRing->NbSlots   = (uint32_t )theNbSlots;
+    myRing->FrameSize = myFrameSize;
+    myRing->FramesOffset = aFramesOffset;
+    for (int aSlotIter = 0; aSlotIter < theNbSlots; ++aSlotIter)
+    {
+      myRing->SlotSequences()[aSlotIter].store (0, std::memory_order_relaxed);
+    }
+    myRing->FrameCounter.store (0, std::memory_order_release);
+    return true;
+  #endif
+  }
+
+  myFile = fopen (theTarget.ToCString(), "wb");
+  if (myFile == NULL)
+  {
+    Message::SendFail() << "Error: unable to open file '" << theTarget << "'";
+    return false;
+  }
+  return true;
+}
+
+// Write frame.
+bool OcctRawFrameWriter::Write (const Image_PixMap& theImage)
+{
+  if (theImage.SizeRowBytes() * theImage.SizeY() < myFrameSize
+   || theImage.SizeX() * theImage.SizePixelBytes() != myRowSize)
+  {
+    Message::SendFail() << "Error: frame doesn't match raw output format";
+    return false;
+  }
+
+  // rows are copied as is, unless image has row padding
+  const bool isPacked = theImage.SizeRowBytes() == myRowSize;
+  if (myRing != NULL)
+  {
+    const uint64_t aCounter = myRing->FrameCounter.load (std::memory_order_relaxed);
+    const uint64_t aSlotIndex = aCounter % myRing->NbSlots;
+    uint8_t* aSlot = (uint8_t* )myRing + myRing->FramesOffset + aSlotIndex * myFrameSize;
+
+    // odd sequence marks slot being written; release fence keeps it ordered before frame data
+    std::atomic<uint64_t>& aSequence = myRing->SlotSequences()[aSlotIndex];
+    aSequence.store (2 * aCounter + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+    if (isPacked)
+    {
+      memcpy (aSlot, theImage.Data(), myFrameSize);
+    }
+    else
+    {
+      for (size_t aRow = 0; aRow < theImage.SizeY(); ++aRow)
+      {
+        memcpy (aSlot + aRow * myRowSize, theImage.Data() + aRow * theImage.SizeRowBytes(), myRowSize);
+      }
+    }
+    aSequence.store (2 * aCounter + 2, std::memory_order_release);
+    myRing->FrameCounter.store (aCounter + 1, std::memory_order_release);
+    ++myNbFrames;
+    return true;
+  }
+
+  if (myFile == NULL)
+  {
+    return false;
+  }
+  bool isDone = true;
+  if (isPacked)
+  {
+    isDone = fwrite (theImage.Data(), 1, myFrameSize, myFile) == myFrameSize;
+  }
+  else
+  {
+    for (size_t aRow = 0; aRow < theImage.SizeY() && isDone; ++aRow)
+    {
+      isDone = fwrite (theImage.Data() + aRow * theImage.SizeRowBytes(), 1, myRowSize, myFile) == myRowSize;
+    }
+  }
+  if (!isDone)
+  {
+    Message::SendFail() << "Error: unable to write raw frame";
+    return false;
+  }
+  ++myNbFrames;
+  return true;
+}
+
+// Close output.
+void OcctRawFrameWriter::Close()
+{
+  if (myFile != NULL)
+  {
+    if (myIsStdout)
+    {
+      fflush (myFile);
+    }
+    else
+    {
+      fclose (myFile);
+    }
+    myFile = NULL;
+    myIsStdout = false;
+  }
+#ifndef _WIN32
+  if (myRing != NULL)
+  {
+    // shared memory object is kept for consumers; it should be removed by shm_unlink() when no more needed
+    munmap (myRing, myRingSize);
+    myRing = NULL;
+    myRingSize = 0;
+  }
+#endif
+  myShmName.Clear();
+}
@@ -0,0 +1,115 @@
+#ifndef _OcctRawFrameWriter_HeaderFile
+#define _OcctRawFrameWriter_HeaderFile
+
+#include <Graphic3d_BufferType.hxx>
+#include <Graphic3d_Vec2.hxx>
+#include <Image_PixMap.hxx>
+#include <TCollection_AsciiString.hxx>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+//! Raw frame format.
+enum OcctRawFrameFormat
+{
+  OcctRawFrameFormat_RGBA,  //!< 8-bit RGBA color
+  OcctRawFrameFormat_RGB,   //!< 8-bit RGB color
+  OcctRawFrameFormat_Depth  //!< 32-bit float depth within [0, 1] range
+};
+
+//! Header of shared memory ring of raw frames.
+//! Frame N is stored within slot (N % NbSlots) at offset FramesOffset + (N % NbSlots) * FrameSize;
+//! FrameCounter is incremented after frame data has been written, so that consumer reads frame (FrameCounter - 1).
+//!
+//! Header is followed (at offset 64) by NbSlots sequence counters of slots (seqlock),
+//! as writer might overwrite the slot being copied by consumer lagging behind by NbSlots frames.
+//! Writer sets counter to 2 * N + 1 before writing frame N into the slot and to 2 * N + 2 afterwards.
+//! Consumer reading frame N should:
+//! 1. load slot sequence (acquire) and skip the frame if it is not equal to 2 * N + 2 (frame is being written or already overwritten);
+//! 2. copy frame data;
+//! 3. issue acquire fence and load slot sequence once again; the copy is torn and should be discarded if it has changed.
+struct OcctRawFrameRingHeader
+{
+  char                  Magic[8];     //!< "OCCTFB2"
+  uint32_t              Width;        //!< frame width
+  uint32_t              Height;       //!< frame height
+  uint32_t              Format;       //!< OcctRawFrameFormat
+  uint32_t              NbSlots;      //!< number of frame slots
+  uint64_t              FrameSize;    //!< frame size in bytes
+  uint64_t              FramesOffset; //!< offset of the first frame slot (after slot sequence counters)
+  std::atomic<uint64_t> FrameCounter; //!< number of written frames
+
+  //! Return sequence counters of slots following the header.
+  std::atomic<uint64_t>* SlotSequences() { return (std::atomic<uint64_t>* )((char* )this + 64); }
+};
+
+//! Writer of raw frames read back from OpenGL without any format conversion.
+//! Rows are stored in bottom-up order as returned by OpenGL (use "-vf vflip" within ffmpeg or flip array in consumer).
+//! Output target might be:
+//! - "-" for standard output (pipe);
+//! - "shm:/name" for POSIX shared memory ring of frames;
+//! - file path or named pipe (FIFO) path; frames are appended one after another.
+class OcctRawFrameWriter
+{
+public:
+
+  //! Parse format name ("rgba", "rgb", "depth").
+  static bool FormatFromString (const TCollection_AsciiString& theName,
+                                OcctRawFrameFormat& theFormat);
+
+  //! Return buffer type to dump.
+  static Graphic3d_BufferType BufferType (OcctRawFrameFormat theFormat);
+
+  //! Return image format of dumped buffer.
+  static Image_Format ImageFormat (OcctRawFrameFormat theFormat);
+
+public:
+
+  //! Empty constructor.
+  OcctRawFrameWriter();
+
+  //! Destructor.
+  ~OcctRawFrameWriter() { Close(); }
+
+  //! Return size of a single frame in bytes.
+  size_t FrameSize() const { return myFrameSize; }
+
+  //! Return number of written frames.
+  uint64_t NbFrames() const { return myNbFrames; }
+
+  //! Open output target.
+  //! @param[in] theTarget  "-", "shm:/name" or file path
+  //! @param[in] theFormat  frame format
+  //! @param[in] theSize    frame dimensions
+  //! @param[in] theNbSlots number of frames within shared memory ring
+  bool Open (const TCollection_AsciiString& theTarget,
+             OcctRawFrameFormat theFormat,
+             const Graphic3d_Vec2i& theSize,
+             int theNbSlots = 4);
+
+  //! Write frame; image should have format and dimensions specified by Open().
+  bool Write (const Image_PixMap& theImage);
+
+  //! Close output.
+  void Close();
+
+private:
+
+  OcctRawFrameWriter (const OcctRawFrameWriter& ) = delete;
+  OcctRawFrameWriter& operator= (const OcctRawFrameWriter& ) = delete;
+
+private:
+
+  TCollection_AsciiString myShmName;   //!< shared memory name
+  FILE*                   myFile;      //!< output file or pipe
+  OcctRawFrameRingHeader* myRing;      //!< mapped shared memory ring
+  size_t                  myRingSize;  //!< mapped shared memory size
+  size_t                  myFrameSize; //!< frame size in bytes
+  size_t                  myRowSize;   //!< row size in bytes
+  uint64_t                myNbFrames;  //!< number of written frames
+  bool                    myIsStdout;  //!< writing to standard output
+
+};
+
+#endif // _OcctRawFrameWriter_HeaderFile
@@ -0,0 +1,624 @@
+#include "OcctRenderServer.hxx"
+
+#include <Message.hxx>
+#include <OSD_Timer.hxx>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+  #include <fcntl.h>
+  #include <io.h>
+#else
+  #include <signal.h>
+  #include <sys/socket.h>
+  #include <sys/stat.h>
+  #include <sys/un.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+  //! Camera orientation names.
+  static const struct { const char* Name; V3d_TypeOfOrientation Orient; } THE_PROJ_NAMES[] =
+  {
+    { "axoright", V3d_TypeOfOrientation_Zup_AxoRight },
+    { "axoleft",  V3d_TypeOfOrientation_Zup_AxoLeft },
+    { "front",    V3d_TypeOfOrientation_Zup_Front },
+    { "back",     V3d_TypeOfOrientation_Zup_Back },
+    { "top",      V3d_TypeOfOrientation_Zup_Top },
+    { "bottom",   V3d_TypeOfOrientation_Zup_Bottom },
+    { "left",     V3d_TypeOfOrientation_Zup_Left },
+    { "right",    V3d_TypeOfOrientation_Zup_Right }
+  };
+
+  //! Fill in error reply.
+  static bool replyError (std::string& theReply, const TCollection_AsciiString& theMessage)
+  {
+    theReply = std::string ("error ") + theMessage.ToCString() + "\n";
+    return true;
+  }
+
+#ifndef _WIN32
+  //! Write all bytes into socket.
+  static bool writeSocket (int theSocket, const char* theData, size_t theSize)
+  {
+    while (theSize > 0)
+    {
+      const ssize_t aNbWritten = ::send (theSocket, theData, theSize, 0);
+      if (aNbWritten <= 0)
+      {
+        return false;
+      }
+      theData += aNbWritten;
+      theSize -= (size_t )aNbWritten;
+    }
+    return true;
+  }
+
+  //! Buffered reader of lines and binary payloads from socket.
+  class MySocketReader
+  {
+  public:
+
+    //! Main constructor.
+    MySocketReader (int theSocket) : mySocket (theSocket) {}
+
+    //! Read next line without line break.
+    bool ReadLine (std::string& theLine)
+    {
+      for (;;)
+      {
+        const size_t anEnd = myBuffer.find ('\n');
+        if (anEnd != std::string::npos)
+        {
+          theLine.assign (myBuffer, 0, anEnd);
+          myBuffer.erase (0, anEnd + 1);
+          if (!theLine.empty() && theLine.back() == '\r')
+          {
+            theLine.pop_back();
+          }
+          return true;
+        }
+        if (!fill())
+        {
+          return false;
+        }
+      }
+    }
+
+    //! Read specified number of bytes.
+    bool ReadBytes (size_t theSize, std::string& theData)
+    {
+      while (myBuffer.size() < theSize)
+      {
+        if (!fill())
+        {
+          return false;
+        }
+      }
+      theData.assign (myBuffer, 0, theSize);
+      myBuffer.erase (0, theSize);
+      return true;
+    }
+
+  private:
+
+    //! Receive next portion of data.
+    bool fill()
+    {
+      char aBuffer[65536];
+      const ssize_t aNbRead = ::recv (mySocket, aBuffer, sizeof(aBuffer), 0);
+      if (aNbRead <= 0)
+      {
+        return false;
+      }
+      myBuffer.append (aBuffer, (size_t )aNbRead);
+      return true;
+    }
+
+  private:
+
+    std::string myBuffer;
+    int         mySocket;
+
+  };
+
+  //! Fill in socket address; return FALSE if path is too long.
+  static bool fillSocketAddress (sockaddr_un& theAddr, const TCollection_AsciiString& thePath)
+  {
+    memset (&theAddr, 0, sizeof(theAddr));
+    theAddr.sun_family = AF_UNIX;
+    if ((size_t )thePath.Length() >= sizeof(theAddr.sun_path))
+    {
+      Message::SendFail() << "Error: socket path '" << thePath << "' is too long";
+      return false;
+    }
+    strcpy (theAddr.sun_path, thePath.ToCString());
+    return true;
+  }
+#endif
+}
+
+// Main constructor.
+OcctRenderServer::OcctRenderServer (size_t theCacheBudget, int thePrsCacheSize)
+: myModelCache (theCacheBudget),
+  myTotalTime (0.0), myNbRequests (0), myNbFailed (0), myNbPrsHits (0),
+  myToStop (false), myListenSocket (-1)
+{
+  myPool.SetPrsCacheSize (thePrsCacheSize);
+}
+
+// Find resident model or load a new one.
+bool OcctRenderServer::findModel (const TCollection_AsciiString& theName,
+                                  TCollection_AsciiString& theId,
+                                  TopoDS_Shape& theShape,
+                                  TCollection_AsciiString& theError)
+{
+  if (theName.Search ("#") == 1)
+  {
+    // model id is a content hash returned by previous request
+    theId = theName;
+    if (!myModelCache.FindKey (theName.SubString (2, theName.Length()), theShape))
+    {
+      theError = TCollection_AsciiString ("model '") + theName + "' is not resident";
+      return false;
+    }
+    return true;
+  }
+
+  TCollection_AsciiString aKey;
+  if (!myModelCache.Find (theName, aKey, theShape, theError))
+  {
+    return false;
+  }
+  theId = TCollection_AsciiString ("#") + aKey;
+  return true;
+}
+
+// Add request to statistics.
+void OcctRenderServer::addStats (double theTime, bool theIsDone, bool theIsPrsCached)
+{
+  std::lock_guard<std::mutex> aLock (myStatsMutex);
+  myTotalTime += theTime;
+  ++myNbRequests;
+  if (!theIsDone)
+  {
+    ++myNbFailed;
+  }
+  if (theIsPrsCached)
+  {
+    ++myNbPrsHits;
+  }
+}
+
+// Print statistics of processed requests.
+void OcctRenderServer::DumpStats() const
+{
+  std::lock_guard<std::mutex> aLock (myStatsMutex);
+  Message::SendInfo() << "Served " << myNbRequests << " render requests (" << myNbFailed << " failed), mean time "
+                      << (myNbRequests != 0 ? myTotalTime * 1000.0 / myNbRequests : 0.0) << " ms, "
+                      << myNbPrsHits << " reused presentations";
+  myModelCache.DumpStats();
+}
+
+// Process a single request line.
+bool OcctRenderServer::HandleRequest (const TCollection_AsciiString& theRequest,
+                                      std::string& theReply)
+{
+  TCollection_AsciiString aCmd = theRequest.Token (" \t", 1);
+  aCmd.LowerCase();
+  if (aCmd == "render")
+  {
+    OSD_Timer aTimer;
+    aTimer.Start();
+    bool isPrsCached = false;
+    const bool isDone = handleRender (theRequest, theReply, isPrsCached);
+    addStats (aTimer.ElapsedTime(), isDone, isPrsCached);
+    return true;
+  }
+  else if (aCmd == "load")
+  {
+    TCollection_AsciiString anId, anError;
+    TopoDS_Shape aShape;
+    if (!findModel (theRequest.Token (" \t", 2), anId, aShape, anError))
+    {
+      return replyError (theReply, anError);
+    }
+    theReply = std::string ("ok ") + anId.ToCString() + "\n";
+    return true;
+  }
+  else if (aCmd == "stats")
+  {
+    const OcctModelCacheStats aCacheStats = myModelCache.Stats();
+    std::lock_guard<std::mutex> aLock (myStatsMutex);
+    std::ostringstream aReply;
+    aReply << "ok " << myNbRequests << " " << myNbFailed << " "
+           << (myNbRequests != 0 ? myTotalTime * 1000.0 / myNbRequests : 0.0) << " "
+           << aCacheStats.NbHits << " " << aCacheStats.NbMisses << " " << aCacheStats.NbEvictions << " "
+           << aCacheStats.NbEntries << " " << aCacheStats.Memory << "\n";
+    theReply = aReply.str();
+    return true;
+  }
+  else if (aCmd == "quit")
+  {
+    theReply.clear();
+    return false;
+  }
+  else if (aCmd == "shutdown")
+  {
+    stopServing();
+    theReply.clear();
+    return false;
+  }
+  else if (aCmd.IsEmpty())
+  {
+    theReply.clear();
+    return true;
+  }
+  return replyError (theReply, TCollection_AsciiString ("unknown command '") + aCmd + "'");
+}
+
+// Stop serving.
+void OcctRenderServer::stopServing()
+{
+  std::lock_guard<std::mutex> aLock (myClientsMutex);
+  myToStop = true;
+#ifndef _WIN32
+  const int aListenSocket = myListenSocket;
+  if (aListenSocket != -1)
+  {
+    // unblock accept() within serving thread
+    ::shutdown (aListenSocket, SHUT_RDWR);
+  }
+  for (int aSocket : myClientSockets)
+  {
+    // unblock recv() of idle connections; sockets are closed by their threads
+    ::shutdown (aSocket, SHUT_RDWR);
+  }
+#endif
+}
+
+// Parse and execute render request.
+bool OcctRenderServer::handleRender (const TCollection_AsciiString& theRequest,
+                                     std::string& theReply,
+                                     bool& theIsPrsCached)
+{
+  OcctRenderJob aJob;
+  TCollection_AsciiString aModelName = theRequest.Token (" \t", 2), aFormat ("png");
+  for (int aTokenIter = 3;; ++aTokenIter)
+  {
+    const TCollection_AsciiString aToken = theRequest.Token (" \t", aTokenIter);
+    if (aToken.IsEmpty())
+    {
+      break;
+    }
+
+    const int aSepPos = aToken.Search ("=");
+    if (aSepPos <= 1)
+    {
+      replyError (theReply, TCollection_AsciiString ("syntax error at '") + aToken + "'");
+      return false;
+    }
+
+    TCollection_AsciiString aKey = aToken.SubString (1, aSepPos - 1);
+    const TCollection_AsciiString aValue = aSepPos < aToken.Length() ? aToken.SubString (aSepPos + 1, aToken.Length()) : TCollection_AsciiString();
+    aKey.LowerCase();
+    if (aKey == "proj")
+    {
+      TCollection_AsciiString aProjName (aValue);
+      aProjName.LowerCase();
+      bool isFound = false;
+      for (const auto& aProj : THE_PROJ_NAMES)
+      {
+        if (aProjName == aProj.Name)
+        {
+          aJob.Orientation = aProj.Orient;
+          isFound = true;
+          break;
+        }
+      }
+      if (!isFound)
+      {
+        replyError (theReply, TCollection_AsciiString ("unknown projection '") + aValue + "'");
+        return false;
+      }
+    }
+    else if (aKey == "size")
+    {
+      aJob.Size.SetValues (aValue.Token ("x", 1).IntegerValue(), aValue.Token ("x", 2).IntegerValue());
+      if (aJob.Size.x() <= 0 || aJob.Size.y() <= 0)
+      {
+        replyError (theReply, TCollection_AsciiString ("invalid image size '") + aValue + "'");
+        return false;
+      }
+    }
+    else if (aKey == "format")
+    {
+      aFormat = aValue;
+      aFormat.LowerCase();
+    }
+    else if (aKey == "out")
+    {
+      aJob.OutputPath = aValue;
+    }
+    else
+    {
+      replyError (theReply, TCollection_AsciiString ("unknown parameter '") + aKey + "'");
+      return false;
+    }
+  }
+
+  TCollection_AsciiString anId, anError;
+  if (!findModel (aModelName, anId, aJob.Shape, anError))
+  {
+    replyError (theReply, anError);
+    return false;
+  }
+
+  aJob.ModelKey = anId;
+  const OcctRenderResult aResult = myPool.Submit (aJob).get();
+  theIsPrsCached = aResult.IsPrsCached;
+  if (!aResult.IsDone)
+  {
+    replyError (theReply, "rendering failed");
+    return false;
+  }
+  if (!aJob.OutputPath.IsEmpty())
+  {
+    theReply = std::string ("ok file ") + aJob.OutputPath.ToCString() + "\n";
+    return true;
+  }
+
+  std::ostringstream anImageStream;
+  if (!aResult.Image->Save (anImageStream, aFormat))
+  {
+    replyError (theReply, TCollection_AsciiString ("unable to encode image into '") + aFormat + "'");
+    return false;
+  }
+
+  const std::string anImageData = anImageStream.str();
+  theReply = std::string ("ok ") + aFormat.ToCString() + " " + std::to_string (anImageData.size()) + "\n";
+  theReply += anImageData;
+  return true;
+}
+
+// Serve requests from standard input.
+int OcctRenderServer::ServeStdio()
+{
+#ifdef _WIN32
+  _setmode (_fileno (stdout), _O_BINARY);
+#endif
+  std::string aLine, aReply;
+  while (!myToStop && std::getline (std::cin, aLine))
+  {
+    if (!aLine.empty() && aLine.back() == '\r')
+    {
+      aLine.pop_back();
+    }
+    const bool toContinue = HandleRequest (aLine.c_str(), aReply);
+    std::cout.write (aReply.data(), aReply.size());
+    std::cout.flush();
+    if (!toContinue)
+    {
+      break;
+    }
+  }
+  DumpStats();
+  return 0;
+}
+
+// Serve requests from local Unix socket.
+int OcctRenderServer::ServeSocket (const TCollection_AsciiString& thePath)
+{
+#ifdef _WIN32
+  Message::SendFail() << "Error: Unix socket server is not implemented on this platform; use stdio mode";
+  (void )thePath;
+  return 1;
+#else
+  // broken client connections should not terminate the server
+  signal (SIGPIPE, SIG_IGN);
+
+  sockaddr_un anAddr;
+  if (!fillSocketAddress (anAddr, thePath))
+  {
+    return 1;
+  }
+
+  // only stale socket of previous run is removed - mistyped path should not delete unrelated file
+  struct stat aStat;
+  if (::lstat (thePath.ToCString(), &aStat) == 0)
+  {
+    if (!S_ISSOCK(aStat.st_mode))
+    {
+      Message::SendFail() << "Error: '" << thePath << "' exists and is not a socket";
+      return 1;
+    }
+    ::unlink (thePath.ToCString());
+  }
+
+  const int aListenSocket = ::socket (AF_UNIX, SOCK_STREAM, 0);
+  if (aListenSocket == -1
+   || ::bind (aListenSocket, (const sockaddr* )&anAddr, sizeof(anAddr)) != 0
+   || ::listen (aListenSocket, 64) != 0)
+  {
+    Message::SendFail() << "Error: unable to listen socket '" << thePath << "'";
+    if (aListenSocket != -1)
+    {
+      ::close (aListenSocket);
+    }
+    return 1;
+  }
+
+  // published for stopServing() called from connection threads
+  myListenSocket = aListenSocket;
+
+  Message::SendInfo() << "Listening on '" << thePath << "' with " << myPool.NbWorkers() << " offscreen viewers";
+  while (!myToStop)
+  {
+    const int aSocket = ::accept (aListenSocket, NULL, NULL);
+    if (aSocket == -1)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      break;
+    }
+
+    // connection is registered under the same lock as stopServing(), so that it is either rejected or shut down
+    std::lock_guard<std::mutex> aLock (myClientsMutex);
+    if (myToStop)
+    {
+      ::close (aSocket);
+      break;
+    }
+    myClientSockets.push_back (aSocket);
+    std::thread (&OcctRenderServer::serveClient, this, aSocket).detach();
+  }
+
+  // wait for connection threads instead of joining them, so that finished threads do not pile up
+  {
+    std::unique_lock<std::mutex> aLock (myClientsMutex);
+    myClientsCond.wait (aLock, [this]() { return myClientSockets.empty(); });
+  }
+  myListenSocket = -1;
+  ::close (aListenSocket);
+  ::unlink (thePath.ToCString());
+  DumpStats();
+  return 0;
+#endif
+}
+
+// Serve client connection.
+void OcctRenderServer::serveClient (int theSocket)
+{
+#ifndef _WIN32
+  {
+    MySocketReader aReader (theSocket);
+    std::string aLine, aReply;
+    while (aReader.ReadLine (aLine))
+    {
+      const bool toContinue = HandleRequest (aLine.c_str(), aReply);
+      if (!writeSocket (theSocket, aReply.data(), aReply.size())
+       || !toContinue)
+      {
+        break;
+      }
+    }
+  }
+
+  // the last access to the server object, which is destroyed once all connections are closed
+  std::lock_guard<std::mutex> aLock (myClientsMutex);
+  ::close (theSocket);
+  myClientSockets.erase (std::find (myClientSockets.begin(), myClientSockets.end(), theSocket));
+  myClientsCond.notify_all();
+#else
+  (void )theSocket;
+#endif
+}
+
+// Run test client.
+int OcctRenderServer::RunClient (const TCollection_AsciiString& theSocketPath,
+                                 int theNbClients,
+                                 int theNbRequests,
+                                 const TCollection_AsciiString& theModel,
+                                 const Graphic3d_Vec2i& theSize)
+{
+#ifdef _WIN32
+  Message::SendFail() << "Error: Unix socket client is not implemented on this platform";
+  (void )theSocketPath; (void )theNbClients; (void )theNbRequests; (void )theModel; (void )theSize;
+  return 1;
+#else
+  signal (SIGPIPE, SIG_IGN);
+  sockaddr_un anAddr;
+  if (!fillSocketAddress (anAddr, theSocketPath))
+  {
+    return 1;
+  }
+
+  std::vector<std::vector<double>> aLatencies (theNbClients);
+  std::vector<int> aNbFailed (theNbClients, 0);
+  std::vector<std::thread> aThreads;
+  OSD_Timer aTimer;
+  aTimer.Start();
+  for (int aClientIter = 0; aClientIter < theNbClients; ++aClientIter)
+  {
+    aThreads.emplace_back ([&, aClientIter]()
+    {
+      const int aSocket = ::socket (AF_UNIX, SOCK_STREAM, 0);
+      if (aSocket == -1
+       || ::connect (aSocket, (const sockaddr* )&anAddr, sizeof(anAddr)) != 0)
+      {
+        aNbFailed[aClientIter] = theNbRequests;
+        if (aSocket != -1)
+        {
+          ::close (aSocket);
+        }
+        return;
+      }
+
+      static const char* THE_PROJS[4] = { "axoright", "axoleft", "front", "top" };
+      MySocketReader aReader (aSocket);
+      std::string aLine, aData;
+      for (int aReqIter = 0; aReqIter < theNbRequests; ++aReqIter)
+      {
+        std::ostringstream aRequest;
+        aRequest << "render " << theModel.ToCString() << " proj=" << THE_PROJS[aReqIter % 4]
+                 << " size=" << theSize.x() << "x" << theSize.y() << "\n";
+        const std::string aRequestStr = aRequest.str();
+
+        OSD_Timer aReqTimer;
+        aReqTimer.Start();
+        if (!writeSocket (aSocket, aRequestStr.data(), aRequestStr.size())
+         || !aReader.ReadLine (aLine))
+        {
+          aNbFailed[aClientIter] += theNbRequests - aReqIter;
+          break;
+        }
+
+        // reply is "ok <format> <nbBytes>" followed by image bytes
+        const TCollection_AsciiString aReply (aLine.c_str());
+        if (aReply.Token (" ", 1) != "ok"
+        || !aReader.ReadBytes ((size_t )aReply.Token (" ", 3).IntegerValue(), aData))
+        {
+          ++aNbFailed[aClientIter];
+          continue;
+        }
+        aLatencies[aClientIter].push_back (aReqTimer.ElapsedTime() * 1000.0);
+      }
+      writeSocket (aSocket, "quit\n", 5);
+      ::close (aSocket);
+    });
+  }
+  for (std::thread& aThread : aThreads)
+  {
+    aThread.join();
+  }
+  aTimer.Stop();
+
+  std::vector<double> anAll;
+  int aNbFailedTotal = 0;
+  for (int aClientIter = 0; aClientIter < theNbClients; ++aClientIter)
+  {
+    anAll.insert (anAll.end(), aLatencies[aClientIter].begin(), aLatencies[aClientIter].end());
+    aNbFailedTotal += aNbFailed[aClientIter];
+  }
+  if (anAll.empty())
+  {
+    Message::SendFail() << "Error: no successful requests to '" << theSocketPath << "'";
+    return 1;
+  }
+
+  std::sort (anAll.begin(), anAll.end());
+  const size_t aNbDone = anAll.size();
+  Message::SendInfo() << theNbClients << " clients, " << aNbDone << " requests in " << aTimer.ElapsedTime() << " s ("
+                      << aNbDone / aTimer.ElapsedTime() << " requests/s), " << aNbFailedTotal << " failed\n"
+                      << "Latency p50 " << anAll[(aNbDone - 1) / 2] << " ms, p99 " << anAll[(size_t )((aNbDone - 1) * 0.99)]
+                      << " ms, max " << anAll.back() << " ms";
+  return aNbFailedTotal == 0 ? 0 : 1;
+#endif
+}
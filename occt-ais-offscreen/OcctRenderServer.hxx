@@ -0,0 +1,122 @@
+#ifndef _OcctRenderServer_HeaderFile
+#define _OcctRenderServer_HeaderFile
+
+#include "OcctModelCache.hxx"
+#include "OcctOffscreenPool.hxx"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//! Local render server keeping a pool of offscreen viewers warm between requests.
+//! Requests are text lines, one request per line:
+//! - "load <path>" loads model and replies "ok <id>";
+//! - "render <model> [proj=axoright|axoleft|front|back|top|bottom|left|right] [size=WxH] [format=png|jpg|bmp] [out=<path>]"
+//!   replies "ok file <path>" when output path is specified,
+//!   or "ok <format> <nbBytes>" line followed by encoded image bytes;
+//! - "stats" replies "ok <nbRequests> <nbFailed> <meanMs> <cacheHits> <cacheMisses> <cacheEvictions> <nbModels> <cacheBytes>";
+//! - "quit" closes connection, "shutdown" stops the server.
+//! Model is a BREP file path, id returned by "load" ("#<contentHash>") or "sample:N" built-in shape.
+//! Models are kept within LRU cache (OcctModelCache), and each worker keeps presentations of recently rendered models.
+//! Errors are replied as "error <message>".
+class OcctRenderServer
+{
+public:
+
+  //! Run test client sending concurrent requests to Unix socket and reporting request latency.
+  //! @param[in] theSocketPath  server socket path
+  //! @param[in] theNbClients   number of concurrent connections
+  //! @param[in] theNbRequests  number of requests per connection
+  //! @param[in] theModel       model to render
+  //! @param[in] theSize        image dimensions
+  //! @return process exit code
+  static int RunClient (const TCollection_AsciiString& theSocketPath,
+                        int theNbClients,
+                        int theNbRequests,
+                        const TCollection_AsciiString& theModel,
+                        const Graphic3d_Vec2i& theSize);
+
+public:
+
+  //! Main constructor.
+  //! @param[in] theCacheBudget  memory budget of model cache in bytes
+  //! @param[in] thePrsCacheSize number of presentations kept by each worker
+  OcctRenderServer (size_t theCacheBudget, int thePrsCacheSize);
+
+  //! Start pool of offscreen viewers.
+  bool Start (int theNbWorkers) { return myPool.Start (theNbWorkers); }
+
+  //! Return OpenGL renderer name.
+  const TCollection_AsciiString& GlRenderer() const { return myPool.GlRenderer(); }
+
+  //! Serve requests from standard input, writing replies to standard output.
+  //! Messages are expected to be redirected to standard error by caller.
+  //! @return process exit code
+  int ServeStdio();
+
+  //! Serve requests from local Unix socket; each connection is handled by a dedicated detached thread.
+  //! "shutdown" request closes all open connections, and method returns once their threads are finished.
+  //! @return process exit code
+  int ServeSocket (const TCollection_AsciiString& thePath);
+
+  //! Process a single request line; thread-safe.
+  //! @param[in]  theRequest request line
+  //! @param[out] theReply   reply line and optional binary payload
+  //! @return FALSE if connection should be closed
+  bool HandleRequest (const TCollection_AsciiString& theRequest,
+                      std::string& theReply);
+
+  //! Print statistics of processed requests.
+  void DumpStats() const;
+
+private:
+
+  //! Find resident model or load a new one.
+  //! @param[in]  theName  model path, id or sample name
+  //! @param[out] theId    model id
+  //! @param[out] theShape model shape
+  //! @param[out] theError error message
+  bool findModel (const TCollection_AsciiString& theName,
+                  TCollection_AsciiString& theId,
+                  TopoDS_Shape& theShape,
+                  TCollection_AsciiString& theError);
+
+  //! Parse and execute render request.
+  bool handleRender (const TCollection_AsciiString& theRequest,
+                     std::string& theReply,
+                     bool& theIsPrsCached);
+
+  //! Add request to statistics.
+  void addStats (double theTime, bool theIsDone, bool theIsPrsCached);
+
+  //! Stop serving: unblock accept() and shut down open client connections.
+  void stopServing();
+
+  //! Serve client connection within dedicated thread.
+  void serveClient (int theSocket);
+
+private:
+
+  OcctRenderServer (const OcctRenderServer& ) = delete;
+  OcctRenderServer& operator= (const OcctRenderServer& ) = delete;
+
+private:
+
+  OcctOffscreenPool  myPool;         //!< pool of offscreen viewers
+  OcctModelCache     myModelCache;   //!< resident models
+  mutable std::mutex myStatsMutex;   //!< lock for statistics
+  double             myTotalTime;    //!< total time of processed render requests
+  int                myNbRequests;   //!< number of processed render requests
+  int                myNbFailed;     //!< number of failed render requests
+  int                myNbPrsHits;    //!< number of render requests reused worker presentation
+  std::mutex              myClientsMutex;   //!< lock for client connections
+  std::condition_variable myClientsCond;    //!< signals closing of client connection
+  std::vector<int>        myClientSockets;  //!< open client connections
+  std::atomic<bool>       myToStop;         //!< flag to stop serving
+  std::atomic<int>        myListenSocket;   //!< listening socket
+
+};
+
+#endif // _OcctRenderServer_HeaderFile
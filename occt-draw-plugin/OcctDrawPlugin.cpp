@@ -1,3 +1,5 @@
+#include "OcctDrawPlugin.hxx"
+
 #include <Draw.hxx>
 #include <Draw_Drawable3D.hxx>
 #include <Draw_Interpretor.hxx>
@@ -5,16 +7,6 @@
 #include <DBRep_DrawableShape.hxx>
 #include <Message.hxx>
 
-//! Class defining static method 'Factory()' for 'DPLUGIN' macros.
-class OcctDrawPlugin
-{
-public:
-  DEFINE_STANDARD_ALLOC
-
-  //! Add commands to Draw_Interpretor.
-  static void Factory (Draw_Interpretor& theDI);
-};
-
 //! Command just printing "hello" message.
 static int myhello (Draw_Interpretor& theDI,
                     int theNbArgs, const char** theArgVec)
@@ -130,6 +122,10 @@ void OcctDrawPlugin::Factory (Draw_Interpretor& theDI)
 
   theDI.Add ("mydrawable", "mydrawable name [-create]",
              __FILE__, mydrawable, aGroup);
+
+  ProfileCommands (theDI);
+  ImportCommands (theDI);
+  PointCloudCommands (theDI);
 }
 
 // Implement exported function that will be called by DRAWEXE on loading plugin
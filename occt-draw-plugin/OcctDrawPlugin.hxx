@@ -0,0 +1,25 @@
+#ifndef _OcctDrawPlugin_HeaderFile
+#define _OcctDrawPlugin_HeaderFile
+
+#include <Draw_Interpretor.hxx>
+
+//! Class defining static method 'Factory()' for 'DPLUGIN' macros.
+class OcctDrawPlugin
+{
+public:
+  DEFINE_STANDARD_ALLOC
+
+  //! Add commands to Draw_Interpretor.
+  static void Factory (Draw_Interpretor& theDI);
+
+  //! Add commands for timing and memory profiling of Tcl scripts.
+  static void ProfileCommands (Draw_Interpretor& theDI);
+
+  //! Add commands for parallel import of STEP/XBF files into XCAF documents.
+  static void ImportCommands (Draw_Interpretor& theDI);
+
+  //! Add commands for loading and analysis of large point clouds.
+  static void PointCloudCommands (Draw_Interpretor& theDI);
+};
+
+#endif // _OcctDrawPlugin_HeaderFile
@@ -0,0 +1,327 @@
+#include "OcctDrawPlugin.hxx"
+
+#include <BinXCAFDrivers.hxx>
+#include <BinXCAFDrivers_DocumentRetrievalDriver.hxx>
+#include <DDocStd.hxx>
+#include <DDocStd_DrawDocument.hxx>
+#include <Draw.hxx>
+#include <Draw_Interpretor.hxx>
+#include <Message.hxx>
+#include <Message_PrinterOStream.hxx>
+#include <OSD_File.hxx>
+#include <OSD_FileIterator.hxx>
+#include <OSD_Parallel.hxx>
+#include <OSD_Path.hxx>
+#include <OSD_ThreadPool.hxx>
+#include <OSD_Timer.hxx>
+#include <Standard_ErrorHandler.hxx>
+#include <STEPCAFControl_Controller.hxx>
+#include <STEPCAFControl_Reader.hxx>
+#include <TDataStd_Name.hxx>
+#include <TDocStd_Application.hxx>
+#include <TDocStd_Document.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+//! Import task and its results.
+struct MyImportTask
+{
+  TCollection_AsciiString  FilePath; //!< input file path
+  TCollection_AsciiString  DocName;  //!< name of Draw variable
+  Handle(TDocStd_Document) Document; //!< imported document
+  TCollection_AsciiString  Error;    //!< error message
+  double FileSizeMiB;                //!< input file size in MiB
+  double ElapsedSec;                 //!< import time in seconds
+  int    NbRoots;                    //!< number of free shapes
+  int    ThreadIndex;                //!< index of worker thread
+
+  MyImportTask() : FileSizeMiB (0.0), ElapsedSec (0.0), NbRoots (0), ThreadIndex (-1) {}
+};
+
+//! Functor importing files in worker threads.
+//! Documents are created in advance within main thread by Draw application,
+//! while workers only read files (own reader per file) and fill the documents.
+class MyImportFunctor
+{
+public:
+  MyImportFunctor (std::vector<MyImportTask>& theTasks,
+                   const Handle(TDocStd_Application)& theApp)
+  : myTasks (theTasks), myApp (theApp) {}
+
+  void operator() (int theThreadIndex, int theTaskIndex) const
+  {
+    MyImportTask& aTask = myTasks[theTaskIndex];
+    aTask.ThreadIndex = theThreadIndex;
+
+    OSD_Timer aTimer;
+    aTimer.Start();
+    try
+    {
+      OCC_CATCH_SIGNALS
+      TCollection_AsciiString anExt;
+      const int aDotPos = aTask.FilePath.SearchFromEnd (".");
+      if (aDotPos > 0) { anExt = aTask.FilePath.SubString (aDotPos + 1, aTask.FilePath.Length()); }
+      anExt.LowerCase();
+      if (anExt == "xbf")
+      {
+        // TDocStd_Application::Open() would create and register another document in application session,
+        // which is not thread-safe; own retrieval driver reads file into already created document instead
+        Handle(BinXCAFDrivers_DocumentRetrievalDriver) aDriver = new BinXCAFDrivers_DocumentRetrievalDriver();
+        aDriver->Read (TCollection_ExtendedString (aTask.FilePath, true), aTask.Document, myApp);
+        if (aDriver->GetStatus() != PCDM_RS_OK)
+        {
+          aTask.Error = "unable to open XBF file";
+        }
+      }
+      else
+      {
+        // reader is destroyed right after transfer to release STEP model
+        STEPCAFControl_Reader aReader;
+        aReader.SetColorMode (true);
+        aReader.SetNameMode (true);
+        aReader.SetLayerMode (true);
+        if (aReader.ReadFile (aTask.FilePath.ToCString()) != IFSelect_RetDone)
+        {
+          aTask.Error = "unable to read STEP file";
+        }
+        else if (!aReader.Transfer (aTask.Document))
+        {
+          aTask.Error = "STEP translation failed";
+        }
+      }
+    }
+    catch (const Standard_Failure& theErr)
+    {
+      aTask.Error = TCollection_AsciiString ("exception ") + theErr.GetMessageString();
+    }
+    aTimer.Stop();
+    aTask.ElapsedSec = aTimer.ElapsedTime();
+
+    if (!aTask.Error.IsEmpty())
+    {
+      return;
+    }
+
+    TDF_LabelSequence aRoots;
+    XCAFDoc_DocumentTool::ShapeTool (aTask.Document->Main())->GetFreeShapes (aRoots);
+    aTask.NbRoots = aRoots.Length();
+  }
+
+private:
+  std::vector<MyImportTask>& myTasks;
+  Handle(TDocStd_Application) myApp;
+};
+
+//! Temporary redirection of default messenger to standard output;
+//! original printers are restored on destruction (including exceptions).
+class MyStdoutPrintersGuard
+{
+public:
+  //! Main constructor.
+  MyStdoutPrintersGuard()
+  : myMessenger (Message::DefaultMessenger()),
+    myPrinters (Message::DefaultMessenger()->Printers())
+  {
+    myMessenger->ChangePrinters().Clear();
+    myMessenger->AddPrinter (new Message_PrinterOStream (Message_Fail));
+  }
+
+  //! Destructor restoring printers.
+  ~MyStdoutPrintersGuard() { myMessenger->ChangePrinters() = myPrinters; }
+
+private:
+  MyStdoutPrintersGuard (const MyStdoutPrintersGuard& ) = delete;
+  MyStdoutPrintersGuard& operator= (const MyStdoutPrintersGuard& ) = delete;
+
+private:
+  Handle(Message_Messenger)  myMessenger;
+  Message_SequenceOfPrinters myPrinters;
+};
+
+//! Expand file path with '*' or '?' wildcards in file name into sorted list of files.
+static bool expandFilePattern (const TCollection_AsciiString& thePattern,
+                               std::vector<TCollection_AsciiString>& theFiles)
+{
+  if (thePattern.Search ("*") == -1
+   && thePattern.Search ("?") == -1)
+  {
+    theFiles.push_back (thePattern);
+    return true;
+  }
+
+  TCollection_AsciiString aFolder, aMask;
+  OSD_Path::FolderAndFileFromPath (thePattern, aFolder, aMask);
+  if (aFolder.IsEmpty()) { aFolder = "."; }
+  if (aFolder.Search ("*") != -1
+   || aFolder.Search ("?") != -1)
+  {
+    return false; // wildcards are supported only within file name
+  }
+
+  const char aLastChar = aFolder.Value (aFolder.Length());
+  if (aLastChar != '/' && aLastChar != '\\') { aFolder += "/"; }
+
+  std::vector<TCollection_AsciiString> aFiles;
+  const OSD_Path aFolderPath (aFolder);
+  for (OSD_FileIterator aFileIter (aFolderPath, aMask); aFileIter.More(); aFileIter.Next())
+  {
+    OSD_Path aPath;
+    aFileIter.Values().Path (aPath);
+    TCollection_AsciiString aName;
+    aPath.SystemName (aName);
+    aFiles.push_back (aFolder + aName);
+  }
+  std::sort (aFiles.begin(), aFiles.end(),
+             [](const TCollection_AsciiString& theLeft, const TCollection_AsciiString& theRight)
+             { return theLeft.IsLess (theRight); });
+  theFiles.insert (theFiles.end(), aFiles.begin(), aFiles.end());
+  return true;
+}
+
+//! Format real value with limited precision.
+static TCollection_AsciiString formatReal (double theValue)
+{
+  char aBuff[64];
+  std::snprintf (aBuff, sizeof(aBuff), "%.3f", theValue);
+  return TCollection_AsciiString (aBuff);
+}
+
+//! Command importing STEP/XBF files concurrently into separate XCAF documents.
+static int myimport (Draw_Interpretor& theDI,
+                     int theNbArgs, const char** theArgVec)
+{
+  int aNbThreads = OSD_Parallel::NbLogicalProcessors();
+  int aNbInFlight = -1;
+  TCollection_AsciiString aPrefix ("D");
+  std::vector<TCollection_AsciiString> aFiles;
+  for (int anArgIter = 1; anArgIter < theNbArgs; ++anArgIter)
+  {
+    TCollection_AsciiString anArg (theArgVec[anArgIter]);
+    anArg.LowerCase();
+    if ((anArg == "-threads" || anArg == "-nbthreads")
+     && anArgIter + 1 < theNbArgs)
+    {
+      aNbThreads = Draw::Atoi (theArgVec[++anArgIter]);
+      if (aNbThreads < 1)
+      {
+        theDI << "Syntax error: wrong number of threads";
+        return 1;
+      }
+    }
+    else if ((anArg == "-inflight" || anArg == "-maxinflight")
+          && anArgIter + 1 < theNbArgs)
+    {
+      aNbInFlight = Draw::Atoi (theArgVec[++anArgIter]);
+      if (aNbInFlight < 1)
+      {
+        theDI << "Syntax error: wrong number of files in flight";
+        return 1;
+      }
+    }
+    else if (anArg == "-prefix"
+          && anArgIter + 1 < theNbArgs)
+    {
+      aPrefix = theArgVec[++anArgIter];
+    }
+    else if (!expandFilePattern (theArgVec[anArgIter], aFiles))
+    {
+      theDI << "Syntax error: unsupported file pattern '" << theArgVec[anArgIter] << "'";
+      return 1;
+    }
+  }
+  if (aFiles.empty())
+  {
+    theDI << "Syntax error: no files to import";
+    return 1;
+  }
+
+  // each worker keeps a single file in flight, so that limiting workers limits peak memory of readers
+  std::vector<MyImportTask> aTasks (aFiles.size());
+  for (size_t aFileIter = 0; aFileIter < aFiles.size(); ++aFileIter)
+  {
+    MyImportTask& aTask = aTasks[aFileIter];
+    aTask.FilePath = aFiles[aFileIter];
+    aTask.DocName  = aFiles.size() == 1 ? aPrefix : aPrefix + "_" + int(aFileIter + 1);
+    OSD_File aFile (OSD_Path (aTask.FilePath));
+    aTask.FileSizeMiB = aFile.Exists() ? double(aFile.Size()) / (1024.0 * 1024.0) : 0.0;
+  }
+  int aNbWorkers = std::min (aNbThreads, (int )aTasks.size());
+  if (aNbInFlight > 0) { aNbWorkers = std::min (aNbWorkers, aNbInFlight); }
+
+  // initialize translator and create documents by Draw application within main thread,
+  // so that they could be closed by regular Close command;
+  // dedicated pool is used to respect requested number of threads exceeding default pool size
+  STEPCAFControl_Controller::Init();
+  Handle(TDocStd_Application) anApp = DDocStd::GetApplication();
+  BinXCAFDrivers::DefineFormat (anApp);
+  for (MyImportTask& aTask : aTasks)
+  {
+    anApp->NewDocument (TCollection_ExtendedString ("BinXCAF"), aTask.Document);
+  }
+  Handle(OSD_ThreadPool) aPool = new OSD_ThreadPool (aNbWorkers);
+  OSD_ThreadPool::Launcher aLauncher (*aPool, aNbWorkers);
+
+  // Draw printers put messages into Tcl result, which cannot be done from worker threads;
+  // temporarily redirect translator messages to standard output
+  OSD_Timer aTimer;
+  {
+    MyStdoutPrintersGuard aPrintersGuard;
+    aTimer.Start();
+    aLauncher.Perform (0, (int )aTasks.size(), MyImportFunctor (aTasks, anApp));
+    aTimer.Stop();
+  }
+
+  // register documents within main thread
+  int aNbFailed = 0;
+  double aTotalMiB = 0.0, aSumSec = 0.0;
+  for (const MyImportTask& aTask : aTasks)
+  {
+    theDI << aTask.DocName << ": '" << aTask.FilePath << "' " << formatReal (aTask.FileSizeMiB) << " MiB";
+    if (!aTask.Error.IsEmpty())
+    {
+      ++aNbFailed;
+      anApp->Close (aTask.Document);
+      theDI << " Error: " << aTask.Error << "\n";
+      continue;
+    }
+
+    Handle(DDocStd_DrawDocument) aDrawDoc = new DDocStd_DrawDocument (aTask.Document);
+    TDataStd_Name::Set (aTask.Document->GetData()->Root(), aTask.DocName.ToCString());
+    Draw::Set (aTask.DocName.ToCString(), aDrawDoc);
+
+    aTotalMiB += aTask.FileSizeMiB;
+    aSumSec   += aTask.ElapsedSec;
+    theDI << " in " << formatReal (aTask.ElapsedSec) << " s"
+          << " (" << formatReal (aTask.ElapsedSec > 0.0 ? aTask.FileSizeMiB / aTask.ElapsedSec : 0.0) << " MiB/s)"
+          << " roots " << aTask.NbRoots << " thread " << aTask.ThreadIndex << "\n";
+  }
+
+  const double aWallSec = aTimer.ElapsedTime();
+  theDI << "Imported " << int(aTasks.size()) - aNbFailed << " of " << int(aTasks.size()) << " files"
+        << " (" << formatReal (aTotalMiB) << " MiB) using " << aLauncher.NbThreads() << " threads"
+        << " in " << formatReal (aWallSec) << " s: "
+        << formatReal (aWallSec > 0.0 ? aTotalMiB / aWallSec : 0.0) << " MiB/s, speedup "
+        << formatReal (aWallSec > 0.0 ? aSumSec / aWallSec : 0.0) << "\n";
+  return aNbFailed == 0 ? 0 : 1;
+}
+
+// Add data exchange commands to Draw_Interpretor.
+void OcctDrawPlugin::ImportCommands (Draw_Interpretor& theDI)
+{
+  const char* aGroup = "My data exchange commands";
+  theDI.Add ("myimport",
+             "myimport [-threads N=NbLogicalProcessors] [-inflight N] [-prefix D] file1 [file2 ...]"
+             "\n\t\t: Imports STEP (by extension .stp/.step) and XBF (.xbf) files concurrently"
+             "\n\t\t: into separate XCAF documents named prefix_1, prefix_2 and so on"
+             "\n\t\t: (or just prefix for a single file), and prints per-file and aggregate throughput."
+             "\n\t\t: File name may contain '*' and '?' wildcards, e.g. 'models/*.stp'."
+             "\n\t\t:  -threads  number of worker threads, each having own reader;"
+             "\n\t\t:  -inflight maximum number of files being imported at the same time,"
+             "\n\t\t:            limiting peak memory consumed by readers;"
+             "\n\t\t:  -prefix   prefix of document names.",
+             __FILE__, myimport, aGroup);
+}
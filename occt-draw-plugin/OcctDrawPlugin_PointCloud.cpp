@@ -0,0 +1,472 @@
+#include "OcctDrawPlugin.hxx"
+
+#include "OcctPointCloud.hxx"
+
+#include <Draw.hxx>
+#include <Draw_Display.hxx>
+#include <Draw_Drawable3D.hxx>
+#include <Draw_Interpretor.hxx>
+#include <OSD_File.hxx>
+#include <OSD_Parallel.hxx>
+#include <OSD_Path.hxx>
+#include <OSD_Timer.hxx>
+#include <math_BullardGenerator.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+//! Drawable holding a point cloud.
+//! Only a limited number of points is drawn in axonometric viewer to keep Draw responsive.
+class MyPointCloudDrawable : public Draw_Drawable3D
+{
+  DEFINE_STANDARD_RTTI_INLINE(MyPointCloudDrawable, Draw_Drawable3D)
+public:
+  //! Maximum number of points drawn in Draw viewer.
+  static const int64_t THE_MAX_DRAWN_POINTS = 100000;
+
+  //! Main constructor.
+  MyPointCloudDrawable (const Handle(OcctPointCloud)& theCloud) : myCloud (theCloud) {}
+
+  //! Return point cloud.
+  const Handle(OcctPointCloud)& PointCloud() const { return myCloud; }
+
+  //! Draw subset of points in axonometric viewer.
+  virtual void DrawOn (Draw_Display& theDisp) const override
+  {
+    const int64_t aNbPoints = myCloud->NbPoints();
+    const int64_t aStep = std::max (int64_t(1), aNbPoints / THE_MAX_DRAWN_POINTS);
+    theDisp.SetColor (Draw_Color (Draw_jaune));
+    for (int64_t aPntIter = 0; aPntIter < aNbPoints; aPntIter += aStep)
+    {
+      theDisp.DrawMarker (myCloud->Point (aPntIter), Draw_Plus, 1);
+    }
+  }
+
+  //! Variable dump.
+  virtual void Dump (Standard_OStream& theStream) const override
+  {
+    theStream << "MyPointCloudDrawable: " << myCloud->NbPoints() << " points"
+              << (myCloud->HasNormals() ? ", normals" : "")
+              << (myCloud->HasColors()  ? ", colors"  : "")
+              << (myCloud->HasIndex()   ? ", indexed" : "")
+              << (myCloud->IsMapped()   ? ", mapped"  : "")
+              << ", " << (myCloud->MemorySize() / (1024 * 1024)) << " MiB";
+  }
+
+  //! For whatis command.
+  virtual void Whatis (Draw_Interpretor& theDI) const override { theDI << "point cloud"; }
+
+private:
+  Handle(OcctPointCloud) myCloud;
+};
+
+//! Find point cloud drawable.
+static Handle(OcctPointCloud) findPointCloud (Draw_Interpretor& theDI, const char* theName)
+{
+  const char* aNameStr = theName;
+  Handle(MyPointCloudDrawable) aDrawable = Handle(MyPointCloudDrawable)::DownCast (Draw::Get (aNameStr));
+  if (aDrawable.IsNull())
+  {
+    theDI << "Error: point cloud '" << theName << "' not found";
+    return Handle(OcctPointCloud)();
+  }
+  return aDrawable->PointCloud();
+}
+
+//! Format real value with limited precision.
+static TCollection_AsciiString formatReal (double theValue)
+{
+  char aBuff[64];
+  std::snprintf (aBuff, sizeof(aBuff), "%.6g", theValue);
+  return TCollection_AsciiString (aBuff);
+}
+
+//! Format throughput line.
+static TCollection_AsciiString formatThroughput (int64_t theNbItems, const char* theItemName, double theSeconds)
+{
+  return TCollection_AsciiString() + formatReal (double(theNbItems)) + " " + theItemName
+       + " in " + formatReal (theSeconds) + " s: "
+       + formatReal (theSeconds > 0.0 ? double(theNbItems) / theSeconds / 1.0e6 : 0.0) + " M" + theItemName + "/s";
+}
+
+//! Command loading point cloud from file.
+static int mypcload (Draw_Interpretor& theDI,
+                     int theNbArgs, const char** theArgVec)
+{
+  if (theNbArgs != 3)
+  {
+    theDI << "Syntax error: wrong number of arguments";
+    return 1;
+  }
+
+  const TCollection_AsciiString aFilePath (theArgVec[2]);
+  Handle(OcctPointCloud) aCloud = new OcctPointCloud();
+  OSD_Timer aTimer;
+  aTimer.Start();
+  if (!aCloud->Load (aFilePath))
+  {
+    theDI << "Error: unable to load point cloud from '" << aFilePath << "'";
+    return 1;
+  }
+  aTimer.Stop();
+
+  Draw::Set (theArgVec[1], new MyPointCloudDrawable (aCloud));
+  OSD_File aFile (OSD_Path (aFilePath));
+  const double aFileSizeMiB = double(aFile.Size()) / (1024.0 * 1024.0);
+  theDI << "Loaded " << formatThroughput (aCloud->NbPoints(), "points", aTimer.ElapsedTime())
+        << ", " << formatReal (aTimer.ElapsedTime() > 0.0 ? aFileSizeMiB / aTimer.ElapsedTime() : 0.0) << " MiB/s"
+        << (aCloud->IsMapped() ? " (memory-mapped)" : "");
+  return 0;
+}
+
+//! Command saving point cloud into native binary file.
+static int mypcsave (Draw_Interpretor& theDI,
+                     int theNbArgs, const char** theArgVec)
+{
+  if (theNbArgs != 3)
+  {
+    theDI << "Syntax error: wrong number of arguments";
+    return 1;
+  }
+
+  Handle(OcctPointCloud) aCloud = findPointCloud (theDI, theArgVec[1]);
+  if (aCloud.IsNull())
+  {
+    return 1;
+  }
+  TCollection_AsciiString aFilePath (theArgVec[2]);
+  aFilePath.LowerCase();
+  if (aFilePath.SearchFromEnd (".pcb") != aFilePath.Length() - 3)
+  {
+    theDI << "Error: point cloud could be saved only into .pcb file";
+    return 1;
+  }
+  if (!aCloud->Save (theArgVec[2]))
+  {
+    theDI << "Error: unable to save point cloud into '" << theArgVec[2] << "'";
+    return 1;
+  }
+  return 0;
+}
+
+//! Command generating random point cloud.
+static int mypcgenerate (Draw_Interpretor& theDI,
+                         int theNbArgs, const char** theArgVec)
+{
+  TCollection_AsciiString aName, aShape ("sphere");
+  int64_t aNbPoints = -1;
+  double aSize = 100.0;
+  int aSeed = 0;
+  bool hasNormals = false, hasColors = false;
+  for (int anArgIter = 1; anArgIter < theNbArgs; ++anArgIter)
+  {
+    TCollection_AsciiString anArg (theArgVec[anArgIter]);
+    anArg.LowerCase();
+    if (anArg == "-normals")
+    {
+      hasNormals = true;
+    }
+    else if (anArg == "-colors")
+    {
+      hasColors = true;
+    }
+    else if (anArg == "-shape"
+          && anArgIter + 1 < theNbArgs)
+    {
+      aShape = theArgVec[++anArgIter];
+      aShape.LowerCase();
+      if (aShape != "sphere" && aShape != "box")
+      {
+        theDI << "Syntax error: unknown shape '" << aShape << "'";
+        return 1;
+      }
+    }
+    else if (anArg == "-size"
+          && anArgIter + 1 < theNbArgs)
+    {
+      aSize = Draw::Atof (theArgVec[++anArgIter]);
+    }
+    else if (anArg == "-seed"
+          && anArgIter + 1 < theNbArgs)
+    {
+      aSeed = Draw::Atoi (theArgVec[++anArgIter]);
+    }
+    else if (aName.IsEmpty())
+    {
+      aName = theArgVec[anArgIter];
+    }
+    else if (aNbPoints == -1)
+    {
+      aNbPoints = (int64_t )Draw::Atof (theArgVec[anArgIter]);
+    }
+    else
+    {
+      theDI << "Syntax error at '" << theArgVec[anArgIter] << "'";
+      return 1;
+    }
+  }
+  if (aName.IsEmpty() || aNbPoints < 1)
+  {
+    theDI << "Syntax error: wrong number of arguments";
+    return 1;
+  }
+
+  OSD_Timer aTimer;
+  aTimer.Start();
+  Handle(OcctPointCloud) aCloud = new OcctPointCloud();
+  aCloud->Allocate (aNbPoints, hasNormals, hasColors);
+
+  // each chunk has own generator to produce the same cloud regardless of number of threads
+  const bool isSphere = aShape == "sphere";
+  const int64_t aChunkSize = 1 << 16;
+  const int aNbChunks = (int )((aNbPoints + aChunkSize - 1) / aChunkSize);
+  OSD_Parallel::For (0, aNbChunks, [&](int theChunkIndex)
+  {
+    math_BullardGenerator aRandom (aSeed + theChunkIndex);
+    const int64_t aFrom = int64_t(theChunkIndex) * aChunkSize;
+    const int64_t aTo   = std::min (aFrom + aChunkSize, aNbPoints);
+    for (int64_t aPntIter = aFrom; aPntIter < aTo; ++aPntIter)
+    {
+      gp_XYZ aPnt (aRandom.NextReal() - 0.5, aRandom.NextReal() - 0.5, aRandom.NextReal() - 0.5);
+      gp_XYZ aNorm (0.0, 0.0, 1.0);
+      if (isSphere)
+      {
+        const double aLen = aPnt.Modulus();
+        aNorm = aLen > 0.0 ? aPnt / aLen : aNorm;
+        aPnt = aNorm * 0.5;
+      }
+      aPnt *= aSize;
+      aCloud->ChangeX()[aPntIter] = (float )aPnt.X();
+      aCloud->ChangeY()[aPntIter] = (float )aPnt.Y();
+      aCloud->ChangeZ()[aPntIter] = (float )aPnt.Z();
+      if (hasNormals)
+      {
+        aCloud->ChangeNX()[aPntIter] = (float )aNorm.X();
+        aCloud->ChangeNY()[aPntIter] = (float )aNorm.Y();
+        aCloud->ChangeNZ()[aPntIter] = (float )aNorm.Z();
+      }
+      if (hasColors)
+      {
+        // color by position within the cube
+        const gp_XYZ aRgb = aPnt / aSize + gp_XYZ (0.5, 0.5, 0.5);
+        aCloud->ChangeColors()[aPntIter] = (uint32_t(aRgb.X() * 255.0) & 0xFF)
+                                        | ((uint32_t(aRgb.Y() * 255.0) & 0xFF) << 8)
+                                        | ((uint32_t(aRgb.Z() * 255.0) & 0xFF) << 16)
+                                        | 0xFF000000u;
+      }
+    }
+  });
+  aTimer.Stop();
+
+  Draw::Set (aName.ToCString(), new MyPointCloudDrawable (aCloud));
+  theDI << "Generated " << formatThroughput (aNbPoints, "points", aTimer.ElapsedTime());
+  return 0;
+}
+
+//! Command computing bounding box of point cloud.
+static int mypcbbox (Draw_Interpretor& theDI,
+                     int theNbArgs, const char** theArgVec)
+{
+  if (theNbArgs != 2)
+  {
+    theDI << "Syntax error: wrong number of arguments";
+    return 1;
+  }
+
+  Handle(OcctPointCloud) aCloud = findPointCloud (theDI, theArgVec[1]);
+  if (aCloud.IsNull())
+  {
+    return 1;
+  }
+
+  const Bnd_Box aBox = aCloud->BoundingBox();
+  if (aBox.IsVoid())
+  {
+    theDI << "Error: point cloud is empty";
+    return 1;
+  }
+
+  const gp_Pnt aMin = aBox.CornerMin(), aMax = aBox.CornerMax();
+  theDI << aMin.X() << " " << aMin.Y() << " " << aMin.Z() << " "
+        << aMax.X() << " " << aMax.Y() << " " << aMax.Z();
+  return 0;
+}
+
+//! Command computing downsampled point cloud.
+static int mypcvoxel (Draw_Interpretor& theDI,
+                      int theNbArgs, const char** theArgVec)
+{
+  if (theNbArgs != 4)
+  {
+    theDI << "Syntax error: wrong number of arguments";
+    return 1;
+  }
+
+  Handle(OcctPointCloud) aCloud = findPointCloud (theDI, theArgVec[2]);
+  if (aCloud.IsNull())
+  {
+    return 1;
+  }
+
+  const double aVoxelSize = Draw::Atof (theArgVec[3]);
+  if (aVoxelSize <= 0.0)
+  {
+    theDI << "Syntax error: wrong voxel size";
+    return 1;
+  }
+
+  OSD_Timer aTimer;
+  aTimer.Start();
+  Handle(OcctPointCloud) aResult = aCloud->VoxelDownsample (aVoxelSize);
+  aTimer.Stop();
+  if (aResult.IsNull())
+  {
+    theDI << "Error: unable to downsample point cloud";
+    return 1;
+  }
+
+  Draw::Set (theArgVec[1], new MyPointCloudDrawable (aResult));
+  theDI << "Downsampled " << formatThroughput (aCloud->NbPoints(), "points", aTimer.ElapsedTime())
+        << ", " << aResult->NbPoints() << " points in result";
+  return 0;
+}
+
+//! Command finding nearest points.
+static int mypcnearest (Draw_Interpretor& theDI,
+                        int theNbArgs, const char** theArgVec)
+{
+  if (theNbArgs < 2)
+  {
+    theDI << "Syntax error: wrong number of arguments";
+    return 1;
+  }
+
+  Handle(OcctPointCloud) aCloud = findPointCloud (theDI, theArgVec[1]);
+  if (aCloud.IsNull())
+  {
+    return 1;
+  }
+
+  gp_XYZ aQuery;
+  int aNbCoords = 0, aNbRandom = 0, aSeed = 0;
+  for (int anArgIter = 2; anArgIter < theNbArgs; ++anArgIter)
+  {
+    TCollection_AsciiString anArg (theArgVec[anArgIter]);
+    anArg.LowerCase();
+    if (anArg == "-random"
+     && anArgIter + 1 < theNbArgs)
+    {
+      aNbRandom = Draw::Atoi (theArgVec[++anArgIter]);
+    }
+    else if (anArg == "-seed"
+          && anArgIter + 1 < theNbArgs)
+    {
+      aSeed = Draw::Atoi (theArgVec[++anArgIter]);
+    }
+    else if (aNbCoords < 3
+          && Draw::ParseReal (theArgVec[anArgIter], aQuery.ChangeCoord (aNbCoords + 1)))
+    {
+      ++aNbCoords;
+    }
+    else
+    {
+      theDI << "Syntax error at '" << theArgVec[anArgIter] << "'";
+      return 1;
+    }
+  }
+  if ((aNbCoords != 3) == (aNbRandom <= 0))
+  {
+    theDI << "Syntax error: either query point or number of random queries should be specified";
+    return 1;
+  }
+
+  // index construction is reported after query results to keep them at the beginning of command result
+  TCollection_AsciiString anIndexInfo;
+  if (!aCloud->HasIndex())
+  {
+    OSD_Timer aTimer;
+    aTimer.Start();
+    aCloud->BuildIndex();
+    aTimer.Stop();
+    anIndexInfo = TCollection_AsciiString ("\nIndex: ") + formatThroughput (aCloud->NbPoints(), "points", aTimer.ElapsedTime());
+  }
+
+  if (aNbCoords == 3)
+  {
+    double aSqDist = 0.0;
+    const int64_t anIndex = aCloud->Nearest (gp_Pnt (aQuery), aSqDist);
+    if (anIndex == -1)
+    {
+      theDI << "Error: point cloud is empty";
+      return 1;
+    }
+    const gp_Pnt aPnt = aCloud->Point (anIndex);
+    theDI << anIndex << " " << std::sqrt (aSqDist) << " " << aPnt.X() << " " << aPnt.Y() << " " << aPnt.Z() << anIndexInfo;
+    return 0;
+  }
+
+  // random queries within bounding box in parallel
+  const Bnd_Box aBox = aCloud->BoundingBox();
+  const gp_XYZ aMin = aBox.CornerMin().XYZ(), aSize = aBox.CornerMax().XYZ() - aMin;
+  const int aChunkSize = 4096;
+  const int aNbChunks = (aNbRandom + aChunkSize - 1) / aChunkSize;
+  std::vector<double> aChunkDists (aNbChunks, 0.0);
+  OSD_Timer aTimer;
+  aTimer.Start();
+  OSD_Parallel::For (0, aNbChunks, [&](int theChunkIndex)
+  {
+    math_BullardGenerator aRandom (aSeed + theChunkIndex);
+    const int aFrom = theChunkIndex * aChunkSize;
+    const int aTo   = std::min (aFrom + aChunkSize, aNbRandom);
+    for (int aQueryIter = aFrom; aQueryIter < aTo; ++aQueryIter)
+    {
+      const gp_XYZ aPnt = aMin + gp_XYZ (aRandom.NextReal() * aSize.X(), aRandom.NextReal() * aSize.Y(), aRandom.NextReal() * aSize.Z());
+      double aSqDist = 0.0;
+      aCloud->Nearest (gp_Pnt (aPnt), aSqDist);
+      aChunkDists[theChunkIndex] += std::sqrt (aSqDist);
+    }
+  });
+  aTimer.Stop();
+
+  double aSumDist = 0.0;
+  for (double aDist : aChunkDists) { aSumDist += aDist; }
+  theDI << "Queried " << formatThroughput (aNbRandom, "queries", aTimer.ElapsedTime())
+        << ", mean distance " << formatReal (aSumDist / aNbRandom) << anIndexInfo;
+  return 0;
+}
+
+// Add point cloud commands to Draw_Interpretor.
+void OcctDrawPlugin::PointCloudCommands (Draw_Interpretor& theDI)
+{
+  const char* aGroup = "My point cloud commands";
+  theDI.Add ("mypcload",
+             "mypcload name file"
+             "\n\t\t: Loads point cloud from file: native binary .pcb (memory-mapped without copying),"
+             "\n\t\t: binary little-endian or ASCII .ply, or text .xyz/.pts/.txt with 'x y z [r g b]' per line.",
+             __FILE__, mypcload, aGroup);
+  theDI.Add ("mypcsave",
+             "mypcsave name file.pcb"
+             "\n\t\t: Saves point cloud into native binary file.",
+             __FILE__, mypcsave, aGroup);
+  theDI.Add ("mypcgenerate",
+             "mypcgenerate name nbPoints [-shape {sphere|box}=sphere] [-size Size=100] [-normals] [-colors] [-seed N=0]"
+             "\n\t\t: Generates random point cloud on sphere surface or within box.",
+             __FILE__, mypcgenerate, aGroup);
+  theDI.Add ("mypcbbox",
+             "mypcbbox name"
+             "\n\t\t: Returns bounding box of point cloud as 'xmin ymin zmin xmax ymax zmax'.",
+             __FILE__, mypcbbox, aGroup);
+  theDI.Add ("mypcvoxel",
+             "mypcvoxel result name voxelSize"
+             "\n\t\t: Computes downsampled point cloud with a single point (centroid) per voxel.",
+             __FILE__, mypcvoxel, aGroup);
+  theDI.Add ("mypcnearest",
+             "mypcnearest name {x y z | -random N [-seed S]}"
+             "\n\t\t: Finds the nearest point returning 'index distance x y z',"
+             "\n\t\t: or performs N random queries within bounding box in parallel to measure throughput."
+             "\n\t\t: Spatial index (kd-tree) is built on first call and its construction time"
+             "\n\t\t: is reported on a separate line after query results.",
+             __FILE__, mypcnearest, aGroup);
+}
@@ -0,0 +1,249 @@
+#include "OcctDrawPlugin.hxx"
+
+#include <Draw.hxx>
+#include <Draw_Interpretor.hxx>
+#include <OSD_Chronometer.hxx>
+#include <OSD_Environment.hxx>
+#include <OSD_MemInfo.hxx>
+#include <OSD_Timer.hxx>
+#include <Standard.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+//! Summary statistics of measured samples.
+struct MyProfileStats
+{
+  double Mean;
+  double Median;
+  double P95;
+  double StdDev;
+  double Min;
+  double Max;
+
+  MyProfileStats() : Mean (0.0), Median (0.0), P95 (0.0), StdDev (0.0), Min (0.0), Max (0.0) {}
+
+  //! Compute statistics from samples.
+  static MyProfileStats Compute (const std::vector<double>& theValues)
+  {
+    MyProfileStats aStats;
+    if (theValues.empty()) { return aStats; }
+
+    std::vector<double> aSorted (theValues);
+    std::sort (aSorted.begin(), aSorted.end());
+    const size_t aNb = aSorted.size();
+    aStats.Min = aSorted.front();
+    aStats.Max = aSorted.back();
+    aStats.Median = (aNb % 2 != 0) ? aSorted[aNb / 2] : 0.5 * (aSorted[aNb / 2 - 1] + aSorted[aNb / 2]);
+    aStats.P95 = aSorted[std::min (aNb - 1, (size_t )std::ceil (0.95 * double(aNb)) - 1)];
+    for (double aValue : aSorted) { aStats.Mean += aValue; }
+    aStats.Mean /= double(aNb);
+    for (double aValue : aSorted) { aStats.StdDev += (aValue - aStats.Mean) * (aValue - aStats.Mean); }
+    aStats.StdDev = aNb > 1 ? std::sqrt (aStats.StdDev / double(aNb - 1)) : 0.0;
+    return aStats;
+  }
+};
+
+//! Format real value with limited precision.
+static TCollection_AsciiString formatReal (double theValue)
+{
+  char aBuff[64];
+  std::snprintf (aBuff, sizeof(aBuff), "%.6g", theValue);
+  return TCollection_AsciiString (aBuff);
+}
+
+//! Format statistics as Tcl dictionary.
+static TCollection_AsciiString formatStats (const MyProfileStats& theStats)
+{
+  return TCollection_AsciiString()
+       + "mean "     + formatReal (theStats.Mean)
+       + " median "  + formatReal (theStats.Median)
+       + " p95 "     + formatReal (theStats.P95)
+       + " stddev "  + formatReal (theStats.StdDev)
+       + " min "     + formatReal (theStats.Min)
+       + " max "     + formatReal (theStats.Max);
+}
+
+//! Format memory counter in MiB; returns -1 for counters unavailable on this system.
+static TCollection_AsciiString formatMemory (Standard_Size theValue)
+{
+  return theValue != Standard_Size(-1)
+       ? formatReal (double(theValue) / (1024.0 * 1024.0))
+       : TCollection_AsciiString ("-1");
+}
+
+//! Return difference between memory counters in MiB.
+static TCollection_AsciiString formatMemoryDelta (Standard_Size theBefore, Standard_Size theAfter)
+{
+  if (theBefore == Standard_Size(-1) || theAfter == Standard_Size(-1)) { return "-1"; }
+  return formatReal ((double(theAfter) - double(theBefore)) / (1024.0 * 1024.0));
+}
+
+//! Return process CPU time (user + system of all threads) in seconds.
+static double processCpuTime()
+{
+  Standard_Real aUserSec = 0.0, aSystemSec = 0.0;
+  OSD_Chronometer::GetProcessCPU (aUserSec, aSystemSec);
+  return aUserSec + aSystemSec;
+}
+
+//! Reset peak resident set size of the process, if supported by the system.
+static bool resetPeakMemory()
+{
+#if defined(__linux__)
+  // writing "5" into clear_refs resets VmHWM counter (Linux 4.0+)
+  std::ofstream aFile ("/proc/self/clear_refs");
+  if (!aFile.is_open()) { return false; }
+  aFile << "5";
+  aFile.close();
+  return !aFile.fail();
+#else
+  return false;
+#endif
+}
+
+//! Return name of OCCT memory manager selected by MMGT_OPT environment variable.
+//! OCCT reads the variable once at startup, so the value should not be modified within the session.
+static const char* memoryManagerName()
+{
+  OSD_Environment aVarOpt ("MMGT_OPT");
+  const TCollection_AsciiString aValue = aVarOpt.Value();
+  if (aValue == "1") { return "optimized"; }
+  if (aValue == "2") { return "tbb"; }
+  return "raw";
+}
+
+//! Command measuring wall/CPU time and memory consumption of Tcl script.
+static int myprofile (Draw_Interpretor& theDI,
+                      int theNbArgs, const char** theArgVec)
+{
+  int aNbRepeats = 1, aNbWarmups = 0;
+  bool toPurge = false;
+  const char* aScript = NULL;
+  for (int anArgIter = 1; anArgIter < theNbArgs; ++anArgIter)
+  {
+    TCollection_AsciiString anArg (theArgVec[anArgIter]);
+    anArg.LowerCase();
+    if ((anArg == "-repeat" || anArg == "-repeats")
+     && anArgIter + 1 < theNbArgs)
+    {
+      aNbRepeats = Draw::Atoi (theArgVec[++anArgIter]);
+      if (aNbRepeats < 1)
+      {
+        theDI << "Syntax error: wrong number of repetitions";
+        return 1;
+      }
+    }
+    else if ((anArg == "-warmup" || anArg == "-warmups")
+          && anArgIter + 1 < theNbArgs)
+    {
+      aNbWarmups = Draw::Atoi (theArgVec[++anArgIter]);
+      if (aNbWarmups < 0)
+      {
+        theDI << "Syntax error: wrong number of warm-up runs";
+        return 1;
+      }
+    }
+    else if (anArg == "-purge")
+    {
+      toPurge = true;
+    }
+    else if (aScript == NULL)
+    {
+      aScript = theArgVec[anArgIter];
+    }
+    else
+    {
+      theDI << "Syntax error at '" << theArgVec[anArgIter] << "'";
+      return 1;
+    }
+  }
+  if (aScript == NULL)
+  {
+    theDI << "Syntax error: script is not specified";
+    return 1;
+  }
+
+  // warm-up runs are not measured
+  for (int aRunIter = 0; aRunIter < aNbWarmups; ++aRunIter)
+  {
+    if (theDI.Eval (aScript) != 0)
+    {
+      return 1; // keep error message of the script
+    }
+  }
+
+  if (toPurge) { Standard::Purge(); }
+  const bool isPeakReset = resetPeakMemory();
+  OSD_MemInfo aMemBefore (false);
+  aMemBefore.Update();
+
+  std::vector<double> aWallTimes, aCpuTimes;
+  aWallTimes.reserve (aNbRepeats);
+  aCpuTimes .reserve (aNbRepeats);
+  for (int aRunIter = 0; aRunIter < aNbRepeats; ++aRunIter)
+  {
+    OSD_Timer aTimer;
+    const double aCpuStart = processCpuTime();
+    aTimer.Start();
+    const int aRes = theDI.Eval (aScript);
+    aTimer.Stop();
+    const double aCpuEnd = processCpuTime();
+    if (aRes != 0)
+    {
+      return 1;
+    }
+    aWallTimes.push_back (aTimer.ElapsedTime());
+    aCpuTimes .push_back (aCpuEnd - aCpuStart);
+  }
+
+  OSD_MemInfo aMemAfter (false);
+  aMemAfter.Update();
+  const Standard_Size aPurged = toPurge ? (Standard_Size )Standard::Purge() : 0;
+
+  // replace result of the script by profiling results
+  theDI.Reset();
+  theDI << "repeat " << aNbRepeats << " warmup " << aNbWarmups
+        << " wall {" << formatStats (MyProfileStats::Compute (aWallTimes)) << "}"
+        << " cpu {"  << formatStats (MyProfileStats::Compute (aCpuTimes))  << "}"
+        << " rss_mb "         << formatMemory (aMemAfter.Value (OSD_MemInfo::MemWorkingSet))
+        << " rss_delta_mb "   << formatMemoryDelta (aMemBefore.Value (OSD_MemInfo::MemWorkingSet),
+                                                    aMemAfter .Value (OSD_MemInfo::MemWorkingSet))
+        << " rss_peak_mb "    << formatMemory (aMemAfter.Value (OSD_MemInfo::MemWorkingSetPeak))
+        << " rss_peak_reset " << (isPeakReset ? 1 : 0)
+        << " heap_mb "        << formatMemory (aMemAfter.Value (OSD_MemInfo::MemHeapUsage))
+        << " heap_delta_mb "  << formatMemoryDelta (aMemBefore.Value (OSD_MemInfo::MemHeapUsage),
+                                                    aMemAfter .Value (OSD_MemInfo::MemHeapUsage))
+        << " private_delta_mb " << formatMemoryDelta (aMemBefore.Value (OSD_MemInfo::MemPrivate),
+                                                      aMemAfter .Value (OSD_MemInfo::MemPrivate))
+        << " mmgr " << memoryManagerName();
+  if (toPurge)
+  {
+    theDI << " mmgr_purged_mb " << formatMemory (aPurged);
+  }
+  return 0;
+}
+
+// Add profiling commands to Draw_Interpretor.
+void OcctDrawPlugin::ProfileCommands (Draw_Interpretor& theDI)
+{
+  const char* aGroup = "My profiling commands";
+  theDI.Add ("myprofile",
+             "myprofile [-repeat N=1] [-warmup N=0] [-purge] script"
+             "\n\t\t: Evaluates Tcl script several times and returns dictionary with"
+             "\n\t\t: wall and CPU time statistics in seconds (mean, median, p95, stddev, min, max),"
+             "\n\t\t: resident memory, peak resident memory and heap usage changes in MiB."
+             "\n\t\t: Peak memory is reset before measurements where supported (rss_peak_reset=1)."
+             "\n\t\t: Value 'mmgr' is OCCT memory manager selected by MMGT_OPT environment variable at startup."
+             "\n\t\t: Allocation counts are not reported, as malloc cannot be interposed by dynamically loaded plugin;"
+             "\n\t\t: use heap_delta_mb or external tools (valgrind, heaptrack) to track allocations."
+             "\n\t\t:  -repeat number of measured runs;"
+             "\n\t\t:  -warmup number of runs before measurements;"
+             "\n\t\t:  -purge  release memory cached by OCCT memory manager before and after measurements."
+             "\n\t\t: Example:"
+             "\n\t\t:  set aRes [myprofile -repeat 5 {incmesh s 0.1}]; dict get $aRes wall median",
+             __FILE__, myprofile, aGroup);
+}
@@ -0,0 +1,136 @@
+#ifndef _OcctMappedFile_HeaderFile
+#define _OcctMappedFile_HeaderFile
+
+#include <TCollection_AsciiString.hxx>
+#include <TCollection_ExtendedString.hxx>
+
+#ifdef _WIN32
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#include <cstdint>
+
+//! Read-only memory-mapped file.
+//! Pages are loaded by the system on first access, so that mapping of a huge file is cheap
+//! and data could be parsed in parallel without intermediate buffers.
+class OcctMappedFile
+{
+public:
+
+  //! Empty constructor.
+  OcctMappedFile() : myData (NULL), mySize (0)
+  {
+  #ifdef _WIN32
+    myFile = INVALID_HANDLE_VALUE;
+    myMapping = NULL;
+  #endif
+  }
+
+  //! Destructor.
+  ~OcctMappedFile() { Close(); }
+
+  //! Return TRUE if file is mapped.
+  bool IsOpen() const { return myData != NULL; }
+
+  //! Return mapped data.
+  const char* Data() const { return myData; }
+
+  //! Return file size in bytes.
+  uint64_t Size() const { return mySize; }
+
+  //! Map file into memory.
+  //! @param[in] thePath file path in UTF-8
+  //! @return FALSE if file cannot be opened or is empty
+  bool Open (const TCollection_AsciiString& thePath)
+  {
+    Close();
+  #ifdef _WIN32
+    const TCollection_ExtendedString aPathW (thePath, true);
+    myFile = CreateFileW (aPathW.ToWideString(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (myFile == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER aSize;
+    if (!GetFileSizeEx (myFile, &aSize) || aSize.QuadPart == 0)
+    {
+      Close();
+      return false;
+    }
+    mySize = (uint64_t )aSize.QuadPart;
+    myMapping = CreateFileMappingW (myFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (myMapping == NULL)
+    {
+      Close();
+      return false;
+    }
+    myData = (const char* )MapViewOfFile (myMapping, FILE_MAP_READ, 0, 0, 0);
+  #else
+    const int aFile = ::open (thePath.ToCString(), O_RDONLY);
+    if (aFile == -1) { return false; }
+
+    struct stat aStat;
+    if (::fstat (aFile, &aStat) != 0 || aStat.st_size == 0)
+    {
+      ::close (aFile);
+      return false;
+    }
+    mySize = (uint64_t )aStat.st_size;
+    void* aData = ::mmap (NULL, (size_t )mySize, PROT_READ, MAP_PRIVATE, aFile, 0);
+    ::close (aFile); // mapping keeps its own reference to the file
+    if (aData == MAP_FAILED)
+    {
+      mySize = 0;
+      return false;
+    }
+    ::madvise (aData, (size_t )mySize, MADV_SEQUENTIAL);
+    myData = (const char* )aData;
+  #endif
+    if (myData == NULL)
+    {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  //! Unmap file.
+  void Close()
+  {
+  #ifdef _WIN32
+    if (myData != NULL)    { UnmapViewOfFile (myData); }
+    if (myMapping != NULL) { CloseHandle (myMapping); }
+    if (myFile != INVALID_HANDLE_VALUE) { CloseHandle (myFile); }
+    myFile = INVALID_HANDLE_VALUE;
+    myMapping = NULL;
+  #else
+    if (myData != NULL) { ::munmap ((void* )myData, (size_t )mySize); }
+  #endif
+    myData = NULL;
+    mySize = 0;
+  }
+
+private:
+
+  OcctMappedFile (const OcctMappedFile& ) = delete;
+  OcctMappedFile& operator= (const OcctMappedFile& ) = delete;
+
+private:
+
+  const char* myData; //!< mapped data
+  uint64_t    mySize; //!< file size
+#ifdef _WIN32
+  HANDLE      myFile;
+  HANDLE      myMapping;
+#endif
+
+};
+
+#endif // _OcctMappedFile_HeaderFile
@@ -0,0 +1,1034 @@
+#include "OcctPointCloud.hxx"
+
+#include "OcctMappedFile.hxx"
+
+#include <Message.hxx>
+#include <NCollection_LocalArray.hxx>
+#include <OSD_Parallel.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+
+namespace
+{
+  //! Header of native binary point cloud file (.pcb), followed by arrays
+  //! X[n], Y[n], Z[n], optional NX[n], NY[n], NZ[n] and optional RGBA[n].
+  struct PointCloudHeader
+  {
+    char     Magic[8];   //!< "OCCTPC1"
+    uint64_t NbPoints;   //!< number of points
+    uint32_t Flags;      //!< combination of THE_FLAG_NORMALS and THE_FLAG_COLORS
+    uint32_t Reserved[3];
+  };
+
+  static const char     THE_MAGIC[8] = "OCCTPC1";
+  static const uint32_t THE_FLAG_NORMALS = 0x01;
+  static const uint32_t THE_FLAG_COLORS  = 0x02;
+
+  //! Number of points processed by a single parallel task.
+  static const int64_t THE_CHUNK_SIZE = 1 << 16;
+
+  //! Return number of chunks for parallel processing.
+  static int nbChunks (int64_t theNbElems, int64_t theChunkSize)
+  {
+    return (int )((theNbElems + theChunkSize - 1) / theChunkSize);
+  }
+
+  //! Pack RGBA color.
+  static uint32_t packColor (uint32_t theR, uint32_t theG, uint32_t theB, uint32_t theA)
+  {
+    return (theR & 0xFF) | ((theG & 0xFF) << 8) | ((theB & 0xFF) << 16) | ((theA & 0xFF) << 24);
+  }
+
+  //! Check if file path ends with specified extension (lower case).
+  static bool hasExtension (const TCollection_AsciiString& thePath, const char* theExt)
+  {
+    TCollection_AsciiString aPath (thePath);
+    aPath.LowerCase();
+    const int anExtLen = (int )std::strlen (theExt);
+    return aPath.Length() > anExtLen
+        && aPath.SubString (aPath.Length() - anExtLen + 1, aPath.Length()).IsEqual (theExt);
+  }
+
+  //! Parse floating point number; a lightweight locale-independent replacement of strtod().
+  //! @param[in][out] thePos   current position, moved after parsed number
+  //! @param[in]      theEnd   end of the line
+  //! @param[out]     theValue parsed value
+  //! @return FALSE if there is no number at current position
+  static bool parseReal (const char*& thePos, const char* theEnd, double& theValue)
+  {
+    const char* aPos = thePos;
+    while (aPos < theEnd && (*aPos == ' ' || *aPos == '\t' || *aPos == ',' || *aPos == ';')) { ++aPos; }
+
+    bool isNegative = false;
+    if (aPos < theEnd && (*aPos == '-' || *aPos == '+')) { isNegative = *aPos++ == '-'; }
+
+    double aValue = 0.0;
+    int aNbDigits = 0;
+    for (; aPos < theEnd && *aPos >= '0' && *aPos <= '9'; ++aPos, ++aNbDigits) { aValue = aValue * 10.0 + (*aPos - '0'); }
+    if (aPos < theEnd && *aPos == '.')
+    {
+      double aScale = 0.1;
+      for (++aPos; aPos < theEnd && *aPos >= '0' && *aPos <= '9'; ++aPos, ++aNbDigits, aScale *= 0.1) { aValue += (*aPos - '0') * aScale; }
+    }
+    if (aNbDigits == 0) { return false; }
+
+    if (aPos < theEnd && (*aPos == 'e' || *aPos == 'E'))
+    {
+      const char* anExpPos = aPos + 1;
+      bool isNegExp = false;
+      if (anExpPos < theEnd && (*anExpPos == '-' || *anExpPos == '+')) { isNegExp = *anExpPos++ == '-'; }
+      int anExp = 0, aNbExpDigits = 0;
+      for (; anExpPos < theEnd && *anExpPos >= '0' && *anExpPos <= '9'; ++anExpPos, ++aNbExpDigits) { anExp = anExp * 10 + (*anExpPos - '0'); }
+      if (aNbExpDigits != 0)
+      {
+        aValue *= std::pow (10.0, isNegExp ? -anExp : anExp);
+        aPos = anExpPos;
+      }
+    }
+
+    theValue = isNegative ? -aValue : aValue;
+    thePos = aPos;
+    return true;
+  }
+
+  //! Mapping of text columns to point attributes; -1 for undefined attributes.
+  struct TextColumns
+  {
+    int Pos[3];
+    int Norm[3];
+    int Color[4];
+    int NbColumns;
+    double ColorScale; //!< scale factor converting color values to 0..255 range
+
+    TextColumns() : NbColumns (0), ColorScale (1.0)
+    {
+      for (int anIter = 0; anIter < 3; ++anIter) { Pos[anIter] = Norm[anIter] = Color[anIter] = -1; }
+      Color[3] = -1;
+    }
+
+    bool HasNormals() const { return Norm[0] != -1 && Norm[1] != -1 && Norm[2] != -1; }
+    bool HasColors()  const { return Color[0] != -1 && Color[1] != -1 && Color[2] != -1; }
+  };
+
+  //! Points parsed from a chunk of text file.
+  struct TextChunk
+  {
+    std::vector<float>    Coords;  //!< interleaved XYZ
+    std::vector<float>    Normals; //!< interleaved normals
+    std::vector<uint32_t> Colors;  //!< packed colors
+  };
+
+  //! Parse text lines starting within range [theBegin, theEnd) of the data ending at theDataEnd.
+  static void parseTextChunk (const char* theBegin, const char* theEnd, const char* theDataEnd,
+                              const TextColumns& theColumns, TextChunk& theChunk)
+  {
+    const bool hasNormals = theColumns.HasNormals(), hasColors = theColumns.HasColors();
+    for (const char* aLine = theBegin; aLine < theEnd; )
+    {
+      const char* aLineEnd = (const char* )std::memchr (aLine, '\n', theDataEnd - aLine);
+      if (aLineEnd == NULL) { aLineEnd = theDataEnd; }
+
+      // only columns mapped onto attributes are kept, so that the number of columns is not limited
+      double aPos[3] = {}, aNorm[3] = {}, aColor[4] = {};
+      int aNbValues = 0;
+      for (const char* aValuePos = aLine; aNbValues < theColumns.NbColumns; ++aNbValues)
+      {
+        double aValue = 0.0;
+        if (!parseReal (aValuePos, aLineEnd, aValue)) { break; }
+
+        for (int aCompIter = 0; aCompIter < 4; ++aCompIter)
+        {
+          if (aCompIter < 3 && theColumns.Pos[aCompIter]  == aNbValues) { aPos[aCompIter]  = aValue; }
+          if (aCompIter < 3 && theColumns.Norm[aCompIter] == aNbValues) { aNorm[aCompIter] = aValue; }
+          if (theColumns.Color[aCompIter] == aNbValues) { aColor[aCompIter] = aValue; }
+        }
+      }
+      aLine = aLineEnd + 1;
+      if (aNbValues < theColumns.NbColumns)
+      {
+        continue; // skip comments, headers and incomplete lines
+      }
+
+      for (int aCompIter = 0; aCompIter < 3; ++aCompIter) { theChunk.Coords.push_back ((float )aPos[aCompIter]); }
+      if (hasNormals)
+      {
+        for (int aCompIter = 0; aCompIter < 3; ++aCompIter) { theChunk.Normals.push_back ((float )aNorm[aCompIter]); }
+      }
+      if (hasColors)
+      {
+        uint32_t aRgba[4] = { 0, 0, 0, 255 };
+        for (int aCompIter = 0; aCompIter < 4; ++aCompIter)
+        {
+          if (theColumns.Color[aCompIter] != -1)
+          {
+            const double aValue = aColor[aCompIter] * theColumns.ColorScale;
+            aRgba[aCompIter] = (uint32_t )std::max (0.0, std::min (255.0, aValue + 0.5));
+          }
+        }
+        theChunk.Colors.push_back (packColor (aRgba[0], aRgba[1], aRgba[2], aRgba[3]));
+      }
+    }
+  }
+
+  //! PLY property type.
+  enum PlyType { PlyType_Unknown, PlyType_Int8, PlyType_UInt8, PlyType_Int16, PlyType_UInt16,
+                 PlyType_Int32, PlyType_UInt32, PlyType_Float32, PlyType_Float64 };
+
+  //! Parse PLY property type.
+  static PlyType plyTypeFromString (const TCollection_AsciiString& theType)
+  {
+    if (theType == "char"   || theType == "int8")    { return PlyType_Int8; }
+    if (theType == "uchar"  || theType == "uint8")   { return PlyType_UInt8; }
+    if (theType == "short"  || theType == "int16")   { return PlyType_Int16; }
+    if (theType == "ushort" || theType == "uint16")  { return PlyType_UInt16; }
+    if (theType == "int"    || theType == "int32")   { return PlyType_Int32; }
+    if (theType == "uint"   || theType == "uint32")  { return PlyType_UInt32; }
+    if (theType == "float"  || theType == "float32") { return PlyType_Float32; }
+    if (theType == "double" || theType == "float64") { return PlyType_Float64; }
+    return PlyType_Unknown;
+  }
+
+  //! Return size of PLY property type in bytes.
+  static int plyTypeSize (PlyType theType)
+  {
+    switch (theType)
+    {
+      case PlyType_Int8:    case PlyType_UInt8:  return 1;
+      case PlyType_Int16:   case PlyType_UInt16: return 2;
+      case PlyType_Int32:   case PlyType_UInt32: case PlyType_Float32: return 4;
+      case PlyType_Float64: return 8;
+      case PlyType_Unknown: break;
+    }
+    return 0;
+  }
+
+  //! Read binary little-endian PLY value.
+  static double plyValue (const char* thePtr, PlyType theType)
+  {
+    switch (theType)
+    {
+      case PlyType_Int8:    return (double )*(const int8_t*  )thePtr;
+      case PlyType_UInt8:   return (double )*(const uint8_t* )thePtr;
+      case PlyType_Int16:   { int16_t  aVal; std::memcpy (&aVal, thePtr, 2); return aVal; }
+      case PlyType_UInt16:  { uint16_t aVal; std::memcpy (&aVal, thePtr, 2); return aVal; }
+      case PlyType_Int32:   { int32_t  aVal; std::memcpy (&aVal, thePtr, 4); return aVal; }
+      case PlyType_UInt32:  { uint32_t aVal; std::memcpy (&aVal, thePtr, 4); return aVal; }
+      case PlyType_Float32: { float    aVal; std::memcpy (&aVal, thePtr, 4); return aVal; }
+      case PlyType_Float64: { double   aVal; std::memcpy (&aVal, thePtr, 8); return aVal; }
+      case PlyType_Unknown: break;
+    }
+    return 0.0;
+  }
+
+  //! Voxel accumulator.
+  struct VoxelSum
+  {
+    double   Pos[3];
+    float    Norm[3];
+    uint64_t Color[4];
+    uint64_t NbPoints;
+
+    VoxelSum() : NbPoints (0)
+    {
+      for (int anIter = 0; anIter < 3; ++anIter) { Pos[anIter] = 0.0; Norm[anIter] = 0.0f; }
+      for (int anIter = 0; anIter < 4; ++anIter) { Color[anIter] = 0; }
+    }
+
+    void Add (const VoxelSum& theOther)
+    {
+      for (int anIter = 0; anIter < 3; ++anIter) { Pos[anIter] += theOther.Pos[anIter]; Norm[anIter] += theOther.Norm[anIter]; }
+      for (int anIter = 0; anIter < 4; ++anIter) { Color[anIter] += theOther.Color[anIter]; }
+      NbPoints += theOther.NbPoints;
+    }
+  };
+
+  typedef std::unordered_map<uint64_t, VoxelSum> VoxelMap;
+}
+
+// Empty constructor.
+OcctPointCloud::OcctPointCloud()
+: myNbPoints (0),
+  myX (NULL), myY (NULL), myZ (NULL),
+  myNX (NULL), myNY (NULL), myNZ (NULL),
+  myColors (NULL),
+  myTreeDepth (0)
+{
+  //
+}
+
+// Destructor.
+OcctPointCloud::~OcctPointCloud()
+{
+  //
+}
+
+// Return memory occupied by point arrays and spatial index.
+uint64_t OcctPointCloud::MemorySize() const
+{
+  uint64_t aSize = uint64_t(myNbPoints) * (3 * sizeof(float)
+                                         + (HasNormals() ? 3 * sizeof(float) : 0)
+                                         + (HasColors()  ? sizeof(uint32_t) : 0));
+  aSize += myTreeCoords.size()  * sizeof(float)
+         + myTreeIndices.size() * sizeof(uint32_t)
+         + myTreeAxes.size()    * sizeof(uint8_t);
+  return aSize;
+}
+
+// Allocate own arrays.
+void OcctPointCloud::Allocate (int64_t theNbPoints, bool theHasNormals, bool theHasColors)
+{
+  ReleaseIndex();
+  myMapping.reset();
+  myNbPoints = theNbPoints;
+  myOwnedCoords.assign ((size_t )theNbPoints * 3, 0.0f);
+  myOwnedNormals.assign (theHasNormals ? (size_t )theNbPoints * 3 : 0, 0.0f);
+  myOwnedColors.assign (theHasColors ? (size_t )theNbPoints : 0, 0xFFFFFFFFu);
+  bindOwnedArrays();
+}
+
+// Assign array pointers to own buffers.
+void OcctPointCloud::bindOwnedArrays()
+{
+  myX = myOwnedCoords.data();
+  myY = myX + myNbPoints;
+  myZ = myY + myNbPoints;
+  myNX = myNY = myNZ = NULL;
+  if (!myOwnedNormals.empty())
+  {
+    myNX = myOwnedNormals.data();
+    myNY = myNX + myNbPoints;
+    myNZ = myNY + myNbPoints;
+  }
+  myColors = !myOwnedColors.empty() ? myOwnedColors.data() : NULL;
+}
+
+// Load point cloud from file.
+bool OcctPointCloud::Load (const TCollection_AsciiString& thePath)
+{
+  std::shared_ptr<OcctMappedFile> aFile (new OcctMappedFile());
+  if (!aFile->Open (thePath))
+  {
+    Message::SendFail() << "Error: unable to open file '" << thePath << "'";
+    return false;
+  }
+
+  Allocate (0, false, false);
+  bool isDone = false;
+  if (hasExtension (thePath, ".pcb"))
+  {
+    isDone = loadBinary (aFile);
+  }
+  else if (hasExtension (thePath, ".ply"))
+  {
+    isDone = loadPly (aFile);
+  }
+  else
+  {
+    isDone = loadText (aFile);
+  }
+
+  if (!isDone)
+  {
+    Message::SendFail() << "Error: unable to read point cloud from '" << thePath << "'";
+    Allocate (0, false, false);
+  }
+  return isDone;
+}
+
+// Map native binary file without copying.
+bool OcctPointCloud::loadBinary (const std::shared_ptr<OcctMappedFile>& theFile)
+{
+  if (theFile->Size() < sizeof(PointCloudHeader))
+  {
+    return false;
+  }
+
+  PointCloudHeader aHeader;
+  std::memcpy (&aHeader, theFile->Data(), sizeof(aHeader));
+  if (std::memcmp (aHeader.Magic, THE_MAGIC, sizeof(THE_MAGIC)) != 0)
+  {
+    Message::SendFail() << "Error: wrong point cloud file header";
+    return false;
+  }
+
+  const uint64_t aNbPoints = aHeader.NbPoints;
+  const bool hasNormals = (aHeader.Flags & THE_FLAG_NORMALS) != 0;
+  const bool hasColors  = (aHeader.Flags & THE_FLAG_COLORS)  != 0;
+  const uint64_t aPointSize = 3 * sizeof(float)
+                            + (hasNormals ? 3 * sizeof(float) : 0)
+                            + (hasColors  ? sizeof(uint32_t) : 0);
+  // number of points comes from untrusted header - compare it without multiplication to avoid overflow
+  if (aNbPoints > (theFile->Size() - sizeof(PointCloudHeader)) / aPointSize)
+  {
+    Message::SendFail() << "Error: point cloud file is truncated";
+    return false;
+  }
+
+  // arrays are 4-byte aligned within the file, so that they could be used without copying
+  const float* aData = (const float* )(theFile->Data() + sizeof(PointCloudHeader));
+  myMapping  = theFile;
+  myNbPoints = (int64_t )aNbPoints;
+  myX = aData;
+  myY = myX + aNbPoints;
+  myZ = myY + aNbPoints;
+  aData = myZ + aNbPoints;
+  if (hasNormals)
+  {
+    myNX = aData;
+    myNY = myNX + aNbPoints;
+    myNZ = myNY + aNbPoints;
+    aData = myNZ + aNbPoints;
+  }
+  if (hasColors)
+  {
+    myColors = (const uint32_t* )aData;
+  }
+  return true;
+}
+
+// Load PLY file.
+bool OcctPointCloud::loadPly (const std::shared_ptr<OcctMappedFile>& theFile)
+{
+  const char* aData = theFile->Data();
+  const char* aDataEnd = aData + theFile->Size();
+  if (theFile->Size() < 4 || std::memcmp (aData, "ply", 3) != 0)
+  {
+    Message::SendFail() << "Error: wrong PLY file header";
+    return false;
+  }
+
+  // parse header
+  enum { PlyFormat_Unknown, PlyFormat_Ascii, PlyFormat_Binary } aFormat = PlyFormat_Unknown;
+  int64_t aNbVertices = 0;
+  bool isVertexElement = false, isVertexDone = false;
+  std::vector<PlyType> aPropTypes;
+  std::vector<TCollection_AsciiString> aPropNames;
+  const char* aBody = NULL;
+  for (const char* aLine = aData; aLine < aDataEnd; )
+  {
+    const char* aLineEnd = (const char* )std::memchr (aLine, '\n', aDataEnd - aLine);
+    if (aLineEnd == NULL) { return false; }
+
+    TCollection_AsciiString aLineStr (aLine, (int )(aLineEnd - aLine));
+    aLineStr.RightAdjust();
+    aLine = aLineEnd + 1;
+    if (aLineStr == "end_header")
+    {
+      aBody = aLine;
+      break;
+    }
+
+    const TCollection_AsciiString aKey = aLineStr.Token (" ", 1);
+    if (aKey == "format")
+    {
+      const TCollection_AsciiString aFormatStr = aLineStr.Token (" ", 2);
+      if (aFormatStr == "ascii")                     { aFormat = PlyFormat_Ascii; }
+      else if (aFormatStr == "binary_little_endian") { aFormat = PlyFormat_Binary; }
+      else
+      {
+        Message::SendFail() << "Error: unsupported PLY format '" << aFormatStr << "'";
+        return false;
+      }
+    }
+    else if (aKey == "element")
+    {
+      if (isVertexElement) { isVertexDone = true; }
+      isVertexElement = aLineStr.Token (" ", 2) == "vertex";
+      if (isVertexElement)
+      {
+        aNbVertices = (int64_t )std::atoll (aLineStr.Token (" ", 3).ToCString());
+      }
+      else if (!isVertexDone && std::atoll (aLineStr.Token (" ", 3).ToCString()) != 0)
+      {
+        Message::SendFail() << "Error: unsupported PLY element '" << aLineStr.Token (" ", 2) << "' before vertices";
+        return false;
+      }
+    }
+    else if (aKey == "property"
+          && isVertexElement)
+    {
+      const PlyType aType = plyTypeFromString (aLineStr.Token (" ", 2));
+      if (aType == PlyType_Unknown)
+      {
+        Message::SendFail() << "Error: unsupported PLY vertex property '" << aLineStr << "'";
+        return false;
+      }
+      aPropTypes.push_back (aType);
+      aPropNames.push_back (aLineStr.Token (" ", 3));
+    }
+  }
+  if (aBody == NULL || aFormat == PlyFormat_Unknown)
+  {
+    Message::SendFail() << "Error: wrong PLY file header";
+    return false;
+  }
+
+  // map vertex properties onto attributes
+  static const char* THE_NAMES[10] = { "x", "y", "z", "nx", "ny", "nz", "red", "green", "blue", "alpha" };
+  int aProps[10] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+  for (size_t aPropIter = 0; aPropIter < aPropNames.size(); ++aPropIter)
+  {
+    for (int anAttrIter = 0; anAttrIter < 10; ++anAttrIter)
+    {
+      if (aPropNames[aPropIter] == THE_NAMES[anAttrIter]) { aProps[anAttrIter] = (int )aPropIter; }
+    }
+  }
+  if (aProps[0] == -1 || aProps[1] == -1 || aProps[2] == -1)
+  {
+    Message::SendFail() << "Error: PLY file defines no vertex positions";
+    return false;
+  }
+  const bool hasNormals = aProps[3] != -1 && aProps[4] != -1 && aProps[5] != -1;
+  const bool hasColors  = aProps[6] != -1 && aProps[7] != -1 && aProps[8] != -1;
+  const bool isRealColor = hasColors && (aPropTypes[aProps[6]] == PlyType_Float32 || aPropTypes[aProps[6]] == PlyType_Float64);
+
+  if (aFormat == PlyFormat_Ascii)
+  {
+    TextColumns aColumns;
+    aColumns.NbColumns = (int )aPropNames.size();
+    for (int aCompIter = 0; aCompIter < 3; ++aCompIter)
+    {
+      aColumns.Pos[aCompIter] = aProps[aCompIter];
+      if (hasNormals) { aColumns.Norm[aCompIter] = aProps[3 + aCompIter]; }
+    }
+    if (hasColors)
+    {
+      for (int aCompIter = 0; aCompIter < 4; ++aCompIter) { aColumns.Color[aCompIter] = aProps[6 + aCompIter]; }
+      aColumns.ColorScale = isRealColor ? 255.0 : 1.0;
+    }
+
+    TextChunk aChunk;
+    aChunk.Coords.reserve ((size_t )aNbVertices * 3);
+    // vertices are followed by other elements, so that parsing is stopped after expected number of lines
+    const char* aLine = aBody;
+    for (int64_t aVertIter = 0; aVertIter < aNbVertices && aLine < aDataEnd; ++aVertIter)
+    {
+      const char* aLineEnd = (const char* )std::memchr (aLine, '\n', aDataEnd - aLine);
+      const char* aNext = aLineEnd != NULL ? aLineEnd + 1 : aDataEnd;
+      parseTextChunk (aLine, aNext, aNext, aColumns, aChunk);
+      aLine = aNext;
+    }
+
+    const int64_t aNbPoints = (int64_t )aChunk.Coords.size() / 3;
+    Allocate (aNbPoints, hasNormals, hasColors);
+    for (int64_t aPntIter = 0; aPntIter < aNbPoints; ++aPntIter)
+    {
+      ChangeX()[aPntIter] = aChunk.Coords[aPntIter * 3 + 0];
+      ChangeY()[aPntIter] = aChunk.Coords[aPntIter * 3 + 1];
+      ChangeZ()[aPntIter] = aChunk.Coords[aPntIter * 3 + 2];
+      if (hasNormals)
+      {
+        ChangeNX()[aPntIter] = aChunk.Normals[aPntIter * 3 + 0];
+        ChangeNY()[aPntIter] = aChunk.Normals[aPntIter * 3 + 1];
+        ChangeNZ()[aPntIter] = aChunk.Normals[aPntIter * 3 + 2];
+      }
+      if (hasColors) { ChangeColors()[aPntIter] = aChunk.Colors[aPntIter]; }
+    }
+    return aNbPoints == aNbVertices;
+  }
+
+  // binary PLY stores vertices as array of structures - convert it to structure of arrays in parallel
+  int aStride = 0;
+  std::vector<int> anOffsets (aPropTypes.size(), 0);
+  for (size_t aPropIter = 0; aPropIter < aPropTypes.size(); ++aPropIter)
+  {
+    anOffsets[aPropIter] = aStride;
+    aStride += plyTypeSize (aPropTypes[aPropIter]);
+  }
+  if (aStride == 0
+   || (uint64_t )aNbVertices > (uint64_t )(aDataEnd - aBody) / aStride)
+  {
+    Message::SendFail() << "Error: PLY file is truncated";
+    return false;
+  }
+
+  Allocate (aNbVertices, hasNormals, hasColors);
+  float* aDst[6] = { ChangeX(), ChangeY(), ChangeZ(),
+                     hasNormals ? ChangeNX() : NULL, hasNormals ? ChangeNY() : NULL, hasNormals ? ChangeNZ() : NULL };
+  uint32_t* aDstColors = hasColors ? ChangeColors() : NULL;
+  const double aColorScale = isRealColor ? 255.0 : 1.0;
+  OSD_Parallel::For (0, nbChunks (aNbVertices, THE_CHUNK_SIZE), [&](int theChunkIndex)
+  {
+    const int64_t aFrom = int64_t(theChunkIndex) * THE_CHUNK_SIZE;
+    const int64_t aTo   = std::min (aFrom + THE_CHUNK_SIZE, aNbVertices);
+    for (int64_t aVertIter = aFrom; aVertIter < aTo; ++aVertIter)
+    {
+      const char* aVert = aBody + aVertIter * aStride;
+      for (int anAttrIter = 0; anAttrIter < 6; ++anAttrIter)
+      {
+        if (aDst[anAttrIter] != NULL)
+        {
+          const int aProp = aProps[anAttrIter];
+          aDst[anAttrIter][aVertIter] = (float )plyValue (aVert + anOffsets[aProp], aPropTypes[aProp]);
+        }
+      }
+      if (aDstColors != NULL)
+      {
+        uint32_t aRgba[4] = { 0, 0, 0, 255 };
+        for (int aCompIter = 0; aCompIter < 4; ++aCompIter)
+        {
+          const int aProp = aProps[6 + aCompIter];
+          if (aProp != -1)
+          {
+            const double aValue = plyValue (aVert + anOffsets[aProp], aPropTypes[aProp]) * aColorScale;
+            aRgba[aCompIter] = (uint32_t )std::max (0.0, std::min (255.0, aValue + 0.5));
+          }
+        }
+        aDstColors[aVertIter] = packColor (aRgba[0], aRgba[1], aRgba[2], aRgba[3]);
+      }
+    }
+  });
+  return true;
+}
+
+// Load text file with point per line.
+bool OcctPointCloud::loadText (const std::shared_ptr<OcctMappedFile>& theFile)
+{
+  const char* aData = theFile->Data();
+  const char* aDataEnd = aData + theFile->Size();
+
+  // detect columns from the first line with at least 3 numbers
+  TextColumns aColumns;
+  for (const char* aLine = aData; aLine < aDataEnd && aColumns.NbColumns == 0; )
+  {
+    const char* aLineEnd = (const char* )std::memchr (aLine, '\n', aDataEnd - aLine);
+    if (aLineEnd == NULL) { aLineEnd = aDataEnd; }
+
+    int aNbValues = 0;
+    double aValue = 0.0;
+    for (const char* aPos = aLine; parseReal (aPos, aLineEnd, aValue); ++aNbValues) {}
+    if (aNbValues >= 3)
+    {
+      // x y z [intensity]; x y z r g b; x y z intensity r g b (PTS); x y z r g b nx ny nz
+      aColumns.NbColumns = std::min (aNbValues, 9);
+      aColumns.Pos[0] = 0; aColumns.Pos[1] = 1; aColumns.Pos[2] = 2;
+      if (aNbValues == 6 || aNbValues >= 9)
+      {
+        aColumns.Color[0] = 3; aColumns.Color[1] = 4; aColumns.Color[2] = 5;
+      }
+      else if (aNbValues == 7)
+      {
+        aColumns.Color[0] = 4; aColumns.Color[1] = 5; aColumns.Color[2] = 6;
+      }
+      if (aNbValues >= 9)
+      {
+        aColumns.Norm[0] = 6; aColumns.Norm[1] = 7; aColumns.Norm[2] = 8;
+      }
+    }
+    aLine = aLineEnd + 1;
+  }
+  if (aColumns.NbColumns == 0)
+  {
+    Message::SendFail() << "Error: text file defines no points";
+    return false;
+  }
+
+  // parse chunks in parallel; each chunk handles lines starting within its range
+  const int64_t aChunkBytes = 4 * 1024 * 1024;
+  const int64_t aDataSize = (int64_t )theFile->Size();
+  const int aNbChunks = nbChunks (aDataSize, aChunkBytes);
+  std::vector<TextChunk> aChunks (aNbChunks);
+  OSD_Parallel::For (0, aNbChunks, [&](int theChunkIndex)
+  {
+    const char* aBegin = aData + int64_t(theChunkIndex) * aChunkBytes;
+    const char* anEnd  = aData + std::min (int64_t(theChunkIndex + 1) * aChunkBytes, aDataSize);
+    if (theChunkIndex != 0 && aBegin[-1] != '\n')
+    {
+      // skip the line started within previous chunk
+      const char* aLineEnd = (const char* )std::memchr (aBegin, '\n', aDataEnd - aBegin);
+      aBegin = aLineEnd != NULL ? aLineEnd + 1 : aDataEnd;
+    }
+    TextChunk& aChunk = aChunks[theChunkIndex];
+    aChunk.Coords.reserve ((size_t )(anEnd - aBegin) / 8);
+    parseTextChunk (aBegin, anEnd, aDataEnd, aColumns, aChunk);
+  });
+
+  // concatenate chunks
+  std::vector<int64_t> aChunkOffsets (aNbChunks + 1, 0);
+  for (int aChunkIter = 0; aChunkIter < aNbChunks; ++aChunkIter)
+  {
+    aChunkOffsets[aChunkIter + 1] = aChunkOffsets[aChunkIter] + (int64_t )aChunks[aChunkIter].Coords.size() / 3;
+  }
+  Allocate (aChunkOffsets[aNbChunks], aColumns.HasNormals(), aColumns.HasColors());
+  OSD_Parallel::For (0, aNbChunks, [&](int theChunkIndex)
+  {
+    TextChunk& aChunk = aChunks[theChunkIndex];
+    const int64_t aFirst = aChunkOffsets[theChunkIndex];
+    const int64_t aNbChunkPoints = aChunkOffsets[theChunkIndex + 1] - aFirst;
+    for (int64_t aPntIter = 0; aPntIter < aNbChunkPoints; ++aPntIter)
+    {
+      ChangeX()[aFirst + aPntIter] = aChunk.Coords[aPntIter * 3 + 0];
+      ChangeY()[aFirst + aPntIter] = aChunk.Coords[aPntIter * 3 + 1];
+      ChangeZ()[aFirst + aPntIter] = aChunk.Coords[aPntIter * 3 + 2];
+      if (!aChunk.Normals.empty())
+      {
+        ChangeNX()[aFirst + aPntIter] = aChunk.Normals[aPntIter * 3 + 0];
+        ChangeNY()[aFirst + aPntIter] = aChunk.Normals[aPntIter * 3 + 1];
+        ChangeNZ()[aFirst + aPntIter] = aChunk.Normals[aPntIter * 3 + 2];
+      }
+      if (!aChunk.Colors.empty())
+      {
+        ChangeColors()[aFirst + aPntIter] = aChunk.Colors[aPntIter];
+      }
+    }
+    aChunk = TextChunk(); // release memory early
+  });
+  return myNbPoints != 0;
+}
+
+// Save point cloud into native binary format.
+bool OcctPointCloud::Save (const TCollection_AsciiString& thePath) const
+{
+  std::ofstream aFile (thePath.ToCString(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!aFile.is_open())
+  {
+    Message::SendFail() << "Error: unable to create file '" << thePath << "'";
+    return false;
+  }
+
+  PointCloudHeader aHeader;
+  std::memset (&aHeader, 0, sizeof(aHeader));
+  std::memcpy (aHeader.Magic, THE_MAGIC, sizeof(THE_MAGIC));
+  aHeader.NbPoints = (uint64_t )myNbPoints;
+  aHeader.Flags = (HasNormals() ? THE_FLAG_NORMALS : 0) | (HasColors() ? THE_FLAG_COLORS : 0);
+  aFile.write ((const char* )&aHeader, sizeof(aHeader));
+
+  const std::streamsize anArraySize = (std::streamsize )(myNbPoints * sizeof(float));
+  aFile.write ((const char* )myX, anArraySize);
+  aFile.write ((const char* )myY, anArraySize);
+  aFile.write ((const char* )myZ, anArraySize);
+  if (HasNormals())
+  {
+    aFile.write ((const char* )myNX, anArraySize);
+    aFile.write ((const char* )myNY, anArraySize);
+    aFile.write ((const char* )myNZ, anArraySize);
+  }
+  if (HasColors())
+  {
+    aFile.write ((const char* )myColors, (std::streamsize )(myNbPoints * sizeof(uint32_t)));
+  }
+  aFile.close();
+  if (aFile.fail())
+  {
+    Message::SendFail() << "Error: unable to write file '" << thePath << "'";
+    return false;
+  }
+  return true;
+}
+
+// Compute bounding box.
+Bnd_Box OcctPointCloud::BoundingBox() const
+{
+  Bnd_Box aBox;
+  if (myNbPoints == 0) { return aBox; }
+
+  const int aNbChunks = nbChunks (myNbPoints, THE_CHUNK_SIZE * 16);
+  std::vector<float> aRanges ((size_t )aNbChunks * 6);
+  OSD_Parallel::For (0, aNbChunks, [&](int theChunkIndex)
+  {
+    const int64_t aFrom = int64_t(theChunkIndex) * THE_CHUNK_SIZE * 16;
+    const int64_t aTo   = std::min (aFrom + THE_CHUNK_SIZE * 16, myNbPoints);
+    const float* anArrays[3] = { myX, myY, myZ };
+    float* aRange = aRanges.data() + theChunkIndex * 6;
+    for (int anAxis = 0; anAxis < 3; ++anAxis)
+    {
+      // separate loops over contiguous arrays are vectorized by compiler
+      const float* anArray = anArrays[anAxis];
+      float aMin = anArray[aFrom], aMax = anArray[aFrom];
+      for (int64_t aPntIter = aFrom + 1; aPntIter < aTo; ++aPntIter)
+      {
+        aMin = std::min (aMin, anArray[aPntIter]);
+        aMax = std::max (aMax, anArray[aPntIter]);
+      }
+      aRange[anAxis] = aMin;
+      aRange[anAxis + 3] = aMax;
+    }
+  });
+
+  for (int aChunkIter = 0; aChunkIter < aNbChunks; ++aChunkIter)
+  {
+    const float* aRange = aRanges.data() + aChunkIter * 6;
+    aBox.Update (aRange[0], aRange[1], aRange[2], aRange[3], aRange[4], aRange[5]);
+  }
+  return aBox;
+}
+
+// Compute downsampled cloud.
+Handle(OcctPointCloud) OcctPointCloud::VoxelDownsample (double theVoxelSize) const
+{
+  Handle(OcctPointCloud) aResult = new OcctPointCloud();
+  const Bnd_Box aBox = BoundingBox();
+  if (aBox.IsVoid() || theVoxelSize <= 0.0)
+  {
+    return aResult;
+  }
+
+  // voxel key packs 21 bits per axis
+  const gp_Pnt aMin = aBox.CornerMin();
+  const gp_XYZ aSize = aBox.CornerMax().XYZ() - aMin.XYZ();
+  const double aMaxCells = double((1 << 21) - 1);
+  if (aSize.X() / theVoxelSize > aMaxCells
+   || aSize.Y() / theVoxelSize > aMaxCells
+   || aSize.Z() / theVoxelSize > aMaxCells)
+  {
+    Message::SendFail() << "Error: voxel size is too small for point cloud dimensions";
+    return Handle(OcctPointCloud)();
+  }
+
+  // accumulate voxels per chunk in parallel - spatially coherent scans produce small per-chunk maps
+  const double anInvSize = 1.0 / theVoxelSize;
+  const int aNbChunks = nbChunks (myNbPoints, THE_CHUNK_SIZE * 16);
+  std::vector<VoxelMap> aChunkMaps (aNbChunks);
+  OSD_Parallel::For (0, aNbChunks, [&](int theChunkIndex)
+  {
+    const int64_t aFrom = int64_t(theChunkIndex) * THE_CHUNK_SIZE * 16;
+    const int64_t aTo   = std::min (aFrom + THE_CHUNK_SIZE * 16, myNbPoints);
+    VoxelMap& aMap = aChunkMaps[theChunkIndex];
+    for (int64_t aPntIter = aFrom; aPntIter < aTo; ++aPntIter)
+    {
+      const uint64_t aCellX = (uint64_t )((myX[aPntIter] - aMin.X()) * anInvSize);
+      const uint64_t aCellY = (uint64_t )((myY[aPntIter] - aMin.Y()) * anInvSize);
+      const uint64_t aCellZ = (uint64_t )((myZ[aPntIter] - aMin.Z()) * anInvSize);
+      VoxelSum& aSum = aMap[aCellX | (aCellY << 21) | (aCellZ << 42)];
+      aSum.Pos[0] += myX[aPntIter];
+      aSum.Pos[1] += myY[aPntIter];
+      aSum.Pos[2] += myZ[aPntIter];
+      if (myNX != NULL)
+      {
+        aSum.Norm[0] += myNX[aPntIter];
+        aSum.Norm[1] += myNY[aPntIter];
+        aSum.Norm[2] += myNZ[aPntIter];
+      }
+      if (myColors != NULL)
+      {
+        const uint32_t aColor = myColors[aPntIter];
+        for (int aCompIter = 0; aCompIter < 4; ++aCompIter) { aSum.Color[aCompIter] += (aColor >> (aCompIter * 8)) & 0xFF; }
+      }
+      ++aSum.NbPoints;
+    }
+  });
+
+  // merge chunk maps
+  VoxelMap& aVoxels = aChunkMaps.front();
+  for (int aChunkIter = 1; aChunkIter < aNbChunks; ++aChunkIter)
+  {
+    for (const VoxelMap::value_type& aVoxel : aChunkMaps[aChunkIter])
+    {
+      aVoxels[aVoxel.first].Add (aVoxel.second);
+    }
+    aChunkMaps[aChunkIter] = VoxelMap();
+  }
+
+  aResult->Allocate ((int64_t )aVoxels.size(), HasNormals(), HasColors());
+  int64_t aPntIter = 0;
+  for (const VoxelMap::value_type& aVoxel : aVoxels)
+  {
+    const VoxelSum& aSum = aVoxel.second;
+    const double anInvNb = 1.0 / double(aSum.NbPoints);
+    aResult->ChangeX()[aPntIter] = float(aSum.Pos[0] * anInvNb);
+    aResult->ChangeY()[aPntIter] = float(aSum.Pos[1] * anInvNb);
+    aResult->ChangeZ()[aPntIter] = float(aSum.Pos[2] * anInvNb);
+    if (HasNormals())
+    {
+      const float aLen = std::sqrt (aSum.Norm[0] * aSum.Norm[0] + aSum.Norm[1] * aSum.Norm[1] + aSum.Norm[2] * aSum.Norm[2]);
+      const float anInvLen = aLen > 0.0f ? 1.0f / aLen : 0.0f;
+      aResult->ChangeNX()[aPntIter] = aSum.Norm[0] * anInvLen;
+      aResult->ChangeNY()[aPntIter] = aSum.Norm[1] * anInvLen;
+      aResult->ChangeNZ()[aPntIter] = aSum.Norm[2] * anInvLen;
+    }
+    if (HasColors())
+    {
+      aResult->ChangeColors()[aPntIter] = packColor ((uint32_t )(aSum.Color[0] / aSum.NbPoints),
+                                                     (uint32_t )(aSum.Color[1] / aSum.NbPoints),
+                                                     (uint32_t )(aSum.Color[2] / aSum.NbPoints),
+                                                     (uint32_t )(aSum.Color[3] / aSum.NbPoints));
+    }
+    ++aPntIter;
+  }
+  return aResult;
+}
+
+// Release kd-tree.
+void OcctPointCloud::ReleaseIndex()
+{
+  myTreeCoords  = std::vector<float>();
+  myTreeIndices = std::vector<uint32_t>();
+  myTreeAxes    = std::vector<uint8_t>();
+  myTreeDepth   = 0;
+}
+
+// Split range by median along the longest axis.
+void OcctPointCloud::splitRange (int64_t theFrom, int64_t theTo)
+{
+  const float* anArrays[3] = { myX, myY, myZ };
+  float aMin[3], aMax[3];
+  for (int anAxis = 0; anAxis < 3; ++anAxis) { aMin[anAxis] = aMax[anAxis] = anArrays[anAxis][myTreeIndices[theFrom]]; }
+  for (int64_t anIter = theFrom + 1; anIter < theTo; ++anIter)
+  {
+    const uint32_t anIndex = myTreeIndices[anIter];
+    for (int anAxis = 0; anAxis < 3; ++anAxis)
+    {
+      aMin[anAxis] = std::min (aMin[anAxis], anArrays[anAxis][anIndex]);
+      aMax[anAxis] = std::max (aMax[anAxis], anArrays[anAxis][anIndex]);
+    }
+  }
+
+  int aSplitAxis = 0;
+  for (int anAxis = 1; anAxis < 3; ++anAxis)
+  {
+    if (aMax[anAxis] - aMin[anAxis] > aMax[aSplitAxis] - aMin[aSplitAxis]) { aSplitAxis = anAxis; }
+  }
+
+  const int64_t aMid = (theFrom + theTo) / 2;
+  const float* anArray = anArrays[aSplitAxis];
+  std::nth_element (myTreeIndices.begin() + theFrom, myTreeIndices.begin() + aMid, myTreeIndices.begin() + theTo,
+                    [anArray](uint32_t theLeft, uint32_t theRight) { return anArray[theLeft] < anArray[theRight]; });
+  myTreeAxes[aMid] = (uint8_t )aSplitAxis;
+}
+
+// Build kd-tree subtree.
+void OcctPointCloud::buildSubtree (int64_t theFrom, int64_t theTo)
+{
+  if (theTo - theFrom <= THE_LEAF_SIZE)
+  {
+    return;
+  }
+
+  splitRange (theFrom, theTo);
+  const int64_t aMid = (theFrom + theTo) / 2;
+  buildSubtree (theFrom, aMid);
+  buildSubtree (aMid + 1, theTo);
+}
+
+// Build kd-tree.
+void OcctPointCloud::BuildIndex()
+{
+  ReleaseIndex();
+  if (myNbPoints == 0)
+  {
+    return;
+  }
+  if (myNbPoints > (int64_t )std::numeric_limits<uint32_t>::max())
+  {
+    Message::SendFail() << "Error: point cloud is too large for spatial index";
+    return;
+  }
+
+  myTreeIndices.resize ((size_t )myNbPoints);
+  myTreeAxes.assign ((size_t )myNbPoints, 0);
+  for (int64_t aPntIter = 0; aPntIter < myNbPoints; ++aPntIter) { myTreeIndices[aPntIter] = (uint32_t )aPntIter; }
+
+  // ranges are split at the middle, so that the largest sub-range of N points has N / 2 points
+  for (int64_t aRangeSize = myNbPoints; aRangeSize > THE_LEAF_SIZE; aRangeSize /= 2) { ++myTreeDepth; }
+
+  // split top levels sequentially until there are enough independent subtrees for all threads
+  std::vector<std::pair<int64_t, int64_t>> aRanges (1, std::make_pair (int64_t(0), myNbPoints));
+  const size_t aNbTasks = (size_t )OSD_Parallel::NbLogicalProcessors() * 4;
+  while (aRanges.size() < aNbTasks)
+  {
+    std::vector<std::pair<int64_t, int64_t>> aSubRanges;
+    for (const std::pair<int64_t, int64_t>& aRange : aRanges)
+    {
+      if (aRange.second - aRange.first <= THE_LEAF_SIZE) { continue; }
+
+      splitRange (aRange.first, aRange.second);
+      const int64_t aMid = (aRange.first + aRange.second) / 2;
+      aSubRanges.push_back (std::make_pair (aRange.first, aMid));
+      aSubRanges.push_back (std::make_pair (aMid + 1, aRange.second));
+    }
+    if (aSubRanges.empty()) { break; }
+    aRanges.swap (aSubRanges);
+  }
+  OSD_Parallel::For (0, (int )aRanges.size(), [&](int theRangeIndex)
+  {
+    buildSubtree (aRanges[theRangeIndex].first, aRanges[theRangeIndex].second);
+  });
+
+  // gather coordinates in tree order, so that traversal accesses memory sequentially
+  myTreeCoords.resize ((size_t )myNbPoints * 3);
+  OSD_Parallel::For (0, nbChunks (myNbPoints, THE_CHUNK_SIZE), [&](int theChunkIndex)
+  {
+    const int64_t aFrom = int64_t(theChunkIndex) * THE_CHUNK_SIZE;
+    const int64_t aTo   = std::min (aFrom + THE_CHUNK_SIZE, myNbPoints);
+    for (int64_t aPntIter = aFrom; aPntIter < aTo; ++aPntIter)
+    {
+      const uint32_t anIndex = myTreeIndices[aPntIter];
+      myTreeCoords[aPntIter * 3 + 0] = myX[anIndex];
+      myTreeCoords[aPntIter * 3 + 1] = myY[anIndex];
+      myTreeCoords[aPntIter * 3 + 2] = myZ[anIndex];
+    }
+  });
+}
+
+// Find nearest point.
+int64_t OcctPointCloud::Nearest (const gp_Pnt& thePnt, double& theSqDist) const
+{
+  if (!HasIndex())
+  {
+    return -1;
+  }
+
+  const float aQuery[3] = { (float )thePnt.X(), (float )thePnt.Y(), (float )thePnt.Z() };
+  float aBestDist = std::numeric_limits<float>::max();
+  int64_t aBest = -1;
+
+  // stack of ranges to visit with square distance from the query point to the range half-space
+  struct StackItem { int64_t From, To; float SqDist; };
+  // each level pops one range and pushes two, so that stack never exceeds tree depth + 1 items
+  NCollection_LocalArray<StackItem, 64> aStack (myTreeDepth + 1);
+  int aStackSize = 0;
+  aStack[aStackSize++] = { 0, myNbPoints, 0.0f };
+  while (aStackSize > 0)
+  {
+    const StackItem anItem = aStack[--aStackSize];
+    if (anItem.SqDist >= aBestDist)
+    {
+      continue;
+    }
+
+    if (anItem.To - anItem.From <= THE_LEAF_SIZE)
+    {
+      for (int64_t aPntIter = anItem.From; aPntIter < anItem.To; ++aPntIter)
+      {
+        const float* aPnt = myTreeCoords.data() + aPntIter * 3;
+        const float aDist = (aPnt[0] - aQuery[0]) * (aPnt[0] - aQuery[0])
+                          + (aPnt[1] - aQuery[1]) * (aPnt[1] - aQuery[1])
+                          + (aPnt[2] - aQuery[2]) * (aPnt[2] - aQuery[2]);
+        if (aDist < aBestDist) { aBestDist = aDist; aBest = aPntIter; }
+      }
+      continue;
+    }
+
+    const int64_t aMid = (anItem.From + anItem.To) / 2;
+    const float* aPnt = myTreeCoords.data() + aMid * 3;
+    const float aDist = (aPnt[0] - aQuery[0]) * (aPnt[0] - aQuery[0])
+                      + (aPnt[1] - aQuery[1]) * (aPnt[1] - aQuery[1])
+                      + (aPnt[2] - aQuery[2]) * (aPnt[2] - aQuery[2]);
+    if (aDist < aBestDist) { aBestDist = aDist; aBest = aMid; }
+
+    // push far side first, so that near side is visited first
+    const int anAxis = myTreeAxes[aMid];
+    const float aPlaneDist = aQuery[anAxis] - aPnt[anAxis];
+    const StackItem aLeft  = { anItem.From, aMid, 0.0f };
+    const StackItem aRight = { aMid + 1, anItem.To, 0.0f };
+    StackItem aNear = aPlaneDist < 0.0f ? aLeft : aRight;
+    StackItem aFar  = aPlaneDist < 0.0f ? aRight : aLeft;
+    aNear.SqDist = anItem.SqDist;
+    aFar .SqDist = aPlaneDist * aPlaneDist;
+    aStack[aStackSize++] = aFar;
+    aStack[aStackSize++] = aNear;
+  }
+
+  if (aBest == -1)
+  {
+    return -1;
+  }
+  theSqDist = aBestDist;
+  return (int64_t )myTreeIndices[aBest];
+}
@@ -0,0 +1,160 @@
+#ifndef _OcctPointCloud_HeaderFile
+#define _OcctPointCloud_HeaderFile
+
+#include <Bnd_Box.hxx>
+#include <gp_Pnt.hxx>
+#include <Standard_Transient.hxx>
+#include <TCollection_AsciiString.hxx>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class OcctMappedFile;
+
+//! Point cloud with structure-of-arrays storage: separate float arrays for X, Y and Z coordinates,
+//! optional normals and optional packed RGBA colors.
+//! Arrays either own memory or refer to memory-mapped file in native binary format (zero-copy load).
+//! Nearest-point queries are accelerated by kd-tree built by BuildIndex().
+class OcctPointCloud : public Standard_Transient
+{
+  DEFINE_STANDARD_RTTI_INLINE(OcctPointCloud, Standard_Transient)
+public:
+
+  //! Empty constructor.
+  OcctPointCloud();
+
+  //! Destructor.
+  virtual ~OcctPointCloud();
+
+  //! Return number of points.
+  int64_t NbPoints() const { return myNbPoints; }
+
+  //! Return TRUE if cloud defines per-point normals.
+  bool HasNormals() const { return myNX != NULL; }
+
+  //! Return TRUE if cloud defines per-point colors.
+  bool HasColors() const { return myColors != NULL; }
+
+  //! Return TRUE if point arrays refer to memory-mapped file.
+  bool IsMapped() const { return myMapping.get() != NULL; }
+
+  //! Return coordinate arrays.
+  const float* X() const { return myX; }
+  const float* Y() const { return myY; }
+  const float* Z() const { return myZ; }
+
+  //! Return normal arrays or NULL.
+  const float* NX() const { return myNX; }
+  const float* NY() const { return myNY; }
+  const float* NZ() const { return myNZ; }
+
+  //! Return packed RGBA colors (R in lowest byte) or NULL.
+  const uint32_t* Colors() const { return myColors; }
+
+  //! Return point.
+  gp_Pnt Point (int64_t theIndex) const { return gp_Pnt (myX[theIndex], myY[theIndex], myZ[theIndex]); }
+
+  //! Return memory occupied by point arrays and spatial index in bytes.
+  uint64_t MemorySize() const;
+
+  //! Allocate own arrays for specified number of points; previous content is lost.
+  void Allocate (int64_t theNbPoints, bool theHasNormals, bool theHasColors);
+
+  //! Return modifiable coordinate arrays; could be called only after Allocate().
+  float* ChangeX() { return myOwnedCoords.data(); }
+  float* ChangeY() { return myOwnedCoords.data() + myNbPoints; }
+  float* ChangeZ() { return myOwnedCoords.data() + myNbPoints * 2; }
+
+  //! Return modifiable normal arrays; could be called only after Allocate() with normals.
+  float* ChangeNX() { return myOwnedNormals.data(); }
+  float* ChangeNY() { return myOwnedNormals.data() + myNbPoints; }
+  float* ChangeNZ() { return myOwnedNormals.data() + myNbPoints * 2; }
+
+  //! Return modifiable colors; could be called only after Allocate() with colors.
+  uint32_t* ChangeColors() { return myOwnedColors.data(); }
+
+public:
+
+  //! Load point cloud from file; format is detected by extension:
+  //! - .pcb  native binary format, mapped into memory without copying;
+  //! - .ply  binary little-endian or ASCII PLY with vertex x,y,z and optional nx,ny,nz and red,green,blue[,alpha];
+  //! - .xyz, .pts, .txt  text with "x y z [r g b]" per line.
+  bool Load (const TCollection_AsciiString& thePath);
+
+  //! Save point cloud into native binary format.
+  bool Save (const TCollection_AsciiString& thePath) const;
+
+  //! Compute bounding box (in parallel).
+  Bnd_Box BoundingBox() const;
+
+  //! Compute downsampled cloud with a single point (centroid) per occupied voxel.
+  Handle(OcctPointCloud) VoxelDownsample (double theVoxelSize) const;
+
+  //! Return TRUE if spatial index is built.
+  bool HasIndex() const { return !myTreeIndices.empty(); }
+
+  //! Build kd-tree for nearest-point queries (in parallel).
+  void BuildIndex();
+
+  //! Release kd-tree.
+  void ReleaseIndex();
+
+  //! Find nearest point using spatial index, which should be built beforehand; thread-safe.
+  //! @param[in]  thePnt    query point
+  //! @param[out] theSqDist square distance to found point
+  //! @return index of nearest point or -1 if index is not built
+  int64_t Nearest (const gp_Pnt& thePnt, double& theSqDist) const;
+
+protected:
+
+  //! Load native binary format.
+  bool loadBinary (const std::shared_ptr<OcctMappedFile>& theFile);
+
+  //! Load PLY file.
+  bool loadPly (const std::shared_ptr<OcctMappedFile>& theFile);
+
+  //! Load text file with point per line.
+  bool loadText (const std::shared_ptr<OcctMappedFile>& theFile);
+
+  //! Assign array pointers to own buffers.
+  void bindOwnedArrays();
+
+  //! Build kd-tree subtree within range [theFrom, theTo) of myTreeIndices.
+  void buildSubtree (int64_t theFrom, int64_t theTo);
+
+  //! Split range [theFrom, theTo) of myTreeIndices by median along the longest axis.
+  void splitRange (int64_t theFrom, int64_t theTo);
+
+protected:
+
+  //! Number of points within kd-tree leaf.
+  static const int64_t THE_LEAF_SIZE = 8;
+
+protected:
+
+  std::shared_ptr<OcctMappedFile> myMapping; //!< mapped file
+  std::vector<float>    myOwnedCoords;       //!< own coordinates storage (X, Y, Z blocks)
+  std::vector<float>    myOwnedNormals;      //!< own normals storage (NX, NY, NZ blocks)
+  std::vector<uint32_t> myOwnedColors;       //!< own colors storage
+  int64_t         myNbPoints;
+  const float*    myX;
+  const float*    myY;
+  const float*    myZ;
+  const float*    myNX;
+  const float*    myNY;
+  const float*    myNZ;
+  const uint32_t* myColors;
+
+  // implicit kd-tree: points are reordered so that the median of each range [From, To)
+  // is at the middle (From + To) / 2 splitting range by axis myTreeAxes[middle]
+  std::vector<float>    myTreeCoords;  //!< reordered coordinates (X, Y, Z interleaved for locality)
+  std::vector<uint32_t> myTreeIndices; //!< original point indices
+  std::vector<uint8_t>  myTreeAxes;    //!< split axis of range with the middle at this position
+  int                   myTreeDepth;   //!< number of split levels above the deepest leaf
+
+};
+
+DEFINE_STANDARD_HANDLE(OcctPointCloud, Standard_Transient)
+
+#endif // _OcctPointCloud_HeaderFile
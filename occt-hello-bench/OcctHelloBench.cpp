@@ -0,0 +1,689 @@
+#ifdef _WIN32
+  #include <windows.h>
+#endif
+
+#include <AIS_InteractiveContext.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
+#include <BRepPrimAPI_MakeBox.hxx>
+#include <BRepPrimAPI_MakeCone.hxx>
+#include <BRepPrimAPI_MakeCylinder.hxx>
+#include <BRepPrimAPI_MakeSphere.hxx>
+#include <BRepTools.hxx>
+#include <Message.hxx>
+#include <OpenGl_Context.hxx>
+#include <OpenGl_GraphicDriver.hxx>
+#include <OSD.hxx>
+#include <OSD_Environment.hxx>
+#include <OSD_File.hxx>
+#include <OSD_Parallel.hxx>
+#include <OSD_Path.hxx>
+#include <OSD_Timer.hxx>
+#include <Standard_Version.hxx>
+#include <StdPrs_ToolTriangulatedShape.hxx>
+#include <V3d_View.hxx>
+#include <V3d_Viewer.hxx>
+#include <math_BullardGenerator.hxx>
+
+#ifdef _WIN32
+  #include <WNT_WClass.hxx>
+  #include <WNT_Window.hxx>
+#elif defined(__APPLE__)
+  #include <Cocoa_Window.hxx>
+#else
+  #include <Xw_Window.hxx>
+#endif
+
+#include <BinXCAFDrivers.hxx>
+#include <STEPCAFControl_Controller.hxx>
+#include <STEPCAFControl_Reader.hxx>
+#include <STEPCAFControl_Writer.hxx>
+#include <TDataStd_Name.hxx>
+#include <TDF_LabelMap.hxx>
+#include <TDocStd_Application.hxx>
+#include <XCAFDoc_ColorTool.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+#include <XCAFPrs_AISObject.hxx>
+#include <XCAFPrs_DocumentExplorer.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <vector>
+
+//! Statistics of a single measured metric.
+struct BenchMetric
+{
+  TCollection_AsciiString Dataset; //!< dataset name
+  TCollection_AsciiString Name;    //!< metric name
+  TCollection_AsciiString Unit;    //!< measurement unit
+  std::vector<double>     Values;  //!< measured values
+
+  //! Return value at specified percentile within [0, 1] range.
+  double Percentile (double thePercent) const
+  {
+    if (Values.empty()) { return 0.0; }
+    std::vector<double> aSorted (Values);
+    std::sort (aSorted.begin(), aSorted.end());
+    const size_t anIndex = std::min (aSorted.size() - 1, (size_t )(thePercent * double(aSorted.size() - 1) + 0.5));
+    return aSorted[anIndex];
+  }
+
+  //! Return median value.
+  double Median() const { return Percentile (0.5); }
+
+  //! Return minimal value.
+  double Min() const { return !Values.empty() ? *std::min_element (Values.begin(), Values.end()) : 0.0; }
+
+  //! Return maximal value.
+  double Max() const { return !Values.empty() ? *std::max_element (Values.begin(), Values.end()) : 0.0; }
+};
+
+//! Benchmark parameters.
+struct BenchParams
+{
+  TCollection_AsciiString ModelPath;     //!< STEP model to measure
+  std::vector<int>        SyntheticSizes;//!< number of parts in synthetic assemblies
+  TCollection_AsciiString TmpFolder;     //!< folder for temporary files
+  TCollection_AsciiString OutputPath;    //!< output JSON file
+  TCollection_AsciiString BaselinePath;  //!< baseline JSON file to compare with
+  double                  Tolerance;     //!< relative tolerance for comparison with baseline
+  Graphic3d_Vec2i         ViewSize;      //!< offscreen view dimensions
+  int                     NbRepeats;     //!< number of repetitions of each measurement
+  int                     NbFrames;      //!< number of frames to render
+  int                     NbPicks;       //!< number of picking operations
+
+  BenchParams() : Tolerance (0.1), ViewSize (1024, 768), NbRepeats (3), NbFrames (50), NbPicks (200) {}
+};
+
+//! Headless benchmark of import, display, pick and render operations.
+class OcctHelloBench
+{
+public:
+
+  //! Main constructor.
+  OcctHelloBench (const BenchParams& theParams) : myParams (theParams) {}
+
+  //! Return collected metrics.
+  const std::vector<BenchMetric>& Metrics() const { return myMetrics; }
+
+  //! Initialize offscreen viewer and XCAF application.
+  bool Init()
+  {
+    OSD_Timer aTimer;
+    aTimer.Start();
+    try
+    {
+      OCC_CATCH_SIGNALS
+      Handle(Aspect_DisplayConnection) aDispConnection = new Aspect_DisplayConnection();
+      myDriver = new OpenGl_GraphicDriver (aDispConnection, true);
+      myDriver->ChangeOptions().ffpEnable    = false;
+      myDriver->ChangeOptions().swapInterval = 0;
+
+      Handle(V3d_Viewer) aViewer = new V3d_Viewer (myDriver);
+      aViewer->SetDefaultLights();
+      aViewer->SetLightOn();
+      myContext = new AIS_InteractiveContext (aViewer);
+
+      const TCollection_AsciiString aWinName ("OCCT benchmark window");
+    #if defined(_WIN32)
+      Handle(WNT_WClass) aWinClass = new WNT_WClass ("OffscreenClass", NULL, 0);
+      Handle(WNT_Window) aWindow   = new WNT_Window (aWinName.ToCString(), aWinClass, 0x80000000L, //WS_POPUP,
+                                                     64, 64, 64, 64, Quantity_NOC_BLACK);
+      aWindow->SetVirtual (true);
+      aWindow->SetPos (0, 0, myParams.ViewSize.x(), myParams.ViewSize.y());
+    #elif defined(__APPLE__)
+      Handle(Cocoa_Window) aWindow = new Cocoa_Window (aWinName.ToCString(), 64, 64, myParams.ViewSize.x(), myParams.ViewSize.y());
+    #else
+      Handle(Xw_Window) aWindow = new Xw_Window (aDispConnection, aWinName.ToCString(),
+                                                 64, 64, myParams.ViewSize.x(), myParams.ViewSize.y());
+    #endif
+      aWindow->SetVirtual (true);
+
+      myView = new V3d_View (aViewer);
+      myView->SetWindow (aWindow);
+      myView->SetBackgroundColor (Quantity_NOC_GRAY50);
+      myView->SetProj (V3d_TypeOfOrientation_Zup_AxoRight);
+
+      myXdeApp = new TDocStd_Application();
+      BinXCAFDrivers::DefineFormat (myXdeApp);
+      STEPCAFControl_Controller::Init();
+    }
+    catch (const Standard_Failure& theErr)
+    {
+      Message::SendFail() << "Benchmark initialization FAILED:\n" << theErr;
+      return false;
+    }
+
+    addValue ("common", "init", "s", aTimer.ElapsedTime());
+
+    TColStd_IndexedDataMapOfStringString aGlCapsDict;
+    myView->DiagnosticInformation (aGlCapsDict, Graphic3d_DiagnosticInfo_Basic);
+    for (TColStd_IndexedDataMapOfStringString::Iterator aValueIter (aGlCapsDict); aValueIter.More(); aValueIter.Next())
+    {
+      if (aValueIter.Key() == "GLrenderer") { myRenderer = aValueIter.Value(); }
+    }
+    return true;
+  }
+
+  //! Run benchmark for all datasets.
+  bool Perform()
+  {
+    bool isOk = true;
+    if (!myParams.ModelPath.IsEmpty())
+    {
+      OSD_Path aPath (myParams.ModelPath);
+      isOk = performDataset (aPath.Name(), myParams.ModelPath) && isOk;
+    }
+
+    for (int aNbParts : myParams.SyntheticSizes)
+    {
+      const TCollection_AsciiString aName = TCollection_AsciiString ("synthetic-") + aNbParts;
+      const TCollection_AsciiString aStepPath = myParams.TmpFolder + "/occt-hello-bench-" + aName + ".stp";
+      if (!writeSyntheticAssembly (aNbParts, aStepPath))
+      {
+        isOk = false;
+        continue;
+      }
+      isOk = performDataset (aName, aStepPath) && isOk;
+      OSD_File (OSD_Path (aStepPath)).Remove();
+    }
+    return isOk;
+  }
+
+  //! Write results into JSON file.
+  bool WriteResults (const TCollection_AsciiString& thePath) const
+  {
+    std::ofstream aFile (thePath.ToCString(), std::ios::out | std::ios::trunc);
+    if (!aFile.is_open())
+    {
+      Message::SendFail() << "Error: unable to write file '" << thePath << "'";
+      return false;
+    }
+
+    // one metric per line - to simplify parsing in comparison mode
+    aFile << "{\n"
+          << "\"occt\":\"" << OCC_VERSION_COMPLETE << "\",\n"
+          << "\"renderer\":\"" << myRenderer << "\",\n"
+          << "\"viewSize\":[" << myParams.ViewSize.x() << "," << myParams.ViewSize.y() << "],\n"
+          << "\"repeats\":" << myParams.NbRepeats << ",\n"
+          << "\"results\":[\n";
+    for (size_t aMetricIter = 0; aMetricIter < myMetrics.size(); ++aMetricIter)
+    {
+      const BenchMetric& aMetric = myMetrics[aMetricIter];
+      aFile << "{\"dataset\":\"" << aMetric.Dataset << "\",\"metric\":\"" << aMetric.Name << "\",\"unit\":\"" << aMetric.Unit << "\""
+            << ",\"median\":" << aMetric.Median() << ",\"p95\":" << aMetric.Percentile (0.95)
+            << ",\"min\":" << aMetric.Min() << ",\"max\":" << aMetric.Max()
+            << ",\"samples\":" << (int )aMetric.Values.size() << "}"
+            << (aMetricIter + 1 < myMetrics.size() ? ",\n" : "\n");
+    }
+    aFile << "]\n}\n";
+    return true;
+  }
+
+  //! Print results.
+  void PrintResults() const
+  {
+    Message::SendInfo() << "OCCT " << OCC_VERSION_COMPLETE << ", renderer: " << myRenderer;
+    for (const BenchMetric& aMetric : myMetrics)
+    {
+      Message::SendInfo() << "  " << aMetric.Dataset << "/" << aMetric.Name << ": "
+                          << aMetric.Median() << " " << aMetric.Unit << " (min " << aMetric.Min()
+                          << ", p95 " << aMetric.Percentile (0.95) << ")";
+    }
+  }
+
+  //! Compare median values with baseline file written by previous run.
+  //! All metrics are times, so that only growth of a value is considered as regression.
+  //! @return number of regressions or -1 on error
+  int CompareWithBaseline (const TCollection_AsciiString& thePath, double theTolerance) const
+  {
+    std::ifstream aFile (thePath.ToCString());
+    if (!aFile.is_open())
+    {
+      Message::SendFail() << "Error: unable to open baseline file '" << thePath << "'";
+      return -1;
+    }
+
+    std::map<std::string, double> aBaseMap;
+    std::string aLine;
+    while (std::getline (aFile, aLine))
+    {
+      const std::string aDataset = jsonStringValue (aLine, "dataset");
+      const std::string aName    = jsonStringValue (aLine, "metric");
+      const size_t aMedianPos = aLine.find ("\"median\":");
+      if (aDataset.empty() || aName.empty() || aMedianPos == std::string::npos) { continue; }
+
+      aBaseMap[aDataset + "/" + aName] = std::atof (aLine.c_str() + aMedianPos + 9);
+    }
+
+    int aNbRegressions = 0;
+    for (const BenchMetric& aMetric : myMetrics)
+    {
+      const std::string aKey = std::string (aMetric.Dataset.ToCString()) + "/" + aMetric.Name.ToCString();
+      std::map<std::string, double>::const_iterator aBaseIter = aBaseMap.find (aKey);
+      if (aBaseIter == aBaseMap.end() || aBaseIter->second <= 0.0) { continue; }
+
+      const double aRatio = aMetric.Median() / aBaseIter->second;
+      if (aRatio > 1.0 + theTolerance)
+      {
+        ++aNbRegressions;
+        Message::SendWarning() << "REGRESSION " << aKey.c_str() << ": " << aMetric.Median() << " " << aMetric.Unit
+                               << " vs. baseline " << aBaseIter->second << " (+" << int((aRatio - 1.0) * 100.0 + 0.5) << "%)";
+      }
+      else if (aRatio < 1.0 - theTolerance)
+      {
+        Message::SendInfo() << "IMPROVEMENT " << aKey.c_str() << ": " << aMetric.Median() << " " << aMetric.Unit
+                            << " vs. baseline " << aBaseIter->second << " (-" << int((1.0 - aRatio) * 100.0 + 0.5) << "%)";
+      }
+    }
+    return aNbRegressions;
+  }
+
+private:
+
+  //! Measure all operations for a single STEP file.
+  bool performDataset (const TCollection_AsciiString& theDataset,
+                       const TCollection_AsciiString& theStepPath)
+  {
+    Message::SendInfo() << "Benchmarking '" << theDataset << "'...";
+    const TCollection_AsciiString anXbfPath = myParams.TmpFolder + "/occt-hello-bench-" + theDataset + ".xbf";
+    for (int aRepeatIter = 0; aRepeatIter < myParams.NbRepeats; ++aRepeatIter)
+    {
+      Handle(TDocStd_Document) aDoc;
+      myXdeApp->NewDocument (TCollection_ExtendedString ("BinXCAF"), aDoc);
+
+      // STEP read and transfer
+      OSD_Timer aTimer;
+      STEPCAFControl_Reader aReader;
+      aTimer.Start();
+      if (aReader.ReadFile (theStepPath.ToCString()) != IFSelect_RetDone)
+      {
+        Message::SendFail() << "Error: unable to read STEP file '" << theStepPath << "'";
+        myXdeApp->Close (aDoc);
+        return false;
+      }
+      addValue (theDataset, "step_read", "s", aTimer.ElapsedTime());
+
+      aTimer.Reset();
+      aTimer.Start();
+      if (!aReader.Transfer (aDoc))
+      {
+        Message::SendFail() << "Error: unable to transfer STEP file '" << theStepPath << "'";
+        myXdeApp->Close (aDoc);
+        return false;
+      }
+      addValue (theDataset, "xcaf_transfer", "s", aTimer.ElapsedTime());
+
+      // XBF save and open
+      aTimer.Reset();
+      aTimer.Start();
+      if (myXdeApp->SaveAs (aDoc, TCollection_ExtendedString (anXbfPath)) != PCDM_SS_OK)
+      {
+        Message::SendFail() << "Error: unable to save XBF file '" << anXbfPath << "'";
+        myXdeApp->Close (aDoc);
+        return false;
+      }
+      addValue (theDataset, "xbf_save", "s", aTimer.ElapsedTime());
+      myXdeApp->Close (aDoc);
+      aDoc.Nullify();
+
+      aTimer.Reset();
+      aTimer.Start();
+      if (myXdeApp->Open (TCollection_ExtendedString (anXbfPath), aDoc) != PCDM_RS_OK)
+      {
+        Message::SendFail() << "Error: unable to open XBF file '" << anXbfPath << "'";
+        return false;
+      }
+      addValue (theDataset, "xbf_open", "s", aTimer.ElapsedTime());
+
+      performDisplay (theDataset, aDoc);
+      myXdeApp->Close (aDoc);
+    }
+    OSD_File (OSD_Path (anXbfPath)).Remove();
+    return true;
+  }
+
+  //! Measure meshing, display, picking and rendering of the document.
+  void performDisplay (const TCollection_AsciiString& theDataset,
+                       const Handle(TDocStd_Document)& theDoc)
+  {
+    // collect leaves and unique shapes
+    std::vector<XCAFPrs_DocumentNode> aLeaves;
+    std::vector<TopoDS_Shape> aProtos;
+    TDF_LabelMap aProtoMap;
+    for (XCAFPrs_DocumentExplorer aDocExp (theDoc, XCAFPrs_DocumentExplorerFlags_None); aDocExp.More(); aDocExp.Next())
+    {
+      const XCAFPrs_DocumentNode& aNode = aDocExp.Current();
+      if (aNode.IsAssembly) { continue; }
+
+      aLeaves.push_back (aNode);
+      if (aProtoMap.Add (aNode.RefLabel))
+      {
+        aProtos.push_back (XCAFDoc_ShapeTool::GetShape (aNode.RefLabel));
+      }
+    }
+
+    // meshing with presentation parameters
+    OSD_Timer aTimer;
+    aTimer.Start();
+    const Handle(Prs3d_Drawer)& aDefDrawer = myContext->DefaultDrawer();
+    OSD_Parallel::For (0, (int )aProtos.size(), [&](int theIndex)
+    {
+      Handle(Prs3d_Drawer) aDrawer = new Prs3d_Drawer();
+      aDrawer->SetLink (aDefDrawer);
+      const double aDeflection = StdPrs_ToolTriangulatedShape::GetDeflection (aProtos[theIndex], aDrawer);
+      BRepMesh_IncrementalMesh aMesher (aProtos[theIndex], aDeflection, false, aDrawer->DeviationAngle(), false);
+    });
+    addValue (theDataset, "mesh", "s", aTimer.ElapsedTime());
+
+    // display (presentation and selection computation) of all parts
+    aTimer.Reset();
+    aTimer.Start();
+    for (const XCAFPrs_DocumentNode& aNode : aLeaves)
+    {
+      Handle(XCAFPrs_AISObject) aPrs = new XCAFPrs_AISObject (aNode.RefLabel);
+      if (!aNode.Location.IsIdentity()) { aPrs->SetLocalTransformation (aNode.Location); }
+      myContext->Display (aPrs, AIS_Shaded, 0, false);
+    }
+    addValue (theDataset, "display", "s", aTimer.ElapsedTime());
+
+    // first frame includes uploading of geometry to GPU memory
+    aTimer.Reset();
+    aTimer.Start();
+    myView->FitAll (0.01, false);
+    myView->Redraw();
+    finishFrame();
+    addValue (theDataset, "first_frame", "s", aTimer.ElapsedTime());
+
+    // picking latency at pseudo-random positions within the view
+    {
+      math_BullardGenerator aRandGen (1);
+      BenchMetric& aPickMetric = findMetric (theDataset, "pick", "ms");
+      for (int aPickIter = 0; aPickIter < myParams.NbPicks; ++aPickIter)
+      {
+        const int aPosX = int(aRandGen.NextInt() % (unsigned int )myParams.ViewSize.x());
+        const int aPosY = int(aRandGen.NextInt() % (unsigned int )myParams.ViewSize.y());
+        aTimer.Reset();
+        aTimer.Start();
+        myContext->MoveTo (aPosX, aPosY, myView, false);
+        aPickMetric.Values.push_back (aTimer.ElapsedTime() * 1000.0);
+      }
+      myContext->ClearDetected (false);
+    }
+
+    // render throughput; camera is rotated between frames to avoid any caching
+    {
+      BenchMetric& aFrameMetric = findMetric (theDataset, "frame", "ms");
+      const double anAngleStep = 2.0 * M_PI / double(std::max (myParams.NbFrames, 1));
+      OSD_Timer aTotalTimer;
+      aTotalTimer.Start();
+      for (int aFrameIter = 0; aFrameIter < myParams.NbFrames; ++aFrameIter)
+      {
+        aTimer.Reset();
+        aTimer.Start();
+        const Handle(Graphic3d_Camera)& aCam = myView->Camera();
+        gp_Trsf aRot;
+        aRot.SetRotation (gp_Ax1 (aCam->Center(), gp::DZ()), anAngleStep);
+        aCam->Transform (aRot);
+        myView->Invalidate();
+        myView->Redraw();
+        finishFrame();
+        aFrameMetric.Values.push_back (aTimer.ElapsedTime() * 1000.0);
+      }
+      const double aTotal = aTotalTimer.ElapsedTime();
+      if (aTotal > 0.0)
+      {
+        Message::SendInfo() << "  " << theDataset << ": " << (double(myParams.NbFrames) / aTotal) << " FPS, "
+                            << (int )aLeaves.size() << " parts, " << (int )aProtos.size() << " unique shapes";
+      }
+    }
+
+    myContext->RemoveAll (false);
+    for (const TopoDS_Shape& aShape : aProtos) { BRepTools::Clean (aShape); }
+  }
+
+  //! Wait until GPU finishes rendering for accurate frame time measurement.
+  void finishFrame()
+  {
+    const Handle(OpenGl_Context)& aGlCtx = myDriver->GetSharedContext();
+    if (!aGlCtx.IsNull()) { aGlCtx->core11fwd->glFinish(); }
+  }
+
+  //! Generate synthetic assembly of specified number of parts and save it into STEP file.
+  //! Every tenth part defines a unique shape, other parts are instances placed with pseudo-random rotations.
+  bool writeSyntheticAssembly (int theNbParts, const TCollection_AsciiString& thePath)
+  {
+    Handle(TDocStd_Document) aDoc;
+    myXdeApp->NewDocument (TCollection_ExtendedString ("BinXCAF"), aDoc);
+    Handle(XCAFDoc_ShapeTool) aShapeTool = XCAFDoc_DocumentTool::ShapeTool (aDoc->Main());
+    Handle(XCAFDoc_ColorTool) aColorTool = XCAFDoc_DocumentTool::ColorTool (aDoc->Main());
+
+    const TDF_Label anAsmLab = aShapeTool->NewShape();
+    TDataStd_Name::Set (anAsmLab, TCollection_AsciiString ("SyntheticAssembly-") + theNbParts);
+
+    const int aNbProtos = std::max (1, theNbParts / 10);
+    std::vector<TDF_Label> aProtos;
+    for (int aProtoIter = 0; aProtoIter < aNbProtos; ++aProtoIter)
+    {
+      const double aSize = 5.0 + double(aProtoIter % 7);
+      TopoDS_Shape aShape;
+      switch (aProtoIter % 4)
+      {
+        case 0: aShape = BRepPrimAPI_MakeBox (aSize, aSize * 0.5, aSize * 0.75).Shape(); break;
+        case 1: aShape = BRepPrimAPI_MakeCylinder (aSize * 0.5, aSize).Shape(); break;
+        case 2: aShape = BRepPrimAPI_MakeCone (aSize * 0.5, aSize * 0.1, aSize).Shape(); break;
+        default: aShape = BRepPrimAPI_MakeSphere (aSize * 0.5).Shape(); break;
+      }
+      const TDF_Label aProtoLab = aShapeTool->AddShape (aShape, false);
+      TDataStd_Name::Set (aProtoLab, TCollection_AsciiString ("Part-") + aProtoIter);
+      aColorTool->SetColor (aProtoLab, Quantity_Color (0.3 + 0.1 * (aProtoIter % 7), 0.5, 0.8 - 0.1 * (aProtoIter % 5), Quantity_TOC_RGB),
+                            XCAFDoc_ColorSurf);
+      aProtos.push_back (aProtoLab);
+    }
+
+    math_BullardGenerator aRandGen (theNbParts);
+    const int aGridSize = std::max (1, int(std::ceil (std::sqrt (double(theNbParts)))));
+    for (int aPartIter = 0; aPartIter < theNbParts; ++aPartIter)
+    {
+      gp_Trsf aRot, aTrsl;
+      aRot.SetRotation (gp::OZ(), aRandGen.NextReal() * 2.0 * M_PI);
+      aTrsl.SetTranslation (gp_Vec (20.0 * (aPartIter % aGridSize), 20.0 * (aPartIter / aGridSize), 0.0));
+      aShapeTool->AddComponent (anAsmLab, aProtos[aPartIter % aNbProtos], TopLoc_Location (aTrsl * aRot));
+    }
+    aShapeTool->UpdateAssemblies();
+
+    STEPCAFControl_Writer aWriter;
+    bool isOk = aWriter.Transfer (aDoc, STEPControl_AsIs)
+             && aWriter.Write (thePath.ToCString()) == IFSelect_RetDone;
+    if (!isOk)
+    {
+      Message::SendFail() << "Error: unable to write synthetic assembly into '" << thePath << "'";
+    }
+    myXdeApp->Close (aDoc);
+    return isOk;
+  }
+
+  //! Find or create metric.
+  BenchMetric& findMetric (const TCollection_AsciiString& theDataset,
+                           const TCollection_AsciiString& theName,
+                           const TCollection_AsciiString& theUnit)
+  {
+    for (BenchMetric& aMetric : myMetrics)
+    {
+      if (aMetric.Dataset == theDataset && aMetric.Name == theName) { return aMetric; }
+    }
+    myMetrics.push_back (BenchMetric());
+    myMetrics.back().Dataset = theDataset;
+    myMetrics.back().Name = theName;
+    myMetrics.back().Unit = theUnit;
+    return myMetrics.back();
+  }
+
+  //! Add measured value.
+  void addValue (const TCollection_AsciiString& theDataset,
+                 const TCollection_AsciiString& theName,
+                 const TCollection_AsciiString& theUnit,
+                 double theValue)
+  {
+    findMetric (theDataset, theName, theUnit).Values.push_back (theValue);
+  }
+
+  //! Extract string value of specified key from JSON line.
+  static std::string jsonStringValue (const std::string& theLine, const std::string& theKey)
+  {
+    const std::string aKey = std::string ("\"") + theKey + "\":\"";
+    const size_t aStart = theLine.find (aKey);
+    if (aStart == std::string::npos) { return std::string(); }
+
+    const size_t anEnd = theLine.find ('"', aStart + aKey.size());
+    return anEnd != std::string::npos ? theLine.substr (aStart + aKey.size(), anEnd - aStart - aKey.size()) : std::string();
+  }
+
+private:
+
+  BenchParams                    myParams;   //!< benchmark parameters
+  std::vector<BenchMetric>       myMetrics;  //!< collected metrics
+  TCollection_AsciiString        myRenderer; //!< OpenGL renderer name
+  Handle(OpenGl_GraphicDriver)   myDriver;   //!< graphic driver
+  Handle(AIS_InteractiveContext) myContext;  //!< AIS context
+  Handle(V3d_View)               myView;     //!< offscreen view
+  Handle(TDocStd_Application)    myXdeApp;   //!< XDE application
+
+};
+
+//! Print usage.
+static void printUsage()
+{
+  std::cout << "Usage: occt-hello-bench [-model file.stp] [-nomodel] [-parts N1,N2,...] [-repeat N]\n"
+               "                        [-size WxH] [-frames N] [-picks N] [-tmp folder]\n"
+               "                        [-out results.json] [-compare baseline.json] [-tolerance 0.1]\n";
+}
+
+int main (int theNbArgs, const char** theArgVec)
+{
+  OSD::SetSignal (false);
+
+  BenchParams aParams;
+  aParams.OutputPath = "occt-hello-bench.json";
+  aParams.TmpFolder  = ".";
+  aParams.SyntheticSizes.push_back (100);
+  aParams.SyntheticSizes.push_back (1000);
+  {
+    OSD_Environment aVarModDir ("SAMPLE_MODELS_DIR");
+    if (!aVarModDir.Value().IsEmpty())
+    {
+      aParams.ModelPath = aVarModDir.Value() + "/as1-oc-214.stp";
+    }
+  }
+
+  for (int anArgIter = 1; anArgIter < theNbArgs; ++anArgIter)
+  {
+    TCollection_AsciiString anArg (theArgVec[anArgIter]);
+    anArg.LowerCase();
+    const bool hasNext = anArgIter + 1 < theNbArgs;
+    if (anArg == "-model" && hasNext)
+    {
+      aParams.ModelPath = theArgVec[++anArgIter];
+    }
+    else if (anArg == "-nomodel")
+    {
+      aParams.ModelPath.Clear();
+    }
+    else if (anArg == "-parts" && hasNext)
+    {
+      aParams.SyntheticSizes.clear();
+      TCollection_AsciiString aList (theArgVec[++anArgIter]);
+      for (int aTokenIter = 1;; ++aTokenIter)
+      {
+        TCollection_AsciiString aToken = aList.Token (",", aTokenIter);
+        if (aToken.IsEmpty()) { break; }
+        if (aToken.IntegerValue() > 0) { aParams.SyntheticSizes.push_back (aToken.IntegerValue()); }
+      }
+    }
+    else if (anArg == "-repeat" && hasNext)
+    {
+      aParams.NbRepeats = std::max (1, std::atoi (theArgVec[++anArgIter]));
+    }
+    else if (anArg == "-size" && hasNext)
+    {
+      TCollection_AsciiString aSize (theArgVec[++anArgIter]);
+      aParams.ViewSize.SetValues (aSize.Token ("x", 1).IntegerValue(), aSize.Token ("x", 2).IntegerValue());
+    }
+    else if (anArg == "-frames" && hasNext)
+    {
+      aParams.NbFrames = std::max (1, std::atoi (theArgVec[++anArgIter]));
+    }
+    else if (anArg == "-picks" && hasNext)
+    {
+      aParams.NbPicks = std::max (1, std::atoi (theArgVec[++anArgIter]));
+    }
+    else if (anArg == "-tmp" && hasNext)
+    {
+      aParams.TmpFolder = theArgVec[++anArgIter];
+    }
+    else if (anArg == "-out" && hasNext)
+    {
+      aParams.OutputPath = theArgVec[++anArgIter];
+    }
+    else if (anArg == "-compare" && hasNext)
+    {
+      aParams.BaselinePath = theArgVec[++anArgIter];
+    }
+    else if (anArg == "-tolerance" && hasNext)
+    {
+      aParams.Tolerance = std::atof (theArgVec[++anArgIter]);
+    }
+    else
+    {
+      Message::SendFail() << "Syntax error at '" << theArgVec[anArgIter] << "'";
+      printUsage();
+      return 1;
+    }
+  }
+  if (aParams.ViewSize.x() <= 0 || aParams.ViewSize.y() <= 0)
+  {
+    Message::SendFail() << "Syntax error: invalid view size";
+    return 1;
+  }
+
+  OcctHelloBench aBench (aParams);
+  if (!aBench.Init())
+  {
+    return 1;
+  }
+
+  const bool isOk = aBench.Perform();
+  aBench.PrintResults();
+
+  // baseline is compared before writing results, as it might be the output file of the previous run
+  int aNbRegressions = 0;
+  if (isOk
+  && !aParams.BaselinePath.IsEmpty())
+  {
+    aNbRegressions = aBench.CompareWithBaseline (aParams.BaselinePath, aParams.Tolerance);
+  }
+  if (!aParams.OutputPath.IsEmpty()
+   && aBench.WriteResults (aParams.OutputPath))
+  {
+    Message::SendInfo() << "Results saved into '" << aParams.OutputPath << "'";
+  }
+  if (!isOk
+   || aNbRegressions < 0)
+  {
+    return 1;
+  }
+
+  if (aNbRegressions > 0)
+  {
+    Message::SendFail() << "Benchmark detected " << aNbRegressions << " regression(s) exceeding " << int(aParams.Tolerance * 100.0) << "% tolerance";
+    return 2;
+  }
+  else if (!aParams.BaselinePath.IsEmpty())
+  {
+    Message::SendInfo() << "No regressions found comparing to baseline";
+  }
+  return 0;
+}
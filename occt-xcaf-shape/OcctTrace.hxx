@@ -0,0 +1,192 @@
+#ifndef _OcctTrace_HeaderFile
+#define _OcctTrace_HeaderFile
+
+#include <Message.hxx>
+#include <OSD_Thread.hxx>
+#include <TCollection_AsciiString.hxx>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//! Collector of scoped trace events saved in Chrome Trace Event format (JSON),
+//! which could be opened by chrome://tracing or https://ui.perfetto.dev.
+//! Tracing is disabled by default - in this case OcctTraceScope costs a single atomic flag check,
+//! so that trace scopes could be kept in release builds.
+class OcctTrace
+{
+public:
+
+  //! Return global instance.
+  static OcctTrace& Instance()
+  {
+    static OcctTrace THE_TRACE;
+    return THE_TRACE;
+  }
+
+  //! Return TRUE if tracing is enabled.
+  static bool IsEnabled() { return enabledFlag().load (std::memory_order_relaxed); }
+
+  //! Enable tracing with results to be written into specified file on Stop() or program exit.
+  void Start (const TCollection_AsciiString& theFilePath)
+  {
+    std::lock_guard<std::mutex> aLock (myMutex);
+    myFilePath = theFilePath;
+    myOrigin   = std::chrono::steady_clock::now();
+    myMainThread = OSD_Thread::Current();
+    myEvents.clear();
+    myEvents.reserve (4096);
+    enabledFlag().store (true);
+  }
+
+  //! Disable tracing and write collected events into file.
+  void Stop()
+  {
+    if (!enabledFlag().exchange (false)) { return; }
+
+    std::lock_guard<std::mutex> aLock (myMutex);
+    std::ofstream aFile (myFilePath.ToCString(), std::ios::out | std::ios::trunc);
+    if (!aFile.is_open())
+    {
+      Message::SendFail() << "Error: unable to write trace file '" << myFilePath << "'";
+      return;
+    }
+
+    aFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    aFile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << myMainThread << ",\"args\":{\"name\":\"main\"}}";
+    for (const Event& anEvent : myEvents)
+    {
+      aFile << ",\n{\"name\":\"" << anEvent.Name << "\",\"cat\":\"occt\",\"ph\":\"X\",\"pid\":1"
+            << ",\"tid\":" << anEvent.ThreadId
+            << ",\"ts\":"  << anEvent.Start
+            << ",\"dur\":" << anEvent.Duration;
+      if (!anEvent.Details.empty())
+      {
+        aFile << ",\"args\":{\"details\":\"" << escapeJson (anEvent.Details) << "\"}";
+      }
+      aFile << "}";
+    }
+    aFile << "\n]}\n";
+    Message::SendInfo() << "Trace with " << (int )myEvents.size() << " events saved into '" << myFilePath << "'";
+    myEvents.clear();
+  }
+
+  //! Return time in microseconds since Start().
+  int64_t Now() const
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds> (std::chrono::steady_clock::now() - myOrigin).count();
+  }
+
+  //! Add complete event; thread-safe.
+  //! @param[in] theName    event name, should be a string literal
+  //! @param[in] theDetails optional event details
+  //! @param[in] theStart   event start time in microseconds
+  void AddEvent (const char* theName,
+                 const std::string& theDetails,
+                 int64_t theStart)
+  {
+    Event anEvent;
+    anEvent.Name     = theName;
+    anEvent.Details  = theDetails;
+    anEvent.ThreadId = OSD_Thread::Current();
+    anEvent.Start    = theStart;
+    anEvent.Duration = Now() - theStart;
+
+    std::lock_guard<std::mutex> aLock (myMutex);
+    if (IsEnabled()) { myEvents.push_back (anEvent); }
+  }
+
+private:
+
+  //! Trace event.
+  struct Event
+  {
+    const char*       Name;     //!< event name
+    std::string       Details;  //!< optional details
+    Standard_ThreadId ThreadId; //!< thread id
+    int64_t           Start;    //!< start time in microseconds
+    int64_t           Duration; //!< duration in microseconds
+  };
+
+private:
+
+  //! Empty constructor.
+  OcctTrace() : myMainThread (0) {}
+
+  //! Destructor writing pending events.
+  ~OcctTrace() { Stop(); }
+
+  //! Flag indicating that tracing is enabled.
+  static std::atomic<bool>& enabledFlag()
+  {
+    static std::atomic<bool> THE_FLAG (false);
+    return THE_FLAG;
+  }
+
+  //! Escape string for JSON output.
+  static std::string escapeJson (const std::string& theStr)
+  {
+    std::string aRes;
+    for (const char aChar : theStr)
+    {
+      if (aChar == '"' || aChar == '\\') { aRes += '\\'; }
+      if ((unsigned char )aChar < 0x20)  { aRes += ' '; continue; }
+      aRes += aChar;
+    }
+    return aRes;
+  }
+
+private:
+
+  std::mutex              myMutex;      //!< lock for events list
+  std::vector<Event>      myEvents;     //!< collected events
+  TCollection_AsciiString myFilePath;   //!< output file path
+  std::chrono::steady_clock::time_point myOrigin; //!< time origin
+  Standard_ThreadId       myMainThread; //!< id of a thread started tracing
+
+};
+
+//! Scoped trace event - measures time between construction and destruction.
+//! Nothing is measured when tracing is disabled.
+class OcctTraceScope
+{
+public:
+
+  //! Main constructor.
+  //! @param[in] theName event name, should be a string literal
+  explicit OcctTraceScope (const char* theName)
+  : myName (theName), myStart (0), myIsActive (OcctTrace::IsEnabled())
+  {
+    if (myIsActive) { myStart = OcctTrace::Instance().Now(); }
+  }
+
+  //! Destructor adding event to the trace.
+  ~OcctTraceScope()
+  {
+    if (myIsActive) { OcctTrace::Instance().AddEvent (myName, myDetails, myStart); }
+  }
+
+  //! Return TRUE if event is recorded; could be used to skip formatting of details.
+  bool IsActive() const { return myIsActive; }
+
+  //! Set event details.
+  void SetDetails (const TCollection_AsciiString& theDetails) { myDetails = theDetails.ToCString(); }
+
+private:
+
+  OcctTraceScope (const OcctTraceScope& ) = delete;
+  OcctTraceScope& operator= (const OcctTraceScope& ) = delete;
+
+private:
+
+  const char* myName;
+  std::string myDetails; // std::string is used as it doesn't allocate memory when empty
+  int64_t     myStart;
+  bool        myIsActive;
+
+};
+
+#endif // _OcctTrace_HeaderFile
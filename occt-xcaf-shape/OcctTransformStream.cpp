@@ -0,0 +1,248 @@
+#include "OcctTransformStream.hxx"
+
+#include <gp_QuaternionNLerp.hxx>
+#include <Message.hxx>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+  //! Stream file magic.
+  static const char THE_STREAM_MAGIC[8] = { 'O', 'C', 'C', 'T', 'K', 'S', '1', '\0' };
+
+  //! Round up offset to 8 bytes.
+  static uint64_t alignOffset (uint64_t theOffset) { return (theOffset + 7) & ~uint64_t(7); }
+}
+
+// Empty constructor.
+OcctTransformStream::OcctTransformStream()
+: myHeader (NULL), myNodes (NULL), myIds (NULL), myRecords (NULL),
+  myTimeFrom (0.0), myTimeTo (0.0)
+{
+  //
+}
+
+// Unmap file.
+void OcctTransformStream::Close()
+{
+  myFile.Close();
+  myHeader  = NULL;
+  myNodes   = NULL;
+  myIds     = NULL;
+  myRecords = NULL;
+  myCursors.clear();
+  myTimeFrom = myTimeTo = 0.0;
+}
+
+// Map stream file into memory.
+bool OcctTransformStream::Open (const TCollection_AsciiString& thePath)
+{
+  Close();
+  if (!myFile.Open (thePath))
+  {
+    Message::SendFail() << "Error: unable to open transform stream '" << thePath << "'";
+    return false;
+  }
+
+  const uint64_t aSize = myFile.Size();
+  const Header* aHeader = (const Header* )myFile.Data();
+  if (aSize < sizeof(Header)
+   || std::memcmp (aHeader->Magic, THE_STREAM_MAGIC, sizeof(THE_STREAM_MAGIC)) != 0)
+  {
+    Message::SendFail() << "Error: file '" << thePath << "' is not a transform stream";
+    Close();
+    return false;
+  }
+
+  // header values are untrusted - sizes are compared by division to avoid overflow on crafted files
+  const uint64_t aNodesEnd = sizeof(Header) + uint64_t(aHeader->NbNodes) * sizeof(NodeEntry) + aHeader->IdsSize;
+  if (aNodesEnd > aSize
+   || aHeader->RecordsOffset < aNodesEnd
+   || aHeader->RecordsOffset > aSize
+   || aHeader->RecordsOffset % 8 != 0
+   || aHeader->NbRecords > (aSize - aHeader->RecordsOffset) / sizeof(Record))
+  {
+    Message::SendFail() << "Error: transform stream '" << thePath << "' is truncated";
+    Close();
+    return false;
+  }
+
+  myHeader  = aHeader;
+  myNodes   = (const NodeEntry* )(myFile.Data() + sizeof(Header));
+  myIds     = (const char* )(myNodes + aHeader->NbNodes);
+  myRecords = (const Record* )(myFile.Data() + aHeader->RecordsOffset);
+
+  bool isFirst = true;
+  for (uint32_t aNodeIter = 0; aNodeIter < aHeader->NbNodes; ++aNodeIter)
+  {
+    const NodeEntry& aNode = myNodes[aNodeIter];
+    if (aNode.FirstRecord > aHeader->NbRecords
+     || aNode.NbRecords > aHeader->NbRecords - aNode.FirstRecord
+     || uint64_t(aNode.IdOffset) + aNode.IdLength > aHeader->IdsSize)
+    {
+      Message::SendFail() << "Error: transform stream '" << thePath << "' has invalid node table";
+      Close();
+      return false;
+    }
+    if (aNode.NbRecords == 0)
+    {
+      continue;
+    }
+
+    const double aFrom = myRecords[aNode.FirstRecord].Time;
+    const double aTo   = myRecords[aNode.FirstRecord + aNode.NbRecords - 1].Time;
+    myTimeFrom = isFirst ? aFrom : std::min (myTimeFrom, aFrom);
+    myTimeTo   = isFirst ? aTo   : std::max (myTimeTo,   aTo);
+    isFirst = false;
+  }
+
+  myCursors.assign (aHeader->NbNodes, 0);
+  return true;
+}
+
+// Return node id.
+TCollection_AsciiString OcctTransformStream::NodeId (int theNode) const
+{
+  const NodeEntry& aNode = myNodes[theNode];
+  return TCollection_AsciiString (myIds + aNode.IdOffset, (int )aNode.IdLength);
+}
+
+// Convert record matrix into transformation.
+gp_Trsf OcctTransformStream::matrixToTrsf (const double* theMatrix)
+{
+  gp_Trsf aTrsf;
+  aTrsf.SetValues (theMatrix[0], theMatrix[1], theMatrix[2],  theMatrix[3],
+                   theMatrix[4], theMatrix[5], theMatrix[6],  theMatrix[7],
+                   theMatrix[8], theMatrix[9], theMatrix[10], theMatrix[11]);
+  return aTrsf;
+}
+
+// Fill in record matrix from transformation.
+void OcctTransformStream::SetMatrix (Record& theRecord, const gp_Trsf& theTrsf)
+{
+  for (int aRow = 1; aRow <= 3; ++aRow)
+  {
+    for (int aCol = 1; aCol <= 4; ++aCol)
+    {
+      theRecord.Matrix[(aRow - 1) * 4 + aCol - 1] = theTrsf.Value (aRow, aCol);
+    }
+  }
+}
+
+// Evaluate transformations of all nodes at specified time.
+void OcctTransformStream::Evaluate (double theTime, gp_Trsf* theTrsfs)
+{
+  const int aNbNodes = NbNodes();
+  for (int aNodeIter = 0; aNodeIter < aNbNodes; ++aNodeIter)
+  {
+    const NodeEntry& aNode = myNodes[aNodeIter];
+    if (aNode.NbRecords == 0)
+    {
+      continue;
+    }
+
+    const Record* aRecs = myRecords + aNode.FirstRecord;
+    uint32_t& aCursor = myCursors[aNodeIter];
+    if (aRecs[aCursor].Time > theTime)
+    {
+      // seek backwards (rewind) by binary search
+      const Record* anUpper = std::upper_bound (aRecs, aRecs + aNode.NbRecords, theTime,
+                                                [](double theValue, const Record& theRec) { return theValue < theRec.Time; });
+      aCursor = anUpper != aRecs ? uint32_t(anUpper - aRecs - 1) : 0;
+    }
+    while (aCursor + 1 < aNode.NbRecords
+        && aRecs[aCursor + 1].Time <= theTime)
+    {
+      ++aCursor;
+    }
+
+    const Record& aRec0 = aRecs[aCursor];
+    if (aCursor + 1 >= aNode.NbRecords
+     || theTime <= aRec0.Time)
+    {
+      theTrsfs[aNodeIter] = matrixToTrsf (aRec0.Matrix);
+      continue;
+    }
+
+    const Record& aRec1 = aRecs[aCursor + 1];
+    const double aT = (theTime - aRec0.Time) / (aRec1.Time - aRec0.Time);
+    const gp_Trsf aTrsf0 = matrixToTrsf (aRec0.Matrix);
+    const gp_Trsf aTrsf1 = matrixToTrsf (aRec1.Matrix);
+    const gp_XYZ  aLoc0 = aTrsf0.TranslationPart(), aLoc1 = aTrsf1.TranslationPart();
+    gp_Trsf& aTrsf = theTrsfs[aNodeIter];
+    aTrsf.SetRotation (gp_QuaternionNLerp::Interpolate (aTrsf0.GetRotation(), aTrsf1.GetRotation(), aT));
+    aTrsf.SetTranslationPart (gp_Vec (aLoc0 + (aLoc1 - aLoc0) * aT));
+  }
+}
+
+// Write stream into file.
+bool OcctTransformStream::Write (const TCollection_AsciiString& thePath,
+                                 const std::vector<TCollection_AsciiString>& theIds,
+                                 const std::vector<Record>& theRecords)
+{
+  std::vector<Record> aRecords (theRecords);
+  std::stable_sort (aRecords.begin(), aRecords.end(), [](const Record& theLeft, const Record& theRight)
+  {
+    return theLeft.Node < theRight.Node
+        || (theLeft.Node == theRight.Node && theLeft.Time < theRight.Time);
+  });
+
+  Header aHeader;
+  std::memcpy (aHeader.Magic, THE_STREAM_MAGIC, sizeof(THE_STREAM_MAGIC));
+  aHeader.NbNodes   = (uint32_t )theIds.size();
+  aHeader.IdsSize   = 0;
+  aHeader.NbRecords = aRecords.size();
+
+  std::vector<NodeEntry> aNodes (theIds.size());
+  for (size_t aNodeIter = 0; aNodeIter < theIds.size(); ++aNodeIter)
+  {
+    NodeEntry& aNode = aNodes[aNodeIter];
+    aNode.FirstRecord = 0;
+    aNode.NbRecords   = 0;
+    aNode.IdOffset    = aHeader.IdsSize;
+    aNode.IdLength    = (uint32_t )theIds[aNodeIter].Length();
+    aNode.Reserved    = 0;
+    aHeader.IdsSize  += aNode.IdLength;
+  }
+  for (size_t aRecIter = 0; aRecIter < aRecords.size(); ++aRecIter)
+  {
+    const uint32_t aNodeIndex = aRecords[aRecIter].Node;
+    if (aNodeIndex >= aNodes.size())
+    {
+      Message::SendFail() << "Error: transform record refers to unknown node " << (int )aNodeIndex;
+      return false;
+    }
+    if (aNodes[aNodeIndex].NbRecords++ == 0)
+    {
+      aNodes[aNodeIndex].FirstRecord = aRecIter;
+    }
+  }
+
+  const uint64_t aNodesEnd = sizeof(Header) + aNodes.size() * sizeof(NodeEntry) + aHeader.IdsSize;
+  aHeader.RecordsOffset = alignOffset (aNodesEnd);
+
+  std::ofstream aFile (thePath.ToCString(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!aFile.is_open())
+  {
+    Message::SendFail() << "Error: unable to create file '" << thePath << "'";
+    return false;
+  }
+
+  const char aPadding[8] = {};
+  aFile.write ((const char* )&aHeader, sizeof(aHeader));
+  aFile.write ((const char* )aNodes.data(), aNodes.size() * sizeof(NodeEntry));
+  for (const TCollection_AsciiString& anId : theIds)
+  {
+    aFile.write (anId.ToCString(), anId.Length());
+  }
+  aFile.write (aPadding, aHeader.RecordsOffset - aNodesEnd);
+  aFile.write ((const char* )aRecords.data(), aRecords.size() * sizeof(Record));
+  if (!aFile.good())
+  {
+    Message::SendFail() << "Error: unable to write file '" << thePath << "'";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,120 @@
+#ifndef _OcctTransformStream_HeaderFile
+#define _OcctTransformStream_HeaderFile
+
+#include "OcctMappedFile.hxx"
+
+#include <gp_Trsf.hxx>
+
+#include <cstdint>
+#include <vector>
+
+//! Recorded motion of document nodes - a binary stream of (node, time, matrix) records.
+//! The file is memory-mapped and interpolated on the fly, so that loading is instant
+//! and evaluation of a frame does not allocate memory.
+//!
+//! File layout (little-endian):
+//! - Header: magic "OCCTKS1\0", number of nodes, size of ids pool, number of records and records offset;
+//! - NodeEntry table: range of records and id of each node;
+//! - ids pool: node ids (XCAFPrs_DocumentNode::Id) without terminating zeros;
+//! - Record array at 8-byte aligned offset: records of each node are contiguous and sorted by time.
+//! Matrix is a 3x4 row-major rigid transformation of the node in world coordinates (XCAFPrs_DocumentNode::Location).
+class OcctTransformStream
+{
+public:
+
+  //! File header.
+  struct Header
+  {
+    char     Magic[8];
+    uint32_t NbNodes;
+    uint32_t IdsSize;
+    uint64_t NbRecords;
+    uint64_t RecordsOffset;
+  };
+
+  //! Node table entry.
+  struct NodeEntry
+  {
+    uint64_t FirstRecord;
+    uint32_t NbRecords;
+    uint32_t IdOffset;
+    uint32_t IdLength;
+    uint32_t Reserved;
+  };
+
+  //! Transformation record.
+  struct Record
+  {
+    uint32_t Node;
+    uint32_t Reserved;
+    double   Time;
+    double   Matrix[12];
+  };
+
+public:
+
+  //! Empty constructor.
+  OcctTransformStream();
+
+  //! Map stream file into memory and validate its structure.
+  bool Open (const TCollection_AsciiString& thePath);
+
+  //! Unmap file.
+  void Close();
+
+  //! Return number of nodes.
+  int NbNodes() const { return myHeader != NULL ? (int )myHeader->NbNodes : 0; }
+
+  //! Return number of records.
+  int64_t NbRecords() const { return myHeader != NULL ? (int64_t )myHeader->NbRecords : 0; }
+
+  //! Return node id.
+  TCollection_AsciiString NodeId (int theNode) const;
+
+  //! Return time of the first record.
+  double TimeFrom() const { return myTimeFrom; }
+
+  //! Return time of the last record.
+  double TimeTo() const { return myTimeTo; }
+
+  //! Evaluate transformations of all nodes at specified time.
+  //! Per-node cursors make sequential playback O(1) per node; not thread-safe.
+  //! @param[in]  theTime  time to evaluate
+  //! @param[out] theTrsfs array of NbNodes() transformations; nodes without records are left untouched
+  void Evaluate (double theTime, gp_Trsf* theTrsfs);
+
+  //! Write stream into file.
+  //! @param[in] thePath    file path
+  //! @param[in] theIds     node ids
+  //! @param[in] theRecords records of all nodes, which will be sorted by node and time
+  static bool Write (const TCollection_AsciiString& thePath,
+                     const std::vector<TCollection_AsciiString>& theIds,
+                     const std::vector<Record>& theRecords);
+
+  //! Fill in record matrix from transformation.
+  static void SetMatrix (Record& theRecord, const gp_Trsf& theTrsf);
+
+private:
+
+  //! Convert record matrix into transformation.
+  static gp_Trsf matrixToTrsf (const double* theMatrix);
+
+private:
+
+  OcctTransformStream (const OcctTransformStream& ) = delete;
+  OcctTransformStream& operator= (const OcctTransformStream& ) = delete;
+
+private:
+
+  OcctMappedFile        myFile;
+  const Header*         myHeader;
+  const NodeEntry*      myNodes;
+  const char*           myIds;
+  const Record*         myRecords;
+  std::vector<uint32_t> myCursors;  //!< per-node index of record preceding last evaluated time
+  double                myTimeFrom;
+  double                myTimeTo;
+
+};
+
+#endif // _OcctTransformStream_HeaderFile
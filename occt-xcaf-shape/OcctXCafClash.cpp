@@ -0,0 +1,415 @@
+#include "OcctXCafClash.hxx"
+
+#include <BRepBndLib.hxx>
+#include <BRepExtrema_TriangleSet.hxx>
+#include <BVH_Traverse.hxx>
+#include <Message.hxx>
+#include <NCollection_DataMap.hxx>
+#include <OSD_Parallel.hxx>
+#include <OSD_Timer.hxx>
+#include <TColStd_PackedMapOfInteger.hxx>
+#include <TDF_LabelMapHasher.hxx>
+#include <TopExp_Explorer.hxx>
+#include <TopoDS.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+#include <XCAFPrs_DocumentExplorer.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+  //! Relative precision of separating axis test.
+  static const double THE_SAT_EPSILON = 1.0e-9;
+
+  //! Append normalized cross product of two vectors to the list of axes, unless vectors are (nearly) parallel.
+  static void addSeparatingAxis (const BVH_Vec3d& theVec1,
+                                 const BVH_Vec3d& theVec2,
+                                 BVH_Vec3d* theAxes,
+                                 int& theNbAxes)
+  {
+    const BVH_Vec3d anAxis = BVH_Vec3d::Cross (theVec1, theVec2);
+    const double aLen = anAxis.Modulus();
+    // |a x b| = |a| |b| sin(angle), so that threshold is scale-independent
+    if (aLen > THE_SAT_EPSILON * theVec1.Modulus() * theVec2.Modulus())
+    {
+      theAxes[theNbAxes++] = anAxis / aLen;
+    }
+  }
+
+  //! Test two triangles for overlap by separating axis theorem.
+  //! With zero tolerance, touching triangles (coplanar contact, shared edges of mating parts) are considered separated,
+  //! so that only penetration is reported; otherwise triangles closer than tolerance along every axis are considered overlapping.
+  static bool overlapTriangles (const BVH_Vec3d theTri1[3],
+                                const BVH_Vec3d theTri2[3],
+                                double theTolerance)
+  {
+    const BVH_Vec3d anEdges1[3] = { theTri1[1] - theTri1[0], theTri1[2] - theTri1[1], theTri1[0] - theTri1[2] };
+    const BVH_Vec3d anEdges2[3] = { theTri2[1] - theTri2[0], theTri2[2] - theTri2[1], theTri2[0] - theTri2[2] };
+    const BVH_Vec3d aNorm1 = BVH_Vec3d::Cross (anEdges1[0], anEdges1[1]);
+    const BVH_Vec3d aNorm2 = BVH_Vec3d::Cross (anEdges2[0], anEdges2[1]);
+
+    // face normals, edge-edge axes and in-plane edge normals (for coplanar triangles)
+    BVH_Vec3d anAxes[17];
+    int aNbAxes = 0;
+    addSeparatingAxis (anEdges1[0], anEdges1[1], anAxes, aNbAxes);
+    addSeparatingAxis (anEdges2[0], anEdges2[1], anAxes, aNbAxes);
+    for (int anEdgeIter1 = 0; anEdgeIter1 < 3; ++anEdgeIter1)
+    {
+      for (int anEdgeIter2 = 0; anEdgeIter2 < 3; ++anEdgeIter2)
+      {
+        addSeparatingAxis (anEdges1[anEdgeIter1], anEdges2[anEdgeIter2], anAxes, aNbAxes);
+      }
+      addSeparatingAxis (aNorm1, anEdges1[anEdgeIter1], anAxes, aNbAxes);
+      addSeparatingAxis (aNorm2, anEdges2[anEdgeIter1], anAxes, aNbAxes);
+    }
+
+    for (int anAxisIter = 0; anAxisIter < aNbAxes; ++anAxisIter)
+    {
+      const BVH_Vec3d& anAxis = anAxes[anAxisIter];
+      double aMin1 = anAxis.Dot (theTri1[0]), aMax1 = aMin1;
+      double aMin2 = anAxis.Dot (theTri2[0]), aMax2 = aMin2;
+      for (int aVertIter = 1; aVertIter < 3; ++aVertIter)
+      {
+        const double aProj1 = anAxis.Dot (theTri1[aVertIter]);
+        const double aProj2 = anAxis.Dot (theTri2[aVertIter]);
+        aMin1 = std::min (aMin1, aProj1); aMax1 = std::max (aMax1, aProj1);
+        aMin2 = std::min (aMin2, aProj2); aMax2 = std::max (aMax2, aProj2);
+      }
+
+      if (theTolerance > 0.0)
+      {
+        if (aMin2 > aMax1 + theTolerance
+         || aMin1 > aMax2 + theTolerance)
+        {
+          return false;
+        }
+      }
+      else
+      {
+        // contact within rounding errors of projections is not a penetration
+        const double aPrec = THE_SAT_EPSILON * std::max (std::max (std::abs (aMin1), std::abs (aMax1)),
+                                                         std::max (std::abs (aMin2), std::abs (aMax2)));
+        if (aMin2 >= aMax1 - aPrec
+         || aMin1 >= aMax2 - aPrec)
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  //! Pair traversal of BVH trees of two prototype triangle sets, the second one placed by relative transformation;
+  //! collects faces having overlapping triangles.
+  //! Follows BRepExtrema_OverlapTool, which expects both sets in the same coordinate system
+  //! and therefore would require triangle sets and BVH trees to be rebuilt for each instance.
+  class OcctXCafClashTraverse : public BVH_PairTraverse<Standard_Real, 3>
+  {
+  public:
+
+    //! Main constructor.
+    //! @param[in] theSet1      triangle set of the first prototype
+    //! @param[in] theSet2      triangle set of the second prototype
+    //! @param[in] theTrsf2     transformation of the second set into coordinate system of the first one
+    //! @param[in] theTolerance proximity tolerance within coordinate system of the first set
+    OcctXCafClashTraverse (const Handle(BRepExtrema_TriangleSet)& theSet1,
+                           const Handle(BRepExtrema_TriangleSet)& theSet2,
+                           const gp_Trsf& theTrsf2,
+                           double theTolerance)
+    : mySet1 (theSet1), mySet2 (theSet2), myTolerance (theTolerance)
+    {
+      for (int aRow = 0; aRow < 3; ++aRow)
+      {
+        for (int aCol = 0; aCol < 4; ++aCol)
+        {
+          myTrsf2[aRow][aCol] = theTrsf2.Value (aRow + 1, aCol + 1);
+        }
+      }
+    }
+
+    //! Faces of the first set overlapping the second one.
+    const TColStd_PackedMapOfInteger& OverlapFaces1() const { return myFaces1; }
+
+    //! Faces of the second set overlapping the first one.
+    const TColStd_PackedMapOfInteger& OverlapFaces2() const { return myFaces2; }
+
+    //! Perform traversal; BVH trees should be already built.
+    void Perform() { Select (mySet1->BVH(), mySet2->BVH()); }
+
+    //! Reject pair of nodes if boxes are farther than tolerance;
+    //! box of the second node is transformed into the first coordinate system as a box enclosing transformed one.
+    virtual Standard_Boolean RejectNode (const BVH_Vec3d& theCornerMin1,
+                                         const BVH_Vec3d& theCornerMax1,
+                                         const BVH_Vec3d& theCornerMin2,
+                                         const BVH_Vec3d& theCornerMax2,
+                                         Standard_Real& ) const override
+    {
+      const BVH_Vec3d aCenter2 = (theCornerMin2 + theCornerMax2) * 0.5;
+      const BVH_Vec3d aHalf2   = (theCornerMax2 - theCornerMin2) * 0.5;
+      for (int anAxis = 0; anAxis < 3; ++anAxis)
+      {
+        const double* aRow = myTrsf2[anAxis];
+        const double aCenter = aRow[0] * aCenter2.x() + aRow[1] * aCenter2.y() + aRow[2] * aCenter2.z() + aRow[3];
+        const double aHalf   = std::abs (aRow[0]) * aHalf2.x() + std::abs (aRow[1]) * aHalf2.y() + std::abs (aRow[2]) * aHalf2.z();
+        if (aCenter - aHalf > theCornerMax1[anAxis] + myTolerance
+         || aCenter + aHalf < theCornerMin1[anAxis] - myTolerance)
+        {
+          return Standard_True;
+        }
+      }
+      return Standard_False;
+    }
+
+    //! Test triangles for overlap and mark their faces.
+    virtual Standard_Boolean Accept (const Standard_Integer theIndex1,
+                                     const Standard_Integer theIndex2) override
+    {
+      const Standard_Integer aFace1 = mySet1->GetFaceID (theIndex1);
+      const Standard_Integer aFace2 = mySet2->GetFaceID (theIndex2);
+      if (myFaces1.Contains (aFace1)
+       && myFaces2.Contains (aFace2))
+      {
+        return Standard_False; // both faces are already known to overlap
+      }
+
+      BVH_Vec3d aTri1[3], aTri2[3];
+      mySet1->GetVertices (theIndex1, aTri1[0], aTri1[1], aTri1[2]);
+      mySet2->GetVertices (theIndex2, aTri2[0], aTri2[1], aTri2[2]);
+      for (BVH_Vec3d& aVert : aTri2)
+      {
+        const BVH_Vec3d aLocal = aVert;
+        for (int anAxis = 0; anAxis < 3; ++anAxis)
+        {
+          const double* aRow = myTrsf2[anAxis];
+          aVert[anAxis] = aRow[0] * aLocal.x() + aRow[1] * aLocal.y() + aRow[2] * aLocal.z() + aRow[3];
+        }
+      }
+      if (!overlapTriangles (aTri1, aTri2, myTolerance))
+      {
+        return Standard_False;
+      }
+
+      myFaces1.Add (aFace1);
+      myFaces2.Add (aFace2);
+      return Standard_True;
+    }
+
+  private:
+
+    Handle(BRepExtrema_TriangleSet) mySet1;      //!< triangles of the first prototype
+    Handle(BRepExtrema_TriangleSet) mySet2;      //!< triangles of the second prototype
+    double                          myTrsf2[3][4]; //!< transformation of the second set (3x4 matrix)
+    double                          myTolerance; //!< proximity tolerance
+    TColStd_PackedMapOfInteger      myFaces1;    //!< overlapping faces of the first set
+    TColStd_PackedMapOfInteger      myFaces2;    //!< overlapping faces of the second set
+
+  };
+}
+
+// Empty constructor.
+OcctXCafClash::OcctXCafClash()
+: myTolerance (0.0),
+  myNbCandidates (0),
+  myNbProtos (0),
+  myPrepTime (0.0),
+  myBroadTime (0.0),
+  myNarrowTime (0.0)
+{
+  //
+}
+
+// Detect clashes between leaves of document.
+bool OcctXCafClash::Perform (const Handle(TDocStd_Document)& theDoc)
+{
+  myLeafIds.clear();
+  myClashes.clear();
+  myNbCandidates = 0;
+  if (theDoc.IsNull())
+  {
+    return false;
+  }
+
+  // collect leaves and unique prototypes
+  OSD_Timer aTimer;
+  aTimer.Start();
+  std::vector<TopoDS_Shape> aProtoShapes;
+  std::vector<Bnd_Box>      aProtoBoxes;
+  std::vector<int>          aLeafProtos;
+  std::vector<gp_Trsf>      aLeafTrsfs;
+  NCollection_DataMap<TDF_Label, int, TDF_LabelMapHasher> aProtoIndices;
+  for (XCAFPrs_DocumentExplorer aDocExp (theDoc, XCAFPrs_DocumentExplorerFlags_None); aDocExp.More(); aDocExp.Next())
+  {
+    const XCAFPrs_DocumentNode& aNode = aDocExp.Current();
+    if (aNode.IsAssembly) { continue; }
+
+    int aProtoIndex = -1;
+    if (!aProtoIndices.Find (aNode.RefLabel, aProtoIndex))
+    {
+      aProtoIndex = (int )aProtoShapes.size();
+      aProtoIndices.Bind (aNode.RefLabel, aProtoIndex);
+      aProtoShapes.push_back (XCAFDoc_ShapeTool::GetShape (aNode.RefLabel));
+    }
+    if (aProtoShapes[aProtoIndex].IsNull()) { continue; }
+
+    myLeafIds.push_back (aNode.Id);
+    aLeafProtos.push_back (aProtoIndex);
+    aLeafTrsfs.push_back (aNode.Location);
+  }
+  myNbProtos = (int )aProtoShapes.size();
+
+  // bounding box, triangle set and its BVH are built once per prototype and shared by all its instances
+  aProtoBoxes.resize (aProtoShapes.size());
+  std::vector<Handle(BRepExtrema_TriangleSet)> aProtoTris (aProtoShapes.size());
+  OSD_Parallel::For (0, (int )aProtoShapes.size(), [&](int theIndex)
+  {
+    const TopoDS_Shape& aProto = aProtoShapes[theIndex];
+    if (aProto.IsNull()) { return; }
+
+    BRepBndLib::Add (aProto, aProtoBoxes[theIndex]);
+    BRepExtrema_ShapeList aFaces;
+    for (TopExp_Explorer aFaceExp (aProto, TopAbs_FACE); aFaceExp.More(); aFaceExp.Next())
+    {
+      aFaces.Append (TopoDS::Face (aFaceExp.Current()));
+    }
+    aProtoTris[theIndex] = new BRepExtrema_TriangleSet (aFaces);
+    if (aProtoTris[theIndex]->Size() > 0)
+    {
+      aProtoTris[theIndex]->BVH();
+    }
+  });
+
+  const int aNbLeaves = (int )myLeafIds.size();
+  std::vector<Bnd_Box> aLeafBoxes (aNbLeaves);
+  Bnd_Box aSceneBox;
+  for (int aLeafIter = 0; aLeafIter < aNbLeaves; ++aLeafIter)
+  {
+    const Bnd_Box& aProtoBox = aProtoBoxes[aLeafProtos[aLeafIter]];
+    if (aProtoBox.IsVoid()) { continue; }
+
+    aLeafBoxes[aLeafIter] = aProtoBox.Transformed (aLeafTrsfs[aLeafIter]);
+    aLeafBoxes[aLeafIter].Enlarge (myTolerance * 0.5);
+    aSceneBox.Add (aLeafBoxes[aLeafIter]);
+  }
+  aTimer.Stop();
+  myPrepTime = aTimer.ElapsedTime();
+  if (aSceneBox.IsVoid())
+  {
+    return true;
+  }
+
+  // broad phase - sweep over boxes sorted along the axis of the largest extent
+  aTimer.Reset();
+  aTimer.Start();
+  const gp_XYZ aSceneSize = aSceneBox.CornerMax().XYZ() - aSceneBox.CornerMin().XYZ();
+  const int anAxis = aSceneSize.X() >= aSceneSize.Y() && aSceneSize.X() >= aSceneSize.Z() ? 1 : (aSceneSize.Y() >= aSceneSize.Z() ? 2 : 3);
+  std::vector<int> aSorted;
+  aSorted.reserve (aNbLeaves);
+  for (int aLeafIter = 0; aLeafIter < aNbLeaves; ++aLeafIter)
+  {
+    if (!aLeafBoxes[aLeafIter].IsVoid()) { aSorted.push_back (aLeafIter); }
+  }
+  std::sort (aSorted.begin(), aSorted.end(), [&](int theLeft, int theRight)
+  {
+    return aLeafBoxes[theLeft].CornerMin().Coord (anAxis) < aLeafBoxes[theRight].CornerMin().Coord (anAxis);
+  });
+
+  std::vector<std::pair<int, int>> aCandidates;
+  for (size_t aSortIter = 0; aSortIter < aSorted.size(); ++aSortIter)
+  {
+    const Bnd_Box& aBox = aLeafBoxes[aSorted[aSortIter]];
+    const double aMax = aBox.CornerMax().Coord (anAxis);
+    for (size_t anOtherIter = aSortIter + 1; anOtherIter < aSorted.size(); ++anOtherIter)
+    {
+      const Bnd_Box& anOtherBox = aLeafBoxes[aSorted[anOtherIter]];
+      if (anOtherBox.CornerMin().Coord (anAxis) > aMax)
+      {
+        break;
+      }
+      if (!aBox.IsOut (anOtherBox))
+      {
+        aCandidates.push_back (std::make_pair (std::min (aSorted[aSortIter], aSorted[anOtherIter]),
+                                               std::max (aSorted[aSortIter], aSorted[anOtherIter])));
+      }
+    }
+  }
+  myNbCandidates = aCandidates.size();
+  aTimer.Stop();
+  myBroadTime = aTimer.ElapsedTime();
+
+  // narrow phase - intersection of triangulations of candidate pairs
+  aTimer.Reset();
+  aTimer.Start();
+  std::vector<OcctXCafClashPair> aResults (aCandidates.size());
+  OSD_Parallel::For (0, (int )aCandidates.size(), [&](int theIndex)
+  {
+    OcctXCafClashPair& aPair = aResults[theIndex];
+    aPair.Leaf1 = aCandidates[theIndex].first;
+    aPair.Leaf2 = aCandidates[theIndex].second;
+    aPair.NbFaces1 = 0;
+    aPair.NbFaces2 = 0;
+
+    const Handle(BRepExtrema_TriangleSet)& aTris1 = aProtoTris[aLeafProtos[aPair.Leaf1]];
+    const Handle(BRepExtrema_TriangleSet)& aTris2 = aProtoTris[aLeafProtos[aPair.Leaf2]];
+    if (aTris1->Size() == 0
+     || aTris2->Size() == 0)
+    {
+      return;
+    }
+
+    // triangles of the second leaf are moved into prototype coordinates of the first one
+    const gp_Trsf& aTrsf1 = aLeafTrsfs[aPair.Leaf1];
+    const gp_Trsf aTrsf2To1 = aTrsf1.Inverted() * aLeafTrsfs[aPair.Leaf2];
+    OcctXCafClashTraverse aTraverse (aTris1, aTris2, aTrsf2To1, myTolerance / std::abs (aTrsf1.ScaleFactor()));
+    aTraverse.Perform();
+    aPair.NbFaces1 = aTraverse.OverlapFaces1().Extent();
+    aPair.NbFaces2 = aTraverse.OverlapFaces2().Extent();
+  });
+  for (const OcctXCafClashPair& aPair : aResults)
+  {
+    if (aPair.NbFaces1 != 0 || aPair.NbFaces2 != 0)
+    {
+      myClashes.push_back (aPair);
+    }
+  }
+  aTimer.Stop();
+  myNarrowTime = aTimer.ElapsedTime();
+  return true;
+}
+
+// Save clashing pairs into JSON file.
+bool OcctXCafClash::SaveJson (const TCollection_AsciiString& thePath) const
+{
+  std::ofstream aFile (thePath.ToCString(), std::ios::out | std::ios::trunc);
+  if (!aFile.is_open())
+  {
+    Message::SendFail() << "Error: unable to save clashes into '" << thePath << "'";
+    return false;
+  }
+
+  aFile << "{\n"
+        << "  \"leaves\": " << myLeafIds.size() << ",\n"
+        << "  \"candidates\": " << myNbCandidates << ",\n"
+        << "  \"tolerance\": " << myTolerance << ",\n"
+        << "  \"clashes\": [";
+  for (size_t aPairIter = 0; aPairIter < myClashes.size(); ++aPairIter)
+  {
+    const OcctXCafClashPair& aPair = myClashes[aPairIter];
+    aFile << (aPairIter > 0 ? "," : "") << "\n    { \"node1\": \"" << myLeafIds[aPair.Leaf1].ToCString()
+          << "\", \"node2\": \"" << myLeafIds[aPair.Leaf2].ToCString()
+          << "\", \"faces1\": " << aPair.NbFaces1 << ", \"faces2\": " << aPair.NbFaces2 << " }";
+  }
+  aFile << "\n  ]\n}\n";
+  return aFile.good();
+}
+
+// Print pair counts and timings of each phase.
+void OcctXCafClash::DumpStats() const
+{
+  const double aNbPairs = 0.5 * double(myLeafIds.size()) * double(myLeafIds.size() > 0 ? myLeafIds.size() - 1 : 0);
+  Message::SendInfo() << "Clash detection: " << (int )myLeafIds.size() << " leaves (" << myNbProtos << " unique parts), "
+                      << aNbPairs << " pairs; broad phase " << (double )myNbCandidates << " candidates; narrow phase "
+                      << (int )myClashes.size() << " clashes; prepare " << 1000.0 * myPrepTime << " ms, broad "
+                      << 1000.0 * myBroadTime << " ms, narrow " << 1000.0 * myNarrowTime << " ms";
+}
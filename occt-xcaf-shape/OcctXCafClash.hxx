@@ -0,0 +1,72 @@
+#ifndef _OcctXCafClash_HeaderFile
+#define _OcctXCafClash_HeaderFile
+
+#include <Bnd_Box.hxx>
+#include <TCollection_AsciiString.hxx>
+#include <TDocStd_Document.hxx>
+
+#include <vector>
+
+//! Pair of clashing leaves.
+struct OcctXCafClashPair
+{
+  int Leaf1;    //!< index of the first leaf
+  int Leaf2;    //!< index of the second leaf
+  int NbFaces1; //!< number of faces of the first leaf overlapping the second one
+  int NbFaces2; //!< number of faces of the second leaf overlapping the first one
+};
+
+//! Interference (clash) detection between leaves of XCAF document.
+//! Leaves should be meshed in advance, as narrow phase works on triangulation.
+//!
+//! Broad phase sorts world-space bounding boxes of leaves (prototype box computed once and transformed by node location)
+//! along the axis of the largest scene extent and sweeps over them to collect pairs of overlapping boxes (sweep and prune).
+//! Narrow phase checks candidate pairs in parallel by simultaneous traversal of BVH trees of triangles of both parts.
+//! Triangle set (BRepExtrema_TriangleSet) and its BVH are built once per prototype in its own coordinate system,
+//! and the pair is tested under relative transformation of instances, so that nothing is rebuilt per pair.
+//!
+//! Only surfaces are compared: a part entirely contained within another one (or within its tolerance)
+//! without any overlapping triangles is not reported as clashing.
+class OcctXCafClash
+{
+public:
+
+  //! Empty constructor.
+  OcctXCafClash();
+
+  //! Return proximity tolerance - leaves closer than this distance are considered clashing; 0 by default.
+  //! Zero tolerance reports only penetrating leaves, so that touching ones (coplanar contact, shared edges) are not clashing.
+  double Tolerance() const { return myTolerance; }
+
+  //! Set proximity tolerance.
+  void SetTolerance (double theTolerance) { myTolerance = theTolerance; }
+
+  //! Detect clashes between leaves of document.
+  bool Perform (const Handle(TDocStd_Document)& theDoc);
+
+  //! Return leaf node Ids (XCAFPrs_DocumentNode::Id).
+  const std::vector<TCollection_AsciiString>& LeafIds() const { return myLeafIds; }
+
+  //! Return clashing pairs.
+  const std::vector<OcctXCafClashPair>& Clashes() const { return myClashes; }
+
+  //! Save clashing pairs into JSON file.
+  bool SaveJson (const TCollection_AsciiString& thePath) const;
+
+  //! Print pair counts and timings of each phase.
+  void DumpStats() const;
+
+private:
+
+  std::vector<TCollection_AsciiString> myLeafIds;      //!< leaf node Ids
+  std::vector<OcctXCafClashPair>       myClashes;      //!< clashing pairs
+  double                               myTolerance;    //!< proximity tolerance
+  size_t                               myNbCandidates; //!< number of pairs passed broad phase
+  int                                  myNbProtos;     //!< number of unique prototypes
+  double                               myPrepTime;     //!< leaves collection, bounding boxes and triangle sets time
+  double                               myBroadTime;    //!< broad phase time
+  double                               myNarrowTime;   //!< narrow phase time
+
+};
+
+#endif // _OcctXCafClash_HeaderFile
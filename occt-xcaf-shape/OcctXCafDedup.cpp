@@ -0,0 +1,380 @@
+#include "OcctXCafDedup.hxx"
+
+#include <BRep_Tool.hxx>
+#include <BRepAdaptor_Surface.hxx>
+#include <BRepBndLib.hxx>
+#include <BRepGProp.hxx>
+#include <GProp_GProps.hxx>
+#include <GProp_PrincipalProps.hxx>
+#include <Message.hxx>
+#include <OSD_Parallel.hxx>
+#include <OSD_Timer.hxx>
+#include <Precision.hxx>
+#include <TDataStd_TreeNode.hxx>
+#include <TDF_Tool.hxx>
+#include <TNaming_Builder.hxx>
+#include <TopExp.hxx>
+#include <TopoDS.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+#include <XCAFDoc.hxx>
+#include <XCAFDoc_ColorTool.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+#include <XCAFDoc_Location.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+#include <XCAFDoc_VisMaterialTool.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace
+{
+  //! Part prototype with its fingerprint and principal frame of inertia.
+  struct PartInfo
+  {
+    TDF_Label           Label;       //!< prototype label
+    TopoDS_Shape        Shape;       //!< prototype shape
+    std::string         Key;         //!< fingerprint
+    gp_Pnt              Center;      //!< center of mass
+    gp_Dir              Axes[3];     //!< principal axes sorted by moments
+    bool                IsSymmetric; //!< principal axes are not unique
+    double              Size;        //!< bounding box diagonal
+    std::vector<gp_Pnt> Vertices;    //!< vertices sorted by X coordinate
+
+    PartInfo() : IsSymmetric (false), Size (0.0) {}
+  };
+
+  //! Format value rounded to 6 significant digits.
+  static std::string roundedValue (double theValue)
+  {
+    char aBuffer[32];
+    snprintf (aBuffer, sizeof(aBuffer), " %.5e", std::abs (theValue) < Precision::Confusion() ? 0.0 : theValue);
+    return aBuffer;
+  }
+
+  //! Compute part fingerprint, principal frame and vertices.
+  static void computePartInfo (PartInfo& thePart)
+  {
+    TopTools_IndexedMapOfShape aFaces, anEdges, aVerts;
+    TopExp::MapShapes (thePart.Shape, TopAbs_FACE,   aFaces);
+    TopExp::MapShapes (thePart.Shape, TopAbs_EDGE,   anEdges);
+    TopExp::MapShapes (thePart.Shape, TopAbs_VERTEX, aVerts);
+
+    int aNbSurfTypes[GeomAbs_OtherSurface + 1] = {};
+    for (TopTools_IndexedMapOfShape::Iterator aFaceIter (aFaces); aFaceIter.More(); aFaceIter.Next())
+    {
+      BRepAdaptor_Surface aSurf (TopoDS::Face (aFaceIter.Value()), false);
+      ++aNbSurfTypes[aSurf.GetType()];
+    }
+
+    // surface properties define principal frame for both solids and open shells
+    GProp_GProps aSurfProps, aVolProps;
+    BRepGProp::SurfaceProperties (thePart.Shape, aSurfProps);
+    BRepGProp::VolumeProperties  (thePart.Shape, aVolProps);
+    const GProp_PrincipalProps aPrincProps = aSurfProps.PrincipalProperties();
+    double aMoments[3] = {};
+    aPrincProps.Moments (aMoments[0], aMoments[1], aMoments[2]);
+    const gp_Vec anAxes[3] = { aPrincProps.FirstAxisOfInertia(), aPrincProps.SecondAxisOfInertia(), aPrincProps.ThirdAxisOfInertia() };
+    int anOrder[3] = { 0, 1, 2 };
+    std::sort (anOrder, anOrder + 3, [&](int theLeft, int theRight) { return aMoments[theLeft] < aMoments[theRight]; });
+
+    const double aMomentTol = 1.0e-6 * std::max (std::abs (aMoments[anOrder[2]]), Precision::Confusion());
+    thePart.IsSymmetric = aMoments[anOrder[1]] - aMoments[anOrder[0]] <= aMomentTol
+                       || aMoments[anOrder[2]] - aMoments[anOrder[1]] <= aMomentTol;
+    thePart.Center = aSurfProps.CentreOfMass();
+    for (int anAxisIter = 0; anAxisIter < 3; ++anAxisIter)
+    {
+      if (anAxes[anOrder[anAxisIter]].Magnitude() > gp::Resolution())
+      {
+        thePart.Axes[anAxisIter] = gp_Dir (anAxes[anOrder[anAxisIter]]);
+      }
+    }
+
+    Bnd_Box aBox;
+    BRepBndLib::Add (thePart.Shape, aBox);
+    thePart.Size = !aBox.IsVoid() ? std::sqrt (aBox.SquareExtent()) : 0.0;
+
+    thePart.Vertices.reserve (aVerts.Extent());
+    for (TopTools_IndexedMapOfShape::Iterator aVertIter (aVerts); aVertIter.More(); aVertIter.Next())
+    {
+      thePart.Vertices.push_back (BRep_Tool::Pnt (TopoDS::Vertex (aVertIter.Value())));
+    }
+    std::sort (thePart.Vertices.begin(), thePart.Vertices.end(),
+               [](const gp_Pnt& theLeft, const gp_Pnt& theRight) { return theLeft.X() < theRight.X(); });
+
+    thePart.Key = "F" + std::to_string (aFaces.Extent())
+               + " E" + std::to_string (anEdges.Extent())
+               + " V" + std::to_string (aVerts.Extent()) + " T";
+    for (int aTypeIter = 0; aTypeIter <= GeomAbs_OtherSurface; ++aTypeIter)
+    {
+      thePart.Key += " " + std::to_string (aNbSurfTypes[aTypeIter]);
+    }
+    thePart.Key += " A" + roundedValue (aSurfProps.Mass()) + " V" + roundedValue (aVolProps.Mass())
+                 + " M" + roundedValue (aMoments[anOrder[0]]) + roundedValue (aMoments[anOrder[1]]) + roundedValue (aMoments[anOrder[2]]);
+  }
+
+  //! Return TRUE if all vertices of the first part moved by transformation coincide with vertices of the second part.
+  static bool isSameGeometry (const PartInfo& thePart1,
+                              const PartInfo& thePart2,
+                              const gp_Trsf& theTrsf,
+                              double theTol)
+  {
+    for (const gp_Pnt& aPnt : thePart1.Vertices)
+    {
+      const gp_Pnt aMoved = aPnt.Transformed (theTrsf);
+      std::vector<gp_Pnt>::const_iterator aPntIter = std::lower_bound (thePart2.Vertices.begin(), thePart2.Vertices.end(), aMoved.X() - theTol,
+                                                                       [](const gp_Pnt& theLeft, double theX) { return theLeft.X() < theX; });
+      bool isFound = false;
+      for (; aPntIter != thePart2.Vertices.end() && aPntIter->X() <= aMoved.X() + theTol; ++aPntIter)
+      {
+        if (aPntIter->SquareDistance (aMoved) <= theTol * theTol)
+        {
+          isFound = true;
+          break;
+        }
+      }
+      if (!isFound)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //! Find transformation moving the first part onto the second one.
+  static bool matchParts (const PartInfo& thePart1,
+                          const PartInfo& thePart2,
+                          double theRelTol,
+                          gp_Trsf& theTrsf)
+  {
+    const double aTol = std::max (theRelTol * thePart1.Size, Precision::Confusion());
+    std::vector<gp_Trsf> aCandidates;
+    {
+      gp_Trsf aTranslation;
+      aTranslation.SetTranslation (thePart1.Center, thePart2.Center);
+      aCandidates.push_back (aTranslation);
+    }
+    if (!thePart1.IsSymmetric
+     && !thePart2.IsSymmetric)
+    {
+      try
+      {
+        // principal axes are defined up to direction - try all proper rotations between them
+        gp_Trsf aToFrame1;
+        aToFrame1.SetTransformation (gp_Ax3 (thePart1.Center, thePart1.Axes[2], thePart1.Axes[0]));
+        for (int aSignIter = 0; aSignIter < 4; ++aSignIter)
+        {
+          const gp_Dir aDirZ = (aSignIter & 1) != 0 ? thePart2.Axes[2].Reversed() : thePart2.Axes[2];
+          const gp_Dir aDirX = (aSignIter & 2) != 0 ? thePart2.Axes[0].Reversed() : thePart2.Axes[0];
+          gp_Trsf aToFrame2;
+          aToFrame2.SetTransformation (gp_Ax3 (thePart2.Center, aDirZ, aDirX));
+          aCandidates.push_back (aToFrame2.Inverted() * aToFrame1);
+        }
+      }
+      catch (Standard_Failure const&)
+      {
+        // degenerated frame (parallel axes of zero-mass shape)
+      }
+    }
+
+    for (const gp_Trsf& aTrsf : aCandidates)
+    {
+      if (isSameGeometry (thePart1, thePart2, aTrsf, aTol))
+      {
+        theTrsf = aTrsf;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //! Check that styles of duplicate could be preserved on its instances
+  //! (instance styles override prototype ones, but could not unset them).
+  static bool isStyleCompatible (const TDF_Label& theShared,
+                                 const TDF_Label& theDuplicate)
+  {
+    if (theDuplicate.HasChild())
+    {
+      return false; // sub-shape labels refer to sub-shapes of duplicate
+    }
+
+    const XCAFDoc_ColorType aTypes[3] = { XCAFDoc_ColorGen, XCAFDoc_ColorSurf, XCAFDoc_ColorCurv };
+    for (int aTypeIter = 0; aTypeIter < 3; ++aTypeIter)
+    {
+      Quantity_ColorRGBA aColor;
+      if (XCAFDoc_ColorTool::GetColor (theShared, aTypes[aTypeIter], aColor)
+      && !XCAFDoc_ColorTool::GetColor (theDuplicate, aTypes[aTypeIter], aColor))
+      {
+        return false;
+      }
+    }
+
+    TDF_Label aMat;
+    return !XCAFDoc_VisMaterialTool::GetShapeMaterial (theShared, aMat)
+         || XCAFDoc_VisMaterialTool::GetShapeMaterial (theDuplicate, aMat);
+  }
+
+  //! Copy styles of duplicate prototype to instance which doesn't define own ones.
+  static void copyStyles (const Handle(XCAFDoc_ColorTool)& theColorTool,
+                          const Handle(XCAFDoc_VisMaterialTool)& theMatTool,
+                          const TDF_Label& theDuplicate,
+                          const TDF_Label& theInstance)
+  {
+    const XCAFDoc_ColorType aTypes[3] = { XCAFDoc_ColorGen, XCAFDoc_ColorSurf, XCAFDoc_ColorCurv };
+    for (int aTypeIter = 0; aTypeIter < 3; ++aTypeIter)
+    {
+      Quantity_ColorRGBA aColor, anInstColor;
+      if (XCAFDoc_ColorTool::GetColor (theDuplicate, aTypes[aTypeIter], aColor)
+      && !XCAFDoc_ColorTool::GetColor (theInstance,  aTypes[aTypeIter], anInstColor))
+      {
+        theColorTool->SetColor (theInstance, aColor, aTypes[aTypeIter]);
+      }
+    }
+
+    TDF_Label aMat, anInstMat;
+    if (XCAFDoc_VisMaterialTool::GetShapeMaterial (theDuplicate, aMat)
+    && !XCAFDoc_VisMaterialTool::GetShapeMaterial (theInstance, anInstMat))
+    {
+      theMatTool->SetShapeMaterial (theInstance, aMat);
+    }
+  }
+}
+
+// Empty constructor.
+OcctXCafDedup::OcctXCafDedup()
+: myRelTol (1.0e-6)
+{
+  //
+}
+
+// Fold duplicated part prototypes within document.
+bool OcctXCafDedup::Perform (const Handle(TDocStd_Document)& theDoc)
+{
+  myStats = OcctXCafDedupStats();
+  if (theDoc.IsNull())
+  {
+    return false;
+  }
+
+  OSD_Timer aTimer;
+  aTimer.Start();
+  const Handle(XCAFDoc_ShapeTool)       aShapeTool = XCAFDoc_DocumentTool::ShapeTool (theDoc->Main());
+  const Handle(XCAFDoc_ColorTool)       aColorTool = XCAFDoc_DocumentTool::ColorTool (theDoc->Main());
+  const Handle(XCAFDoc_VisMaterialTool) aMatTool   = XCAFDoc_DocumentTool::VisMaterialTool (theDoc->Main());
+
+  // only parts instanced within assemblies could be re-referenced
+  std::vector<PartInfo> aParts;
+  TDF_LabelSequence aShapeLabels;
+  aShapeTool->GetShapes (aShapeLabels);
+  for (TDF_LabelSequence::Iterator aLabelIter (aShapeLabels); aLabelIter.More(); aLabelIter.Next())
+  {
+    const TDF_Label& aLabel = aLabelIter.Value();
+    TDF_LabelSequence aUsers;
+    if (XCAFDoc_ShapeTool::IsAssembly (aLabel)
+     || XCAFDoc_ShapeTool::GetUsers (aLabel, aUsers) == 0)
+    {
+      continue;
+    }
+
+    PartInfo aPart;
+    aPart.Label = aLabel;
+    aPart.Shape = XCAFDoc_ShapeTool::GetShape (aLabel);
+    if (!aPart.Shape.IsNull()) { aParts.push_back (aPart); }
+  }
+  myStats.NbParts = (int )aParts.size();
+
+  OSD_Parallel::For (0, (int )aParts.size(), [&](int theIndex)
+  {
+    computePartInfo (aParts[theIndex]);
+  });
+
+  std::map<std::string, std::vector<size_t>> aGroups;
+  for (size_t aPartIter = 0; aPartIter < aParts.size(); ++aPartIter)
+  {
+    aGroups[aParts[aPartIter].Key].push_back (aPartIter);
+  }
+
+  for (const std::pair<const std::string, std::vector<size_t>>& aGroup : aGroups)
+  {
+    // the first part of each distinct geometry becomes shared prototype
+    std::vector<size_t> aShared;
+    for (size_t aPartIndex : aGroup.second)
+    {
+      const PartInfo& aDup = aParts[aPartIndex];
+      const PartInfo* aMatched = NULL;
+      gp_Trsf aTrsf;
+      for (size_t aSharedIndex : aShared)
+      {
+        if (matchParts (aParts[aSharedIndex], aDup, myRelTol, aTrsf))
+        {
+          aMatched = &aParts[aSharedIndex];
+          break;
+        }
+      }
+      if (aMatched == NULL)
+      {
+        if (!aShared.empty()) { ++myStats.NbRejected; }
+        aShared.push_back (aPartIndex);
+        continue;
+      }
+      if (!isStyleCompatible (aMatched->Label, aDup.Label))
+      {
+        ++myStats.NbRejected;
+        continue;
+      }
+
+      // duplicate is the shared part moved by aTrsf, so that its instance at L is the shared part at L * aTrsf
+      const TopLoc_Location anAlignLoc (aTrsf);
+      TDF_LabelSequence aUsers;
+      XCAFDoc_ShapeTool::GetUsers (aDup.Label, aUsers);
+      for (TDF_LabelSequence::Iterator aUserIter (aUsers); aUserIter.More(); aUserIter.Next())
+      {
+        const TDF_Label& anInstLabel = aUserIter.Value();
+        const TopLoc_Location aNewLoc = XCAFDoc_ShapeTool::GetLocation (anInstLabel) * anAlignLoc;
+
+        Handle(TDataStd_TreeNode) aRefNode = TDataStd_TreeNode::Set (anInstLabel, XCAFDoc::ShapeRefGUID());
+        aRefNode->Remove();
+        TDataStd_TreeNode::Set (aMatched->Label, XCAFDoc::ShapeRefGUID())->Append (aRefNode);
+        XCAFDoc_Location::Set (anInstLabel, aNewLoc);
+        TNaming_Builder aBuilder (anInstLabel);
+        aBuilder.Generated (aMatched->Shape.Moved (aNewLoc));
+        copyStyles (aColorTool, aMatTool, aDup.Label, anInstLabel);
+        ++myStats.NbInstances;
+      }
+
+      // removal fails if label is still referenced, leaving it as an extra free shape
+      if (aShapeTool->RemoveShape (aDup.Label, false))
+      {
+        ++myStats.NbDuplicates;
+      }
+      else
+      {
+        ++myStats.NbUnremoved;
+        TCollection_AsciiString anEntry;
+        TDF_Tool::Entry (aDup.Label, anEntry);
+        Message::SendWarning() << "Warning: folded prototype " << anEntry << " cannot be removed from document";
+      }
+    }
+  }
+
+  if (myStats.NbDuplicates != 0
+   || myStats.NbUnremoved != 0)
+  {
+    aShapeTool->UpdateAssemblies();
+  }
+  aTimer.Stop();
+  myStats.Time = aTimer.ElapsedTime();
+  return true;
+}
+
+// Print statistics.
+void OcctXCafDedup::DumpStats() const
+{
+  Message::SendInfo() << "Geometry deduplication: " << myStats.NbDuplicates << " of " << myStats.NbParts << " parts folded into "
+                      << (myStats.NbParts - myStats.NbDuplicates) << " prototypes, " << myStats.NbInstances << " instances re-referenced, "
+                      << myStats.NbRejected << " fingerprint matches rejected, "
+                      << myStats.NbUnremoved << " folded parts not removed, in " << myStats.Time << " s";
+}
@@ -0,0 +1,59 @@
+#ifndef _OcctXCafDedup_HeaderFile
+#define _OcctXCafDedup_HeaderFile
+
+#include <TDocStd_Document.hxx>
+
+//! Statistics of geometry deduplication.
+struct OcctXCafDedupStats
+{
+  int    NbParts;      //!< number of analyzed part prototypes
+  int    NbDuplicates; //!< number of prototypes folded into shared ones and removed from document
+  int    NbUnremoved;  //!< number of folded prototypes which could not be removed from document
+  int    NbInstances;  //!< number of instances (components) re-referenced to shared prototypes
+  int    NbRejected;   //!< number of prototypes with matching fingerprint rejected by geometry or style check
+  double Time;         //!< processing time in seconds
+
+  OcctXCafDedupStats() : NbParts (0), NbDuplicates (0), NbUnremoved (0), NbInstances (0), NbRejected (0), Time (0.0) {}
+};
+
+//! Import post-process folding parts with the same geometry defined as unrelated prototypes
+//! (typical for supplier STEP files) into shared prototypes with instance transformations.
+//!
+//! Each part prototype referenced by assembly instances is fingerprinted in parallel by values invariant to rigid motion:
+//! numbers of faces, edges and vertices, histogram of surface types, area, volume and principal moments of inertia.
+//! Prototypes with equal fingerprints are matched by aligning their principal frames of inertia
+//! (or just centers of mass for parts with symmetry axis), and the match is accepted only when
+//! all vertices of one part coincide with vertices of another within tolerance.
+//! Instances of a duplicate are re-referenced to the shared prototype with location composed with alignment transformation,
+//! colors of the duplicate are moved to its instances, and the duplicate is removed from the document.
+//! Duplicates having sub-shape labels or styles which could not be preserved are not folded.
+class OcctXCafDedup
+{
+public:
+
+  //! Empty constructor.
+  OcctXCafDedup();
+
+  //! Return relative tolerance for vertex matching (fraction of part bounding box diagonal); 1e-6 by default.
+  double Tolerance() const { return myRelTol; }
+
+  //! Set relative tolerance for vertex matching.
+  void SetTolerance (double theRelTol) { myRelTol = theRelTol; }
+
+  //! Fold duplicated part prototypes within document.
+  bool Perform (const Handle(TDocStd_Document)& theDoc);
+
+  //! Return statistics of the last Perform().
+  const OcctXCafDedupStats& Stats() const { return myStats; }
+
+  //! Print statistics.
+  void DumpStats() const;
+
+private:
+
+  double             myRelTol; //!< relative tolerance
+  OcctXCafDedupStats myStats;  //!< statistics
+
+};
+
+#endif // _OcctXCafDedup_HeaderFile
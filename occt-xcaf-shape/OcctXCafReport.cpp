@@ -0,0 +1,280 @@
+#include "OcctXCafReport.hxx"
+
+#include <BRepBndLib.hxx>
+#include <BRepGProp.hxx>
+#include <GProp_GProps.hxx>
+#include <Message.hxx>
+#include <NCollection_DataMap.hxx>
+#include <OSD_Parallel.hxx>
+#include <OSD_Timer.hxx>
+#include <TDataStd_Name.hxx>
+#include <TDF_LabelMapHasher.hxx>
+#include <TDF_Tool.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+#include <XCAFPrs_DocumentExplorer.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+  //! Properties of part prototype in its own coordinates.
+  struct ProtoProps
+  {
+    TopoDS_Shape Shape;
+    double       Volume;
+    double       Area;
+    gp_Pnt       VolumeCenter;
+    gp_Pnt       AreaCenter;
+    Bnd_Box      Box;
+
+    ProtoProps() : Volume (0.0), Area (0.0) {}
+  };
+
+  //! Escape string for CSV (quoted) or JSON output.
+  static TCollection_AsciiString escapeString (const TCollection_AsciiString& theStr, bool theIsJson)
+  {
+    TCollection_AsciiString aRes;
+    for (int aCharIter = 1; aCharIter <= theStr.Length(); ++aCharIter)
+    {
+      const char aChar = theStr.Value (aCharIter);
+      if (aChar == '"') { aRes += theIsJson ? "\\\"" : "\"\""; }
+      else if (aChar == '\\' && theIsJson) { aRes += "\\\\"; }
+      else { aRes += aChar; }
+    }
+    return aRes;
+  }
+
+  //! Return box bounds or zeros for void box.
+  static void boxBounds (const Bnd_Box& theBox, double theBounds[6])
+  {
+    if (theBox.IsVoid())
+    {
+      for (int aBoundIter = 0; aBoundIter < 6; ++aBoundIter) { theBounds[aBoundIter] = 0.0; }
+      return;
+    }
+    theBox.Get (theBounds[0], theBounds[1], theBounds[2], theBounds[3], theBounds[4], theBounds[5]);
+  }
+}
+
+// Empty constructor.
+OcctXCafReport::OcctXCafReport()
+: myNbProtos (0), myNbLeaves (0), myExpTime (0.0), myPropsTime (0.0), myRollupTime (0.0)
+{
+  //
+}
+
+// Compute report for document.
+bool OcctXCafReport::Perform (const Handle(TDocStd_Document)& theDoc)
+{
+  myNodes.clear();
+  myNbProtos = 0;
+  myNbLeaves = 0;
+  if (theDoc.IsNull())
+  {
+    return false;
+  }
+
+  // collect nodes and unique prototypes of leaves
+  OSD_Timer aTimer;
+  aTimer.Start();
+  std::vector<ProtoProps> aProtos;
+  std::vector<int> aNodeProtos;
+  std::vector<gp_Trsf> aNodeTrsfs;
+  NCollection_DataMap<TDF_Label, int, TDF_LabelMapHasher> aProtoIndices;
+  std::vector<int> aPath;
+  for (XCAFPrs_DocumentExplorer aDocExp (theDoc, XCAFPrs_DocumentExplorerFlags_None); aDocExp.More(); aDocExp.Next())
+  {
+    const XCAFPrs_DocumentNode& aDocNode = aDocExp.Current();
+    OcctXCafReportNode aNode;
+    aNode.Id = aDocNode.Id;
+    aNode.Depth = aDocExp.CurrentDepth();
+    aNode.IsAssembly = aDocNode.IsAssembly;
+    aNode.Parent = aNode.Depth > 0 ? aPath[aNode.Depth - 1] : -1;
+
+    Handle(TDataStd_Name) aName;
+    if (aDocNode.RefLabel.FindAttribute (TDataStd_Name::GetID(), aName))
+    {
+      aNode.Name = aName->Get();
+    }
+    else
+    {
+      TDF_Tool::Entry (aDocNode.RefLabel, aNode.Name);
+    }
+
+    int aProtoIndex = -1;
+    if (!aDocNode.IsAssembly)
+    {
+      ++myNbLeaves;
+      if (!aProtoIndices.Find (aDocNode.RefLabel, aProtoIndex))
+      {
+        aProtoIndex = (int )aProtos.size();
+        aProtoIndices.Bind (aDocNode.RefLabel, aProtoIndex);
+        aProtos.push_back (ProtoProps());
+        aProtos.back().Shape = XCAFDoc_ShapeTool::GetShape (aDocNode.RefLabel);
+      }
+    }
+
+    aPath.resize (aNode.Depth + 1);
+    aPath[aNode.Depth] = (int )myNodes.size();
+    myNodes.push_back (aNode);
+    aNodeProtos.push_back (aProtoIndex);
+    aNodeTrsfs.push_back (aDocNode.Location);
+  }
+  myNbProtos = (int )aProtos.size();
+  aTimer.Stop();
+  myExpTime = aTimer.ElapsedTime();
+
+  // properties of each prototype are computed once regardless of number of instances
+  aTimer.Reset();
+  aTimer.Start();
+  OSD_Parallel::For (0, (int )aProtos.size(), [&](int theIndex)
+  {
+    ProtoProps& aProto = aProtos[theIndex];
+    if (aProto.Shape.IsNull()) { return; }
+
+    GProp_GProps aVolProps, aSurfProps;
+    BRepGProp::VolumeProperties  (aProto.Shape, aVolProps);
+    BRepGProp::SurfaceProperties (aProto.Shape, aSurfProps);
+    aProto.Volume       = aVolProps.Mass();
+    aProto.VolumeCenter = aVolProps.CentreOfMass();
+    aProto.Area         = aSurfProps.Mass();
+    aProto.AreaCenter   = aSurfProps.CentreOfMass();
+    BRepBndLib::Add (aProto.Shape, aProto.Box);
+  });
+  aTimer.Stop();
+  myPropsTime = aTimer.ElapsedTime();
+
+  // propagate prototype properties to leaves and roll them up into assemblies;
+  // center of mass is weighted by volume, or by area when there are only shells
+  aTimer.Reset();
+  aTimer.Start();
+  std::vector<gp_XYZ> aVolMoments  (myNodes.size(), gp_XYZ (0.0, 0.0, 0.0));
+  std::vector<gp_XYZ> anAreaMoments (myNodes.size(), gp_XYZ (0.0, 0.0, 0.0));
+  for (size_t aNodeIter = 0; aNodeIter < myNodes.size(); ++aNodeIter)
+  {
+    if (aNodeProtos[aNodeIter] < 0) { continue; }
+
+    const ProtoProps& aProto = aProtos[aNodeProtos[aNodeIter]];
+    const gp_Trsf& aTrsf = aNodeTrsfs[aNodeIter];
+    const double aScale = std::abs (aTrsf.ScaleFactor());
+    OcctXCafReportNode& aNode = myNodes[aNodeIter];
+    aNode.Volume = aProto.Volume * aScale * aScale * aScale;
+    aNode.Area   = aProto.Area * aScale * aScale;
+    aVolMoments[aNodeIter]   = aProto.VolumeCenter.Transformed (aTrsf).XYZ() * aNode.Volume;
+    anAreaMoments[aNodeIter] = aProto.AreaCenter.Transformed (aTrsf).XYZ() * aNode.Area;
+    if (!aProto.Box.IsVoid()) { aNode.Box = aProto.Box.Transformed (aTrsf); }
+  }
+
+  // children follow their parents in depth-first order, so that reverse pass accumulates sub-trees
+  for (size_t aNodeIter = myNodes.size(); aNodeIter-- > 0; )
+  {
+    OcctXCafReportNode& aNode = myNodes[aNodeIter];
+    const double aVolTol = 1.0e-12 * std::max (aNode.Area, 1.0);
+    aNode.Center = std::abs (aNode.Volume) > aVolTol
+                 ? gp_Pnt (aVolMoments[aNodeIter] / aNode.Volume)
+                 : (aNode.Area > 0.0 ? gp_Pnt (anAreaMoments[aNodeIter] / aNode.Area) : gp_Pnt());
+    if (aNode.Parent < 0) { continue; }
+
+    OcctXCafReportNode& aParent = myNodes[aNode.Parent];
+    aParent.Volume += aNode.Volume;
+    aParent.Area   += aNode.Area;
+    aParent.Box.Add (aNode.Box);
+    aVolMoments[aNode.Parent]   += aVolMoments[aNodeIter];
+    anAreaMoments[aNode.Parent] += anAreaMoments[aNodeIter];
+  }
+  aTimer.Stop();
+  myRollupTime = aTimer.ElapsedTime();
+  return true;
+}
+
+// Save report into CSV or JSON file.
+bool OcctXCafReport::Save (const TCollection_AsciiString& thePath) const
+{
+  TCollection_AsciiString aPathLower = thePath;
+  aPathLower.LowerCase();
+  const bool isJson = aPathLower.Length() > 5
+                   && aPathLower.SubString (aPathLower.Length() - 4, aPathLower.Length()) == ".json";
+  const bool isSaved = isJson ? saveJson (thePath) : saveCsv (thePath);
+  if (!isSaved)
+  {
+    Message::SendFail() << "Error: unable to save report into '" << thePath << "'";
+  }
+  return isSaved;
+}
+
+// Save report into CSV file.
+bool OcctXCafReport::saveCsv (const TCollection_AsciiString& thePath) const
+{
+  std::ofstream aFile (thePath.ToCString(), std::ios::out | std::ios::trunc);
+  if (!aFile.is_open())
+  {
+    return false;
+  }
+
+  aFile.precision (10);
+  aFile << "id,name,depth,type,volume,area,cx,cy,cz,xmin,ymin,zmin,xmax,ymax,zmax\n";
+  for (const OcctXCafReportNode& aNode : myNodes)
+  {
+    double aBounds[6];
+    boxBounds (aNode.Box, aBounds);
+    aFile << "\"" << escapeString (aNode.Id, false).ToCString() << "\",\"" << escapeString (aNode.Name, false).ToCString() << "\","
+          << aNode.Depth << "," << (aNode.IsAssembly ? "assembly" : "part") << ","
+          << aNode.Volume << "," << aNode.Area << ","
+          << aNode.Center.X() << "," << aNode.Center.Y() << "," << aNode.Center.Z();
+    for (int aBoundIter = 0; aBoundIter < 6; ++aBoundIter)
+    {
+      aFile << "," << aBounds[aBoundIter];
+    }
+    aFile << "\n";
+  }
+  return aFile.good();
+}
+
+// Save report into JSON file.
+bool OcctXCafReport::saveJson (const TCollection_AsciiString& thePath) const
+{
+  std::ofstream aFile (thePath.ToCString(), std::ios::out | std::ios::trunc);
+  if (!aFile.is_open())
+  {
+    return false;
+  }
+
+  aFile.precision (10);
+  aFile << "[";
+  for (size_t aNodeIter = 0; aNodeIter < myNodes.size(); ++aNodeIter)
+  {
+    const OcctXCafReportNode& aNode = myNodes[aNodeIter];
+    double aBounds[6];
+    boxBounds (aNode.Box, aBounds);
+    aFile << (aNodeIter > 0 ? "," : "") << "\n  { \"id\": \"" << escapeString (aNode.Id, true).ToCString()
+          << "\", \"name\": \"" << escapeString (aNode.Name, true).ToCString()
+          << "\", \"depth\": " << aNode.Depth << ", \"parent\": " << aNode.Parent
+          << ", \"type\": \"" << (aNode.IsAssembly ? "assembly" : "part")
+          << "\", \"volume\": " << aNode.Volume << ", \"area\": " << aNode.Area
+          << ", \"center\": [" << aNode.Center.X() << ", " << aNode.Center.Y() << ", " << aNode.Center.Z()
+          << "], \"box\": [" << aBounds[0] << ", " << aBounds[1] << ", " << aBounds[2]
+          << ", " << aBounds[3] << ", " << aBounds[4] << ", " << aBounds[5] << "] }";
+  }
+  aFile << "\n]\n";
+  return aFile.good();
+}
+
+// Print statistics and timings.
+void OcctXCafReport::DumpStats() const
+{
+  double aVolume = 0.0, anArea = 0.0;
+  for (const OcctXCafReportNode& aNode : myNodes)
+  {
+    if (aNode.Parent < 0)
+    {
+      aVolume += aNode.Volume;
+      anArea  += aNode.Area;
+    }
+  }
+  Message::SendInfo() << "Mass properties of " << (int )myNodes.size() << " nodes (" << myNbLeaves << " leaves, "
+                      << myNbProtos << " unique parts): total volume " << aVolume << ", area " << anArea
+                      << "; explore " << 1000.0 * myExpTime << " ms, properties " << 1000.0 * myPropsTime
+                      << " ms, roll-up " << 1000.0 * myRollupTime << " ms";
+}
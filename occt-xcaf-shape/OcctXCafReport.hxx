@@ -0,0 +1,71 @@
+#ifndef _OcctXCafReport_HeaderFile
+#define _OcctXCafReport_HeaderFile
+
+#include <Bnd_Box.hxx>
+#include <gp_Pnt.hxx>
+#include <TCollection_AsciiString.hxx>
+#include <TDocStd_Document.hxx>
+
+#include <vector>
+
+//! Mass properties and bounding box of document node in world coordinates.
+struct OcctXCafReportNode
+{
+  TCollection_AsciiString Id;          //!< node Id (XCAFPrs_DocumentNode::Id)
+  TCollection_AsciiString Name;        //!< product name or label entry
+  int                     Depth;       //!< depth within assembly tree
+  int                     Parent;      //!< index of parent node or -1 for roots
+  bool                    IsAssembly;  //!< assembly node with rolled-up properties of children
+  double                  Volume;      //!< volume
+  double                  Area;        //!< surface area
+  gp_Pnt                  Center;      //!< center of mass (of volume, or of area for shells)
+  Bnd_Box                 Box;         //!< axis-aligned bounding box
+
+  OcctXCafReportNode() : Depth (0), Parent (-1), IsAssembly (false), Volume (0.0), Area (0.0) {}
+};
+
+//! Report of volume, area, center of mass and bounding box of every node of XCAF document.
+//! Properties are computed once per unique part prototype in parallel (with BRepGProp and BRepBndLib),
+//! propagated to leaves through their locations and rolled up into assembly totals.
+class OcctXCafReport
+{
+public:
+
+  //! Empty constructor.
+  OcctXCafReport();
+
+  //! Compute report for document.
+  bool Perform (const Handle(TDocStd_Document)& theDoc);
+
+  //! Return nodes in depth-first order (parents precede children).
+  const std::vector<OcctXCafReportNode>& Nodes() const { return myNodes; }
+
+  //! Return number of unique part prototypes.
+  int NbPrototypes() const { return myNbProtos; }
+
+  //! Save report into CSV or JSON file depending on file extension.
+  bool Save (const TCollection_AsciiString& thePath) const;
+
+  //! Print statistics and timings.
+  void DumpStats() const;
+
+private:
+
+  //! Save report into CSV file.
+  bool saveCsv (const TCollection_AsciiString& thePath) const;
+
+  //! Save report into JSON file.
+  bool saveJson (const TCollection_AsciiString& thePath) const;
+
+private:
+
+  std::vector<OcctXCafReportNode> myNodes;      //!< report nodes
+  int                             myNbProtos;   //!< number of unique prototypes
+  int                             myNbLeaves;   //!< number of leaves
+  double                          myExpTime;    //!< document exploration time
+  double                          myPropsTime;  //!< properties computation time
+  double                          myRollupTime; //!< propagation and roll-up time
+
+};
+
+#endif // _OcctXCafReport_HeaderFile
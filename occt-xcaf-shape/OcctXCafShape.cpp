@@ -4,10 +4,14 @@
 
 #include <AIS_InteractiveContext.hxx>
 #include <AIS_ViewController.hxx>
+#include <BRepMesh_IncrementalMesh.hxx>
 #include <BRepPrimAPI_MakeBox.hxx>
+#include <OpenGl_Context.hxx>
 #include <OpenGl_GraphicDriver.hxx>
 #include <OSD.hxx>
 #include <OSD_Environment.hxx>
+#include <OSD_Parallel.hxx>
+#include <StdPrs_ToolTriangulatedShape.hxx>
 #include <V3d_View.hxx>
 #include <V3d_Viewer.hxx>
 
@@ -24,21 +28,417 @@
 #include <STEPCAFControl_Controller.hxx>
 #include <STEPCAFControl_Reader.hxx>
 #include <TDataStd_Name.hxx>
+#include <TDataStd_RealArray.hxx>
+#include <TDF_AttributeDelta.hxx>
+#include <TDF_ChildIterator.hxx>
+#include <TDF_Delta.hxx>
+#include <TDF_DeltaOnAddition.hxx>
+#include <TDF_DeltaOnRemoval.hxx>
+#include <TDF_LabelMap.hxx>
 #include <TDF_Tool.hxx>
+#include <TNaming_Builder.hxx>
+#include <TNaming_NamedShape.hxx>
 #include <TDocStd_Application.hxx>
+#include <BinDrivers_DocumentStorageDriver.hxx>
 #include <BinXCAFDrivers.hxx>
+#include <PCDM_ReaderFilter.hxx>
 
 #include <XCAFPrs.hxx>
 #include <XCAFPrs_AISObject.hxx>
 #include <XCAFPrs_DocumentExplorer.hxx>
 #include <XCAFPrs_DocumentIdIterator.hxx>
+#include <XCAFDoc_ColorTool.hxx>
+#include <XCAFDoc_DocumentTool.hxx>
+#include <XCAFDoc_Location.hxx>
+#include <XCAFDoc_ShapeTool.hxx>
+
+#include <AIS_Animation.hxx>
+#include <BRep_Tool.hxx>
+#include <BRepBndLib.hxx>
+#include <Graphic3d_ArrayOfTriangles.hxx>
+#include <Graphic3d_ClipPlane.hxx>
+#include <Image_AlienPixMap.hxx>
+#include <NCollection_DataMap.hxx>
+#include <NCollection_Map.hxx>
+#include <OSD_Timer.hxx>
+#include <Poly_Triangulation.hxx>
+#include <Prs3d_Drawer.hxx>
+#include <TopExp.hxx>
+#include <TopoDS.hxx>
+#include <TopTools_IndexedMapOfShape.hxx>
+
+#include "OcctTrace.hxx"
+#include "OcctTransformStream.hxx"
+#include "OcctXCafClash.hxx"
+#include "OcctXCafDedup.hxx"
+#include "OcctXCafReport.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+//! XCAFPrs_AISObject subclass putting presentation and selection computations into trace.
+class MyXCafPrsObject : public XCAFPrs_AISObject
+{
+  DEFINE_STANDARD_RTTI_INLINE(MyXCafPrsObject, XCAFPrs_AISObject)
+public:
+  //! Main constructor.
+  MyXCafPrsObject (const TDF_Label& theLabel) : XCAFPrs_AISObject (theLabel) {}
+
+protected:
+  //! Compute presentation.
+  virtual void Compute (const Handle(PrsMgr_PresentationManager)& thePrsMgr,
+                        const Handle(Prs3d_Presentation)& thePrs,
+                        const Standard_Integer theMode) override
+  {
+    OcctTraceScope aTrace ("ComputePresentation");
+    if (aTrace.IsActive()) { aTrace.SetDetails (traceDetails()); }
+    XCAFPrs_AISObject::Compute (thePrsMgr, thePrs, theMode);
+  }
+
+  //! Compute selection.
+  virtual void ComputeSelection (const Handle(SelectMgr_Selection)& theSel,
+                                 const Standard_Integer theMode) override
+  {
+    OcctTraceScope aTrace ("ComputeSelection");
+    if (aTrace.IsActive()) { aTrace.SetDetails (traceDetails()); }
+    XCAFPrs_AISObject::ComputeSelection (theSel, theMode);
+  }
+
+private:
+  //! Return node Id stored as owner for trace details.
+  TCollection_AsciiString traceDetails() const
+  {
+    Handle(TCollection_HAsciiString) anId = Handle(TCollection_HAsciiString)::DownCast (GetOwner());
+    return !anId.IsNull() ? anId->String() : TCollection_AsciiString();
+  }
+};
+
+//! Merged presentation of part bounding boxes drawn as a single shaded primitive array,
+//! displayed as a cheap proxy of detailed parts during camera navigation.
+class MyBoxProxyPrs : public AIS_InteractiveObject
+{
+  DEFINE_STANDARD_RTTI_INLINE(MyBoxProxyPrs, AIS_InteractiveObject)
+public:
+  //! Empty constructor.
+  MyBoxProxyPrs() { SetDisplayMode (AIS_Shaded); }
+
+  //! Return number of boxes.
+  int NbBoxes() const { return (int )myBoxes.size(); }
+
+  //! Append box in world coordinates.
+  void AddBox (const Bnd_Box& theBox,
+               const Quantity_Color& theColor)
+  {
+    if (!theBox.IsVoid()) { myBoxes.push_back (std::make_pair (theBox, theColor)); }
+  }
+
+  //! Accept only shaded mode.
+  virtual bool AcceptDisplayMode (const Standard_Integer theMode) const override { return theMode == AIS_Shaded; }
+
+protected:
+  //! Compute presentation.
+  virtual void Compute (const Handle(PrsMgr_PresentationManager)& ,
+                        const Handle(Prs3d_Presentation)& thePrs,
+                        const Standard_Integer theMode) override
+  {
+    if (theMode != AIS_Shaded || myBoxes.empty()) { return; }
+
+    // corners are indexed by bits of (x, y, z) and faces are listed counterclockwise around outer normal
+    static const int THE_FACES[6][4] = { { 0, 4, 6, 2 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, { 0, 2, 3, 1 }, { 4, 5, 7, 6 } };
+    static const gp_Dir THE_NORMALS[6] = { -gp::DX(), gp::DX(), -gp::DY(), gp::DY(), -gp::DZ(), gp::DZ() };
+    const int aNbBoxes = (int )myBoxes.size();
+    Handle(Graphic3d_ArrayOfTriangles) aTris = new Graphic3d_ArrayOfTriangles (aNbBoxes * 24, aNbBoxes * 36,
+                                                                              Graphic3d_ArrayFlags_VertexNormal
+                                                                            | Graphic3d_ArrayFlags_VertexColor);
+    for (const std::pair<Bnd_Box, Quantity_Color>& aBox : myBoxes)
+    {
+      const gp_Pnt aMin = aBox.first.CornerMin(), aMax = aBox.first.CornerMax();
+      for (int aFaceIter = 0; aFaceIter < 6; ++aFaceIter)
+      {
+        const int aFirstVert = aTris->VertexNumber() + 1;
+        for (int aCornerIter = 0; aCornerIter < 4; ++aCornerIter)
+        {
+          const int aCorner = THE_FACES[aFaceIter][aCornerIter];
+          const gp_Pnt aPnt ((aCorner & 1) != 0 ? aMax.X() : aMin.X(),
+                             (aCorner & 2) != 0 ? aMax.Y() : aMin.Y(),
+                             (aCorner & 4) != 0 ? aMax.Z() : aMin.Z());
+          const int aVertIndex = aTris->AddVertex (aPnt, THE_NORMALS[aFaceIter]);
+          aTris->SetVertexColor (aVertIndex, aBox.second);
+        }
+        aTris->AddEdges (aFirstVert, aFirstVert + 1, aFirstVert + 2);
+        aTris->AddEdges (aFirstVert, aFirstVert + 2, aFirstVert + 3);
+      }
+    }
+
+    Handle(Graphic3d_Group) aGroup = thePrs->NewGroup();
+    aGroup->SetClosed (true);
+    aGroup->SetGroupPrimitivesAspect (myDrawer->ShadingAspect()->Aspect());
+    aGroup->AddPrimitiveArray (aTris);
+  }
+
+  //! Proxy is not selectable.
+  virtual void ComputeSelection (const Handle(SelectMgr_Selection)& ,
+                                 const Standard_Integer ) override {}
+
+private:
+  std::vector<std::pair<Bnd_Box, Quantity_Color>> myBoxes; //!< boxes with colors
+};
+
+//! Map of displayed presentations by XCAF node Id.
+typedef NCollection_DataMap<TCollection_AsciiString, Handle(XCAFPrs_AISObject)> MyNodePrsMap;
+
+//! Map of document labels to Ids of displayed nodes depending on them (as instance, prototype or parent assembly).
+typedef NCollection_DataMap<TDF_Label, NCollection_List<TCollection_AsciiString>, TDF_LabelMapHasher> MyLabelNodesMap;
+
+//! Statistics of presentations synchronization with document changes.
+struct MySyncStats
+{
+  int    NbRelocated; //!< number of presentations with updated location
+  int    NbRestyled;  //!< number of recomputed presentations
+  int    NbAdded;     //!< number of displayed new nodes
+  int    NbRemoved;   //!< number of erased removed nodes
+  double Time;        //!< synchronization time in seconds
+
+  MySyncStats() : NbRelocated (0), NbRestyled (0), NbAdded (0), NbRemoved (0), Time (0.0) {}
+};
+
+//! Save float image into PFM (portable float map) file.
+//! @param[in] thePath    file path
+//! @param[in] theSizeX   image width
+//! @param[in] theSizeY   image height
+//! @param[in] theNbComps number of components - 1 or 3
+//! @param[in] theData    pixels in top-down row order
+static bool savePfm (const TCollection_AsciiString& thePath,
+                     int theSizeX, int theSizeY, int theNbComps,
+                     const float* theData)
+{
+  std::ofstream aFile (thePath.ToCString(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!aFile.is_open())
+  {
+    return false;
+  }
+
+  // negative scale means little-endian; rows are stored bottom-up
+  aFile << (theNbComps == 3 ? "PF" : "Pf") << "\n" << theSizeX << " " << theSizeY << "\n-1.0\n";
+  const size_t aRowSize = size_t(theSizeX) * theNbComps;
+  for (int aRow = theSizeY - 1; aRow >= 0; --aRow)
+  {
+    aFile.write ((const char* )(theData + aRowSize * aRow), aRowSize * sizeof(float));
+  }
+  return aFile.good();
+}
+
+//! Escape string for JSON output.
+static TCollection_AsciiString jsonEscape (const TCollection_AsciiString& theStr)
+{
+  TCollection_AsciiString aRes;
+  for (int aCharIter = 1; aCharIter <= theStr.Length(); ++aCharIter)
+  {
+    const char aChar = theStr.Value (aCharIter);
+    if (aChar == '"' || aChar == '\\')
+    {
+      aRes += '\\';
+    }
+    aRes += aChar;
+  }
+  return aRes;
+}
+
+//! Kinematic playback of recorded transform stream driving local transformations of XCAF node presentations.
+//! Transformations are interpolated into a preallocated buffer and applied to objects in bulk,
+//! so that sample code makes no memory allocations per frame.
+//! Selection is synchronized with new locations when playback reaches the end.
+class MyPlaybackAnimation : public AIS_Animation
+{
+  DEFINE_STANDARD_RTTI_INLINE(MyPlaybackAnimation, AIS_Animation)
+public:
+  //! Main constructor.
+  MyPlaybackAnimation (const Handle(AIS_InteractiveContext)& theCtx)
+  : AIS_Animation ("MyPlayback"), myContext (theCtx), myNbResolved (0) {}
+
+  //! Return transform stream.
+  const OcctTransformStream& Stream() const { return myStream; }
+
+  //! Return number of stream nodes resolved to presentations.
+  int NbResolvedNodes() const { return myNbResolved; }
+
+  //! Map transform stream and resolve its nodes to displayed presentations.
+  bool Load (const TCollection_AsciiString& thePath,
+             const MyNodePrsMap& theNodes)
+  {
+    if (!myStream.Open (thePath))
+    {
+      return false;
+    }
+
+    Resolve (theNodes);
+    SetOwnDuration (myStream.TimeTo() - myStream.TimeFrom());
+    return true;
+  }
+
+  //! Resolve stream nodes to displayed presentations; should be called again when presentations are recreated.
+  void Resolve (const MyNodePrsMap& theNodes)
+  {
+    myNodePrs.assign (myStream.NbNodes(), Handle(XCAFPrs_AISObject)());
+    myTrsfs.assign (myStream.NbNodes(), gp_Trsf());
+    myNbResolved = 0;
+    for (int aNodeIter = 0; aNodeIter < myStream.NbNodes(); ++aNodeIter)
+    {
+      if (theNodes.Find (myStream.NodeId (aNodeIter), myNodePrs[aNodeIter]))
+      {
+        myTrsfs[aNodeIter] = myNodePrs[aNodeIter]->LocalTransformation();
+        ++myNbResolved;
+      }
+    }
+  }
+
+  //! Evaluate stream at specified local time and apply transformations.
+  void ApplyTime (double theTime)
+  {
+    myStream.Evaluate (myStream.TimeFrom() + theTime, myTrsfs.data());
+    for (size_t aNodeIter = 0; aNodeIter < myNodePrs.size(); ++aNodeIter)
+    {
+      if (!myNodePrs[aNodeIter].IsNull())
+      {
+        myNodePrs[aNodeIter]->SetLocalTransformation (myTrsfs[aNodeIter]);
+      }
+    }
+    myContext->CurrentViewer()->Invalidate();
+  }
+
+protected:
+  //! Update presentations.
+  virtual void update (const AIS_AnimationProgress& theProgress) override
+  {
+    ApplyTime (theProgress.LocalPts);
+    if (theProgress.LocalNormalized >= 1.0)
+    {
+      for (const Handle(XCAFPrs_AISObject)& aPrs : myNodePrs)
+      {
+        if (!aPrs.IsNull()) { myContext->SelectionManager()->Update (aPrs, false); }
+      }
+    }
+  }
+
+private:
+  Handle(AIS_InteractiveContext)         myContext;
+  OcctTransformStream                    myStream;
+  std::vector<Handle(XCAFPrs_AISObject)> myNodePrs;     //!< presentations of stream nodes
+  std::vector<gp_Trsf>                   myTrsfs;       //!< preallocated buffer of evaluated transformations
+  int                                    myNbResolved;  //!< number of stream nodes with presentations
+};
+
+//! Leaf node of partially loaded document.
+struct MyLazyNode
+{
+  XCAFPrs_DocumentNode Node; //!< document node
+  Bnd_Box              Box;  //!< bounding box of node in world coordinates (void if unknown)
+};
+
+//! Part prototype of partially loaded document.
+struct MyLazyPart
+{
+  TCollection_AsciiString Entry;       //!< prototype label entry
+  std::vector<size_t>     Nodes;       //!< indexes of nodes instancing this part
+  size_t                  Memory;      //!< estimated memory of loaded shape
+  int                     LastVisible; //!< last update when part was visible
+  bool                    IsLoaded;    //!< shape is loaded
+
+  MyLazyPart() : Memory (0), LastVisible (0), IsLoaded (false) {}
+};
+
+//! Position of displayed part relative to section plane.
+enum MySectionSide
+{
+  MySectionSide_Kept,    //!< part is entirely on the kept side and drawn without clipping
+  MySectionSide_Cut,     //!< part is intersected by the plane and drawn clipped with capping
+  MySectionSide_Clipped, //!< part is entirely clipped and hidden from the view
+};
+
+//! Displayed part of section view.
+struct MySectionPart
+{
+  Handle(XCAFPrs_AISObject) Prs;  //!< part presentation
+  Bnd_Box                   Box;  //!< bounding box of presentation in world coordinates
+  MySectionSide             Side; //!< current position relative to section plane
+};
+
+//! Return GUID of array attribute storing part bounding box (Xmin, Ymin, Zmin, Xmax, Ymax, Zmax) for partial loading.
+static const Standard_GUID& lazyBoxGuid()
+{
+  static const Standard_GUID THE_GUID ("8b3b6a52-6c1e-4f6d-9a0e-5d2c7b1f4e93");
+  return THE_GUID;
+}
+
+//! Estimate memory used by shape topology, geometry and triangulation.
+static size_t estimateShapeMemory (const TopoDS_Shape& theShape)
+{
+  // rough per-item sizes of topology, geometry and triangulation arrays
+  TopTools_IndexedMapOfShape aSubShapes;
+  TopExp::MapShapes (theShape, aSubShapes);
+  size_t aMemory = aSubShapes.Extent() * 256;
+  for (TopTools_IndexedMapOfShape::Iterator aShapeIter (aSubShapes); aShapeIter.More(); aShapeIter.Next())
+  {
+    if (aShapeIter.Value().ShapeType() != TopAbs_FACE) { continue; }
+
+    TopLoc_Location aLoc;
+    const Handle(Poly_Triangulation)& aTris = BRep_Tool::Triangulation (TopoDS::Face (aShapeIter.Value()), aLoc);
+    if (!aTris.IsNull())
+    {
+      aMemory += aTris->NbNodes() * (sizeof(gp_Pnt) + 3 * sizeof(float)) + aTris->NbTriangles() * 3 * sizeof(int);
+    }
+  }
+  return aMemory;
+}
+
+//! Closed document with its erased presentations to be released.
+struct MyDocumentTeardown
+{
+  Handle(TDocStd_Document) Document;      //!< closed document
+  MyNodePrsMap             Presentations; //!< presentations removed from context
+  MyLabelNodesMap          LabelNodes;    //!< label index
+
+  //! Release presentations and document data.
+  void Release()
+  {
+    OcctTraceScope aTrace ("ReleaseDocument");
+    OSD_Timer aTimer;
+    aTimer.Start();
+    // presentations refer to document labels, so that they are released first
+    Presentations.Clear();
+    LabelNodes.Clear();
+    Document->Main().Root().ForgetAllAttributes (true);
+    Document.Nullify();
+    aTimer.Stop();
+    Message::SendInfo() << "Document data released in " << aTimer.ElapsedTime() << " s";
+  }
+};
 
 //! Sample single-window viewer class.
 class MyViewer : public AIS_ViewController
 {
 public:
   //! Main constructor.
-  MyViewer()
+  //! @param[in] theIsOffscreen create virtual (hidden) window for offscreen rendering
+  MyViewer (bool theIsOffscreen = false)
+  : myIsExploded (true),
+    myToCloseAsync (true),
+    myLazyBudget (size_t(1024) * 1024 * 1024),
+    myLazyMemory (0),
+    myLazyFrame (0),
+    myIsLazy (false),
+    mySectionStep (0.0),
+    myNavFrameBudget (0.0),
+    myNavFrameTime (0.0),
+    myProxyFramesTime (0.0),
+    myNbProxyFrames (0),
+    myNbProxyParts (0),
+    myIsProxyShown (false)
   {
     // graphic driver setup
     Handle(Aspect_DisplayConnection) aDisplay = new Aspect_DisplayConnection();
@@ -78,22 +478,69 @@ public:
     // interactive context and demo scene
     myContext = new AIS_InteractiveContext (aViewer);
 
-    aWindow->Map();
+    if (theIsOffscreen)
+    {
+      aWindow->SetVirtual (true);
+    }
+    else
+    {
+      aWindow->Map();
+    }
     myView->Redraw();
   }
 
+  //! Destructor.
+  virtual ~MyViewer()
+  {
+    waitTeardown();
+  }
+
   //! Return context.
   const Handle(AIS_InteractiveContext)& Context() const { return myContext; }
 
+  //! Set if previous document should be released in background on opening the next one; TRUE by default.
+  void SetAsyncClose (bool theToCloseAsync) { myToCloseAsync = theToCloseAsync; }
+
   //! Return view.
   const Handle(V3d_View)& View() const { return myView; }
 
 public:
 
   //! Save XBF file.
-  bool SaveXBF (const TCollection_AsciiString& theFilePath)
+  //! @param[in] theFilePath     output file path
+  //! @param[in] theToPrepareLazy store part bounding boxes and write shapes in quick part access mode
+  //!                            (within attributes instead of a common shape section) for partial loading
+  bool SaveXBF (const TCollection_AsciiString& theFilePath,
+                bool theToPrepareLazy = false)
   {
     if (myXdeDoc.IsNull()) { return false; }
+    if (theToPrepareLazy)
+    {
+      OcctTraceScope aTrace ("StorePartBoxes");
+      TDF_LabelMap aProtoMap;
+      for (XCAFPrs_DocumentExplorer aDocExp (myXdeDoc, XCAFPrs_DocumentExplorerFlags_None); aDocExp.More(); aDocExp.Next())
+      {
+        const XCAFPrs_DocumentNode& aNode = aDocExp.Current();
+        if (aNode.IsAssembly || !aProtoMap.Add (aNode.RefLabel)) { continue; }
+
+        Bnd_Box aBox;
+        BRepBndLib::Add (XCAFDoc_ShapeTool::GetShape (aNode.RefLabel), aBox);
+        if (aBox.IsVoid()) { continue; }
+
+        Handle(TDataStd_RealArray) aBoxAttr = TDataStd_RealArray::Set (aNode.RefLabel, lazyBoxGuid(), 1, 6);
+        double aBounds[6];
+        aBox.Get (aBounds[0], aBounds[1], aBounds[2], aBounds[3], aBounds[4], aBounds[5]);
+        for (int aBoundIter = 0; aBoundIter < 6; ++aBoundIter)
+        {
+          aBoxAttr->SetValue (aBoundIter + 1, aBounds[aBoundIter]);
+        }
+      }
+
+      Handle(BinDrivers_DocumentStorageDriver) aDriver =
+        Handle(BinDrivers_DocumentStorageDriver)::DownCast (myXdeApp->WriterFromFormat ("BinXCAF"));
+      if (!aDriver.IsNull()) { aDriver->EnableQuickPartWriting (myXdeApp->MessageDriver(), true); }
+    }
+
     const PCDM_StoreStatus aStatus = myXdeApp->SaveAs (myXdeDoc, TCollection_ExtendedString (theFilePath));
     if (aStatus != PCDM_SS_OK)
     {
@@ -104,21 +551,158 @@ public:
   }
 
   //! Open XBF file.
-  bool OpenXBF (const TCollection_AsciiString& theFilePath)
+  //! @param[in] theFilePath    file path
+  //! @param[in] theToLoadLazy  read only document structure without shapes,
+  //!                           which will be loaded on demand for visible parts by UpdateLazyParts()
+  bool OpenXBF (const TCollection_AsciiString& theFilePath,
+                bool theToLoadLazy = false)
   {
     // create an empty XCAF document
     createXCAFApp();
     newDocument();
 
-    const PCDM_ReaderStatus aReaderStatus = myXdeApp->Open (theFilePath, myXdeDoc);
+    OcctTraceScope aTrace ("OpenXBF");
+    OSD_Timer aTimer;
+    aTimer.Start();
+    Handle(PCDM_ReaderFilter) aFilter;
+    if (theToLoadLazy)
+    {
+      aFilter = new PCDM_ReaderFilter (STANDARD_TYPE(TNaming_NamedShape));
+    }
+    const PCDM_ReaderStatus aReaderStatus = myXdeApp->Open (theFilePath, myXdeDoc, aFilter);
     if (aReaderStatus != PCDM_RS_OK)
     {
       Message::SendFail() << "Error occurred during XBF import: " << (int )aReaderStatus << ".\n" << theFilePath;
       return false;
     }
+
+    myIsLazy = theToLoadLazy;
+    myXbfPath = theFilePath;
+    if (theToLoadLazy)
+    {
+      Message::SendInfo() << "Structure of '" << theFilePath << "' opened in " << aTimer.ElapsedTime() << " s (shapes are loaded on demand)";
+    }
     return true;
   }
 
+  //! Set memory budget for shapes of partially loaded document.
+  void SetLazyBudget (size_t theBudget) { myLazyBudget = theBudget; }
+
+  //! Load shapes of parts with nodes within view frustum, display these nodes,
+  //! and unload invisible parts in least recently visible order while memory exceeds budget.
+  //! Shapes are appended to the document by a single partial read of the file with sub-tree paths of requested parts.
+  //! Called on camera changes for partially loaded document.
+  void UpdateLazyParts()
+  {
+    if (!myIsLazy) { return; }
+
+    OcctTraceScope aTrace ("UpdateLazyParts");
+    OSD_Timer aTimer;
+    aTimer.Start();
+    const Handle(Graphic3d_Camera)& aCam = myView->Camera();
+    myLazyCamState = aCam->WorldViewProjState();
+    const Graphic3d_Mat4d aViewProj = aCam->ProjectionMatrix() * aCam->OrientationMatrix();
+    ++myLazyFrame;
+
+    std::vector<size_t> aVisNodes;
+    TDF_LabelMap aToLoad;
+    Handle(PCDM_ReaderFilter) aFilter;
+    for (size_t aNodeIter = 0; aNodeIter < myLazyNodes.size(); ++aNodeIter)
+    {
+      const MyLazyNode& aNode = myLazyNodes[aNodeIter];
+      if (!aNode.Box.IsVoid() && !isInFrustum (aViewProj, aNode.Box)) { continue; }
+
+      aVisNodes.push_back (aNodeIter);
+      MyLazyPart& aPart = myLazyParts.ChangeFind (aNode.Node.RefLabel);
+      aPart.LastVisible = myLazyFrame;
+      if (!aPart.IsLoaded && aToLoad.Add (aNode.Node.RefLabel))
+      {
+        if (aFilter.IsNull()) { aFilter = new PCDM_ReaderFilter (PCDM_ReaderFilter::AppendMode_Protect); }
+        aFilter->AddPath (aPart.Entry);
+      }
+    }
+
+    int aNbLoaded = 0, aNbUnloaded = 0, aNbDisplayed = 0;
+    if (!aFilter.IsNull())
+    {
+      OcctTraceScope aTraceLoad ("LoadParts");
+      const PCDM_ReaderStatus aReaderStatus = myXdeApp->Open (myXbfPath, myXdeDoc, aFilter);
+      if (aReaderStatus != PCDM_RS_OK)
+      {
+        Message::SendFail() << "Error occurred during partial XBF import: " << (int )aReaderStatus << ".\n" << myXbfPath;
+      }
+
+      std::vector<TopoDS_Shape> aShapes;
+      std::vector<MyLazyPart*>  aParts;
+      for (TDF_LabelMap::Iterator aLabelIter (aToLoad); aLabelIter.More(); aLabelIter.Next())
+      {
+        TopoDS_Shape aShape = XCAFDoc_ShapeTool::GetShape (aLabelIter.Key());
+        if (aShape.IsNull()) { continue; }
+
+        aShapes.push_back (aShape);
+        aParts.push_back (&myLazyParts.ChangeFind (aLabelIter.Key()));
+      }
+
+      const Handle(Prs3d_Drawer)& aDefDrawer = myContext->DefaultDrawer();
+      OSD_Parallel::For (0, (int )aShapes.size(), [&](int theIndex)
+      {
+        meshShape (aShapes[theIndex], aDefDrawer);
+        aParts[theIndex]->Memory = estimateShapeMemory (aShapes[theIndex]);
+      });
+      for (MyLazyPart* aPart : aParts)
+      {
+        aPart->IsLoaded = true;
+        myLazyMemory += aPart->Memory;
+        ++aNbLoaded;
+      }
+    }
+
+    for (size_t aNodeIter : aVisNodes)
+    {
+      const XCAFPrs_DocumentNode& aNode = myLazyNodes[aNodeIter].Node;
+      if (!myNodePrsMap.IsBound (aNode.Id)
+       && myLazyParts.Find (aNode.RefLabel).IsLoaded)
+      {
+        displayNode (aNode);
+        ++aNbDisplayed;
+      }
+    }
+
+    if (myLazyMemory > myLazyBudget)
+    {
+      std::vector<std::pair<int, TDF_Label>> anUnloadable;
+      for (NCollection_DataMap<TDF_Label, MyLazyPart, TDF_LabelMapHasher>::Iterator aPartIter (myLazyParts); aPartIter.More(); aPartIter.Next())
+      {
+        if (aPartIter.Value().IsLoaded
+         && aPartIter.Value().LastVisible != myLazyFrame)
+        {
+          anUnloadable.push_back (std::make_pair (aPartIter.Value().LastVisible, aPartIter.Key()));
+        }
+      }
+      std::sort (anUnloadable.begin(), anUnloadable.end(),
+                 [](const std::pair<int, TDF_Label>& theLeft, const std::pair<int, TDF_Label>& theRight) { return theLeft.first < theRight.first; });
+      for (size_t aPartIter = 0; aPartIter < anUnloadable.size() && myLazyMemory > myLazyBudget; ++aPartIter)
+      {
+        unloadPart (anUnloadable[aPartIter].second);
+        ++aNbUnloaded;
+      }
+    }
+
+    aTimer.Stop();
+    if (aNbLoaded != 0 || aNbUnloaded != 0)
+    {
+      int aNbResident = 0;
+      for (NCollection_DataMap<TDF_Label, MyLazyPart, TDF_LabelMapHasher>::Iterator aPartIter (myLazyParts); aPartIter.More(); aPartIter.Next())
+      {
+        if (aPartIter.Value().IsLoaded) { ++aNbResident; }
+      }
+      Message::SendInfo() << "Partial loading: " << (int )aVisNodes.size() << " of " << (int )myLazyNodes.size() << " nodes visible, "
+                          << aNbLoaded << " parts loaded, " << aNbDisplayed << " nodes displayed, " << aNbUnloaded << " parts unloaded in "
+                          << 1000.0 * aTimer.ElapsedTime() << " ms; resident " << aNbResident << " of " << myLazyParts.Extent() << " parts, "
+                          << double(myLazyMemory) / (1024.0 * 1024.0) << " of " << double(myLazyBudget) / (1024.0 * 1024.0) << " MiB";
+    }
+  }
+
   //! Open STEP file.
   bool OpenSTEP (const TCollection_AsciiString& theFilePath)
   {
@@ -136,15 +720,21 @@ public:
     aTimer.Start();
     try
     {
-      if (aReader.ReadFile (theFilePath.ToCString()) != IFSelect_RetDone) // read model from file
       {
-        Message::SendFail() << "Error occurred reading STEP file\n" << theFilePath;
-        return false;
+        OcctTraceScope aTraceRead ("ReadSTEP");
+        if (aReader.ReadFile (theFilePath.ToCString()) != IFSelect_RetDone) // read model from file
+        {
+          Message::SendFail() << "Error occurred reading STEP file\n" << theFilePath;
+          return false;
+        }
       }
-      if (!aReader.Transfer (myXdeDoc)) // translate model into document
       {
-        Message::SendFail() << "Error occurred transferring STEP file\n" << theFilePath;
-        return false;
+        OcctTraceScope aTraceTransfer ("TransferSTEP");
+        if (!aReader.Transfer (myXdeDoc)) // translate model into document
+        {
+          Message::SendFail() << "Error occurred transferring STEP file\n" << theFilePath;
+          return false;
+        }
       }
 
       Message::SendInfo() << "File '" << theFilePath << "' opened in " << aTimer.ElapsedTime() << " s";
@@ -157,10 +747,181 @@ public:
     return true;
   }
 
+  //! Fold part prototypes with the same geometry into shared ones with instance transformations.
+  bool DeduplicateParts()
+  {
+    if (myXdeDoc.IsNull()) { return false; }
+
+    OcctTraceScope aTrace ("DeduplicateParts");
+    OcctXCafDedup aDedup;
+    if (!aDedup.Perform (myXdeDoc))
+    {
+      return false;
+    }
+    aDedup.DumpStats();
+    return true;
+  }
+
+  //! Compute volume, area, center of mass and bounding box of every document node and save them into CSV or JSON file.
+  bool SaveMassReport (const TCollection_AsciiString& theFilePath)
+  {
+    if (myXdeDoc.IsNull()) { return false; }
+
+    OcctTraceScope aTrace ("MassReport");
+    OcctXCafReport aReport;
+    if (!aReport.Perform (myXdeDoc)
+     || !aReport.Save (theFilePath))
+    {
+      return false;
+    }
+    aReport.DumpStats();
+    return true;
+  }
+
+  //! Detect clashes between displayed (meshed) parts, select clashing presentations and save pairs into JSON file.
+  bool DetectClashes (const TCollection_AsciiString& theFilePath,
+                      double theTolerance)
+  {
+    if (myXdeDoc.IsNull()) { return false; }
+
+    OcctTraceScope aTrace ("DetectClashes");
+    OcctXCafClash aClash;
+    aClash.SetTolerance (theTolerance);
+    if (!aClash.Perform (myXdeDoc))
+    {
+      return false;
+    }
+    aClash.DumpStats();
+
+    myContext->ClearSelected (false);
+    NCollection_Map<TCollection_AsciiString> aSelIds;
+    for (const OcctXCafClashPair& aPair : aClash.Clashes())
+    {
+      const TCollection_AsciiString* aNodeIds[2] = { &aClash.LeafIds()[aPair.Leaf1], &aClash.LeafIds()[aPair.Leaf2] };
+      for (const TCollection_AsciiString* aNodeId : aNodeIds)
+      {
+        Handle(XCAFPrs_AISObject) aPrs;
+        if (aSelIds.Add (*aNodeId)
+         && myNodePrsMap.Find (*aNodeId, aPrs))
+        {
+          myContext->AddOrRemoveSelected (aPrs, false);
+        }
+      }
+    }
+    myContext->UpdateCurrentViewer();
+    return theFilePath.IsEmpty()
+        || aClash.SaveJson (theFilePath);
+  }
+
+  //! Enable section view with capping by specified plane; parts are drawn on the side of plane normal.
+  //! Only parts intersected by the plane are clipped and capped,
+  //! parts entirely on the clipped side are hidden and the others are drawn as usual.
+  void SetSectionPlane (const gp_Pln& thePlane)
+  {
+    ResetSection();
+    OcctTraceScope aTrace ("SetSectionPlane");
+    mySectionPlane = new Graphic3d_ClipPlane (thePlane);
+    mySectionPlane->SetCapping (true);
+    mySectionPlane->SetUseObjectMaterial (true);
+
+    Bnd_Box aSceneBox;
+    for (MyNodePrsMap::Iterator aPrsIter (myNodePrsMap); aPrsIter.More(); aPrsIter.Next())
+    {
+      MySectionPart aPart;
+      aPart.Prs  = aPrsIter.Value();
+      aPart.Side = MySectionSide_Kept;
+      aPart.Prs->BoundingBox (aPart.Box);
+      if (aPart.Box.IsVoid()) { continue; }
+
+      aPart.Box = aPart.Box.Transformed (aPart.Prs->Transformation());
+      aSceneBox.Add (aPart.Box);
+      mySectionParts.push_back (aPart);
+    }
+    mySectionStep = !aSceneBox.IsVoid() ? std::sqrt (aSceneBox.SquareExtent()) / 100.0 : 1.0;
+    updateSection();
+  }
+
+  //! Move section plane along its normal.
+  void MoveSectionPlane (double theDelta)
+  {
+    if (mySectionPlane.IsNull()) { return; }
+
+    gp_Pln aPlane = mySectionPlane->ToPlane();
+    aPlane.Translate (gp_Vec (aPlane.Axis().Direction()) * theDelta);
+    mySectionPlane->SetEquation (aPlane);
+    updateSection();
+  }
+
+  //! Disable section view.
+  void ResetSection()
+  {
+    if (mySectionPlane.IsNull()) { return; }
+
+    for (MySectionPart& aPart : mySectionParts)
+    {
+      setSectionSide (aPart, MySectionSide_Kept);
+    }
+    mySectionParts.clear();
+    mySectionPlane.Nullify();
+    myView->Invalidate();
+  }
+
+  //! Sweep section plane across displayed parts along X axis and report update and frame times.
+  //! @param[in] theNbFrames number of plane positions
+  bool RunSectionBenchmark (int theNbFrames)
+  {
+    Bnd_Box aSceneBox;
+    for (MyNodePrsMap::Iterator aPrsIter (myNodePrsMap); aPrsIter.More(); aPrsIter.Next())
+    {
+      Bnd_Box aBox;
+      aPrsIter.Value()->BoundingBox (aBox);
+      if (!aBox.IsVoid()) { aSceneBox.Add (aBox.Transformed (aPrsIter.Value()->Transformation())); }
+    }
+    if (aSceneBox.IsVoid())
+    {
+      Message::SendFail() << "Error: nothing displayed for section benchmark";
+      return false;
+    }
+
+    OcctTraceScope aTrace ("SectionBenchmark");
+    const double aMinX = aSceneBox.CornerMin().X(), aMaxX = aSceneBox.CornerMax().X();
+    SetSectionPlane (gp_Pln (gp_Pnt (aMinX, 0.0, 0.0), gp::DX()));
+    myView->Redraw();
+
+    const double aStep = (aMaxX - aMinX) / theNbFrames;
+    double anUpdateTime = 0.0, aFrameTime = 0.0, aMaxFrameTime = 0.0;
+    size_t aNbCut = 0;
+    OSD_Timer aTimer;
+    for (int aFrameIter = 0; aFrameIter < theNbFrames; ++aFrameIter)
+    {
+      aTimer.Reset();
+      aTimer.Start();
+      MoveSectionPlane (aStep);
+      const double anUpdate = aTimer.ElapsedTime();
+      myView->Redraw();
+      finishRendering();
+      aTimer.Stop();
+      anUpdateTime += anUpdate;
+      aFrameTime   += aTimer.ElapsedTime();
+      aMaxFrameTime = std::max (aMaxFrameTime, aTimer.ElapsedTime());
+      for (const MySectionPart& aPart : mySectionParts)
+      {
+        if (aPart.Side == MySectionSide_Cut) { ++aNbCut; }
+      }
+    }
+    Message::SendInfo() << "Section sweep over " << (int )mySectionParts.size() << " parts in " << theNbFrames << " frames: "
+                        << "average " << (double )aNbCut / theNbFrames << " intersected parts, "
+                        << "update " << 1000.0 * anUpdateTime / theNbFrames << " ms, "
+                        << "frame " << 1000.0 * aFrameTime / theNbFrames << " ms (max " << 1000.0 * aMaxFrameTime << " ms, "
+                        << theNbFrames / aFrameTime << " FPS)";
+    return true;
+  }
+
   //! Dump XCAF document tree.
   void DumpXCafDocumentTree()
   {
     if (myXdeDoc.IsNull()) { return; }
+    OcctTraceScope aTrace ("DumpDocumentTree");
     for (XCAFPrs_DocumentExplorer aDocExp (myXdeDoc, XCAFPrs_DocumentExplorerFlags_None); aDocExp.More(); aDocExp.Next())
     {
       //std::cout << aDocExp.Current().Id << "\n";
@@ -170,39 +931,788 @@ public:
       aName = TCollection_AsciiString (aDocExp.CurrentDepth() * 2, ' ') + aName;
       std::cout << aName << "\n";
     }
-    std::cout << "\n";
+    std::cout << "\n";
+  }
+
+  //! Display XCAF document within AIS context.
+  void DisplayXCafDocument (bool theToExplode)
+  {
+    if (myXdeDoc.IsNull()) { return; }
+    if (myIsLazy)
+    {
+      displayLazyDocument();
+      return;
+    }
+    OcctTraceScope aTrace ("DisplayDocument");
+    myIsExploded = theToExplode;
+    myLabelNodes.Clear();
+    for (XCAFPrs_DocumentExplorer aDocExp (myXdeDoc, XCAFPrs_DocumentExplorerFlags_None); aDocExp.More(); aDocExp.Next())
+    {
+      if (registerNode (aDocExp))
+      {
+        displayNode (aDocExp.Current());
+      }
+    }
+
+    myNbProxyParts = 0;
+    myView->FitAll (0.01, false);
+    AIS_ViewController::ProcessExpose();
+  }
+
+  //! Set frame time budget in seconds for adaptive navigation; 0 disables bounding box proxies.
+  //! When full detail frame exceeds the budget, parts are replaced by merged box proxies during camera motion
+  //! and restored when motion stops.
+  void SetNavigationBudget (double theSeconds) { myNavFrameBudget = theSeconds; }
+
+  //! Commit document transaction opened by TDocStd_Document::OpenCommand() and synchronize presentations with it.
+  MySyncStats CommitEdit()
+  {
+    if (myXdeDoc.IsNull()
+     || !myXdeDoc->CommitCommand()) // empty transactions are not stored
+    {
+      return MySyncStats();
+    }
+    return SyncDelta (myXdeDoc->GetUndos().Last());
+  }
+
+  //! Undo the last document transaction and synchronize presentations with it.
+  MySyncStats UndoEdit()
+  {
+    if (myXdeDoc.IsNull()
+     || !myXdeDoc->Undo())
+    {
+      return MySyncStats();
+    }
+    // undone delta is prepended to the redo list
+    return SyncDelta (myXdeDoc->GetRedos().First());
+  }
+
+  //! Redo the last undone document transaction and synchronize presentations with it.
+  MySyncStats RedoEdit()
+  {
+    if (myXdeDoc.IsNull()
+     || !myXdeDoc->Redo())
+    {
+      return MySyncStats();
+    }
+    return SyncDelta (myXdeDoc->GetUndos().Last());
+  }
+
+  //! Synchronize displayed presentations with document changes listed by transaction delta.
+  //! Modified labels are mapped to affected nodes through the label index built at display time,
+  //! so that only these presentations are touched:
+  //! - location changes of instances update local transformation of presentations of all nodes below them;
+  //! - other attribute changes (colors, materials, visibility, geometry) recompute affected presentations;
+  //! - added or removed instances and free shapes trigger a walk over document structure,
+  //!   which displays new nodes and erases removed ones without recomputing existing presentations.
+  MySyncStats SyncDelta (const Handle(TDF_Delta)& theDelta)
+  {
+    MySyncStats aStats;
+    if (theDelta.IsNull()) { return aStats; }
+
+    OcctTraceScope aTrace ("SyncDelta");
+    OSD_Timer aTimer;
+    aTimer.Start();
+    const TDF_Label aShapesLabel = XCAFDoc_DocumentTool::ShapesLabel (myXdeDoc->Main());
+    NCollection_DataMap<TCollection_AsciiString, int> anAffected;
+    bool isStructureChanged = false;
+    for (TDF_ListIteratorOfAttributeDeltaList aDeltaIter (theDelta->AttributeDeltas()); aDeltaIter.More(); aDeltaIter.Next())
+    {
+      const Handle(TDF_AttributeDelta)& anAttrDelta = aDeltaIter.Value();
+      const TDF_Label aLabel = anAttrDelta->Label();
+      const bool isShapeAttr = anAttrDelta->Attribute()->IsKind (STANDARD_TYPE(TNaming_NamedShape));
+      const bool isComponent = XCAFDoc_ShapeTool::IsComponent (aLabel);
+      if (isShapeAttr
+       && (anAttrDelta->IsKind (STANDARD_TYPE(TDF_DeltaOnAddition))
+        || anAttrDelta->IsKind (STANDARD_TYPE(TDF_DeltaOnRemoval)))
+       && (isComponent
+        || aLabel.Father() == aShapesLabel
+        || myLabelNodes.IsBound (aLabel)))
+      {
+        isStructureChanged = true;
+        if (myIsExploded) { continue; }
+      }
+      else if (isShapeAttr
+            && myIsExploded
+            && XCAFDoc_ShapeTool::IsAssembly (aLabel))
+      {
+        continue; // compound of assembly is derived from its components displayed separately
+      }
+
+      int anAction = MySyncAction_Restyle;
+      if (myIsExploded
+       && (anAttrDelta->Attribute()->IsKind (STANDARD_TYPE(XCAFDoc_Location))
+        || (isShapeAttr && isComponent)))
+      {
+        anAction = MySyncAction_Relocate;
+      }
+      else if (isShapeAttr)
+      {
+        anAction |= MySyncAction_Remesh;
+      }
+
+      // attributes of sub-shapes are stored on child labels of the shape;
+      // labels of new instances are not indexed and handled by structure walk
+      for (TDF_Label aLabIter = aLabel; !aLabIter.IsNull(); aLabIter = aLabIter.Father())
+      {
+        if (const NCollection_List<TCollection_AsciiString>* aNodes = myLabelNodes.Seek (aLabIter))
+        {
+          for (NCollection_List<TCollection_AsciiString>::Iterator aNodeIter (*aNodes); aNodeIter.More(); aNodeIter.Next())
+          {
+            if (int* aNodeAction = anAffected.ChangeSeek (aNodeIter.Value())) { *aNodeAction |= anAction; }
+            else { anAffected.Bind (aNodeIter.Value(), anAction); }
+          }
+          break;
+        }
+        if (myIsExploded && XCAFDoc_ShapeTool::IsComponent (aLabIter)) { break; }
+      }
+    }
+
+    if (isStructureChanged)
+    {
+      syncStructure (aStats);
+    }
+
+    const Handle(Prs3d_Drawer)& aDefDrawer = myContext->DefaultDrawer();
+    for (NCollection_DataMap<TCollection_AsciiString, int>::Iterator anAffIter (anAffected); anAffIter.More(); anAffIter.Next())
+    {
+      Handle(XCAFPrs_AISObject) aPrs;
+      if (!myNodePrsMap.Find (anAffIter.Key(), aPrs)) { continue; } // removed node
+
+      if ((anAffIter.Value() & MySyncAction_Relocate) != 0)
+      {
+        TopLoc_Location aParentLoc, aLoc;
+        if (!XCAFPrs_DocumentExplorer::FindLabelFromPathId (myXdeDoc, anAffIter.Key(), aParentLoc, aLoc).IsNull())
+        {
+          aPrs->SetLocalTransformation (aLoc);
+          myContext->SelectionManager()->Update (aPrs, false);
+          ++aStats.NbRelocated;
+        }
+      }
+      if ((anAffIter.Value() & MySyncAction_Restyle) != 0)
+      {
+        if ((anAffIter.Value() & MySyncAction_Remesh) != 0)
+        {
+          meshShape (XCAFDoc_ShapeTool::GetShape (aPrs->GetLabel()), aDefDrawer);
+        }
+        // resetting label requests re-reading shape and styles from document on next computation
+        aPrs->SetLabel (aPrs->GetLabel());
+        myContext->Redisplay (aPrs, false);
+        ++aStats.NbRestyled;
+      }
+    }
+
+    myNbProxyParts = 0; // proxies are rebuilt on next navigation
+    myView->Invalidate();
+    aTimer.Stop();
+    aStats.Time = aTimer.ElapsedTime();
+    return aStats;
+  }
+
+  //! Apply random single-part edits to displayed document - surface color changes of parts and moves of instances,
+  //! each within its own transaction followed by synchronization of presentations; then undo them.
+  //! Reports synchronization latencies and compares them with full redisplay of the document.
+  //! @param[in] theNbEdits number of edits
+  bool RunEditBenchmark (int theNbEdits)
+  {
+    if (myXdeDoc.IsNull() || myNodePrsMap.IsEmpty())
+    {
+      Message::SendFail() << "Error: no displayed document to edit";
+      return false;
+    }
+
+    OcctTraceScope aTrace ("EditBenchmark");
+    std::vector<TCollection_AsciiString> anIds;
+    for (MyNodePrsMap::Iterator aNodeIter (myNodePrsMap); aNodeIter.More(); aNodeIter.Next())
+    {
+      anIds.push_back (aNodeIter.Key());
+    }
+
+    const Bnd_Box aSceneBox = myView->View()->MinMaxValues();
+    const double aStep = !aSceneBox.IsVoid() ? 0.02 * std::sqrt (aSceneBox.SquareExtent()) : 1.0;
+    const Handle(XCAFDoc_ColorTool) aColorTool = XCAFDoc_DocumentTool::ColorTool (myXdeDoc->Main());
+    std::mt19937 aRandGen (1);
+    std::uniform_real_distribution<double> aRandColor (0.0, 1.0);
+
+    MySyncStats anEditStats, anUndoStats;
+    double anEditMax = 0.0, anUndoMax = 0.0;
+    int aNbEdits = 0, aNbUndos = 0;
+    for (int anEditIter = 0; anEditIter < theNbEdits; ++anEditIter)
+    {
+      const TCollection_AsciiString& anId = anIds[aRandGen() % anIds.size()];
+      TopLoc_Location aParentLoc, aLoc;
+      const TDF_Label anInstLabel = XCAFPrs_DocumentExplorer::FindLabelFromPathId (myXdeDoc, anId, aParentLoc, aLoc);
+      if (anInstLabel.IsNull()) { continue; }
+
+      myXdeDoc->OpenCommand();
+      if (anEditIter % 2 == 1
+       && XCAFDoc_ShapeTool::IsComponent (anInstLabel))
+      {
+        gp_Trsf aShift;
+        aShift.SetTranslation (gp_Vec (0.0, 0.0, aStep));
+        setInstanceLocation (anInstLabel, TopLoc_Location (aShift) * XCAFDoc_ShapeTool::GetLocation (anInstLabel));
+      }
+      else
+      {
+        TDF_Label aProtoLabel = anInstLabel;
+        XCAFDoc_ShapeTool::GetReferredShape (anInstLabel, aProtoLabel);
+        aColorTool->SetColor (aProtoLabel, Quantity_Color (aRandColor (aRandGen), aRandColor (aRandGen), aRandColor (aRandGen), Quantity_TOC_RGB),
+                              XCAFDoc_ColorSurf);
+      }
+
+      const MySyncStats aStats = CommitEdit();
+      anEditStats.NbRelocated += aStats.NbRelocated;
+      anEditStats.NbRestyled  += aStats.NbRestyled;
+      anEditStats.Time        += aStats.Time;
+      anEditMax = std::max (anEditMax, aStats.Time);
+      ++aNbEdits;
+    }
+
+    while (myXdeDoc->GetAvailableUndos() > 0)
+    {
+      const MySyncStats aStats = UndoEdit();
+      anUndoStats.NbRelocated += aStats.NbRelocated;
+      anUndoStats.NbRestyled  += aStats.NbRestyled;
+      anUndoStats.Time        += aStats.Time;
+      anUndoMax = std::max (anUndoMax, aStats.Time);
+      ++aNbUndos;
+    }
+
+    OSD_Timer aFullTimer;
+    aFullTimer.Start();
+    myContext->RemoveAll (false);
+    myNodePrsMap.Clear();
+    DisplayXCafDocument (myIsExploded);
+    aFullTimer.Stop();
+    rebindPresentations();
+
+    Message::SendInfo() << "Edited " << aNbEdits << " parts of " << (int )anIds.size() << " displayed nodes: "
+                        << anEditStats.NbRelocated << " relocated, " << anEditStats.NbRestyled << " restyled presentations; sync "
+                        << (aNbEdits > 0 ? 1000.0 * anEditStats.Time / aNbEdits : 0.0) << " ms average, "
+                        << 1000.0 * anEditMax << " ms max";
+    Message::SendInfo() << "Undone " << aNbUndos << " edits: "
+                        << anUndoStats.NbRelocated << " relocated, " << anUndoStats.NbRestyled << " restyled presentations; sync "
+                        << (aNbUndos > 0 ? 1000.0 * anUndoStats.Time / aNbUndos : 0.0) << " ms average, "
+                        << 1000.0 * anUndoMax << " ms max";
+    Message::SendInfo() << "Full redisplay of document: " << 1000.0 * aFullTimer.ElapsedTime() << " ms";
+    return true;
+  }
+
+  //! Record synthetic transform stream for displayed nodes - exploded view animation
+  //! moving each node away from the model center and back.
+  //! @param[in] theFilePath output file path
+  //! @param[in] theNbFrames number of recorded frames
+  //! @param[in] theFps      recording frame rate
+  bool RecordDemoPlayback (const TCollection_AsciiString& theFilePath,
+                           int theNbFrames,
+                           double theFps)
+  {
+    OcctTraceScope aTrace ("RecordPlayback");
+    std::vector<TCollection_AsciiString> anIds;
+    std::vector<gp_Trsf> aLocs;
+    std::vector<gp_XYZ>  aCenters;
+    Bnd_Box aModelBox;
+    for (MyNodePrsMap::Iterator aNodeIter (myNodePrsMap); aNodeIter.More(); aNodeIter.Next())
+    {
+      Bnd_Box aBox;
+      BRepBndLib::Add (XCAFDoc_ShapeTool::GetShape (aNodeIter.Value()->GetLabel()), aBox);
+      if (aBox.IsVoid()) { continue; }
+
+      const gp_Trsf aLoc = aNodeIter.Value()->LocalTransformation();
+      aBox = aBox.Transformed (aLoc);
+      aModelBox.Add (aBox);
+      anIds.push_back (aNodeIter.Key());
+      aLocs.push_back (aLoc);
+      aCenters.push_back ((aBox.CornerMin().XYZ() + aBox.CornerMax().XYZ()) * 0.5);
+    }
+    if (anIds.empty())
+    {
+      Message::SendFail() << "Error: nothing to record";
+      return false;
+    }
+
+    const gp_XYZ aModelCenter = (aModelBox.CornerMin().XYZ() + aModelBox.CornerMax().XYZ()) * 0.5;
+    std::vector<OcctTransformStream::Record> aRecords (anIds.size() * theNbFrames);
+    for (size_t aNodeIter = 0; aNodeIter < anIds.size(); ++aNodeIter)
+    {
+      const gp_XYZ aDir = aCenters[aNodeIter] - aModelCenter;
+      for (int aFrameIter = 0; aFrameIter < theNbFrames; ++aFrameIter)
+      {
+        const double aTime = aFrameIter / theFps;
+        const double anExplode = 0.5 * (1.0 - std::cos (2.0 * M_PI * aFrameIter / std::max (theNbFrames - 1, 1)));
+        gp_Trsf aMove;
+        aMove.SetTranslation (gp_Vec (aDir * anExplode));
+
+        OcctTransformStream::Record& aRec = aRecords[aNodeIter * theNbFrames + aFrameIter];
+        aRec.Node = (uint32_t )aNodeIter;
+        aRec.Reserved = 0;
+        aRec.Time = aTime;
+        OcctTransformStream::SetMatrix (aRec, aMove * aLocs[aNodeIter]);
+      }
+    }
+    if (!OcctTransformStream::Write (theFilePath, anIds, aRecords))
+    {
+      return false;
+    }
+    Message::SendInfo() << "Transform stream with " << (int )anIds.size() << " nodes and "
+                        << theNbFrames << " frames saved into '" << theFilePath << "'";
+    return true;
+  }
+
+  //! Load transform stream for playback.
+  bool LoadPlayback (const TCollection_AsciiString& theFilePath)
+  {
+    OcctTraceScope aTrace ("LoadPlayback");
+    myPlayback = new MyPlaybackAnimation (myContext);
+    if (!myPlayback->Load (theFilePath, myNodePrsMap))
+    {
+      myPlayback.Nullify();
+      return false;
+    }
+    Message::SendInfo() << "Transform stream '" << theFilePath << "': " << myPlayback->Stream().NbNodes() << " nodes ("
+                        << myPlayback->NbResolvedNodes() << " displayed), " << (double )myPlayback->Stream().NbRecords()
+                        << " records, " << myPlayback->OwnDuration() << " s";
+    return true;
+  }
+
+  //! Start interactive playback.
+  void StartPlayback()
+  {
+    if (myPlayback.IsNull()) { return; }
+    ObjectsAnimation()->Clear();
+    ObjectsAnimation()->Add (myPlayback);
+    ObjectsAnimation()->StartTimer (0.0, 1.0, true);
+  }
+
+  //! Render playback into image sequence at fixed frame rate using offscreen rendering.
+  //! @param[in] theFolder output folder for frame_NNNNN.png files
+  //! @param[in] theFps    frame rate
+  bool ExportPlayback (const TCollection_AsciiString& theFolder,
+                       double theFps)
+  {
+    if (myPlayback.IsNull()) { return false; }
+
+    OcctTraceScope aTrace ("ExportPlayback");
+    const int aNbFrames = (int )std::floor (myPlayback->OwnDuration() * theFps) + 1;
+    V3d_ImageDumpOptions aDumpParams;
+    myView->Window()->Size (aDumpParams.Width, aDumpParams.Height);
+    aDumpParams.BufferType = Graphic3d_BT_RGB;
+
+    Image_AlienPixMap anImage;
+    OSD_Timer aTotalTimer, anEvalTimer, aRenderTimer, aSaveTimer;
+    aTotalTimer.Start();
+    for (int aFrameIter = 0; aFrameIter < aNbFrames; ++aFrameIter)
+    {
+      OcctTraceScope aTraceFrame ("ExportFrame");
+      anEvalTimer.Start();
+      myPlayback->ApplyTime (aFrameIter / theFps);
+      anEvalTimer.Stop();
+
+      aRenderTimer.Start();
+      const bool isRendered = myView->ToPixMap (anImage, aDumpParams);
+      aRenderTimer.Stop();
+      if (!isRendered)
+      {
+        Message::SendFail() << "Error: view dump failed at frame " << aFrameIter;
+        return false;
+      }
+
+      char aFileName[32];
+      Sprintf (aFileName, "/frame_%05d.png", aFrameIter);
+      const TCollection_AsciiString aFilePath = theFolder + aFileName;
+      aSaveTimer.Start();
+      const bool isSaved = anImage.Save (aFilePath);
+      aSaveTimer.Stop();
+      if (!isSaved)
+      {
+        Message::SendFail() << "Error: unable to save image '" << aFilePath << "'";
+        return false;
+      }
+    }
+    aTotalTimer.Stop();
+
+    const double aTotal = aTotalTimer.ElapsedTime();
+    Message::SendInfo() << "Exported " << aNbFrames << " frames " << aDumpParams.Width << "x" << aDumpParams.Height
+                        << " at " << theFps << " fps into '" << theFolder << "' in " << aTotal << " s ("
+                        << aNbFrames / aTotal << " frames/s; per frame: interpolation "
+                        << 1000.0 * anEvalTimer.ElapsedTime() / aNbFrames << " ms, render "
+                        << 1000.0 * aRenderTimer.ElapsedTime() / aNbFrames << " ms, save "
+                        << 1000.0 * aSaveTimer.ElapsedTime() / aNbFrames << " ms)";
+    return true;
+  }
+
+  //! Render auxiliary passes of current view - color, depth, surface normals and object ids,
+  //! and write them into folder with JSON sidecar mapping id values to XCAF node Ids.
+  //! All passes are produced from the same displayed presentations:
+  //! color and depth are read back from OpenGL, ids are rendered on GPU by highlighting each presentation
+  //! with a flat color encoding its id within unlit view, and world-space normals are reconstructed
+  //! from depth of neighbor pixels with the same id.
+  //! @param[in] theFolder output folder
+  bool ExportPasses (const TCollection_AsciiString& theFolder)
+  {
+    OcctTraceScope aTrace ("ExportPasses");
+    V3d_ImageDumpOptions aDumpParams;
+    myView->Window()->Size (aDumpParams.Width, aDumpParams.Height);
+    const int aSizeX = aDumpParams.Width, aSizeY = aDumpParams.Height;
+
+    OSD_Timer aColorTimer, aDepthTimer, anIdTimer, aNormalTimer, aSaveTimer;
+    aColorTimer.Start();
+    Image_AlienPixMap aColorImage;
+    aDumpParams.BufferType = Graphic3d_BT_RGB;
+    if (!myView->ToPixMap (aColorImage, aDumpParams))
+    {
+      Message::SendFail() << "Error: color pass dump failed";
+      return false;
+    }
+    aColorTimer.Stop();
+
+    aDepthTimer.Start();
+    Image_PixMap aDepthImage;
+    aDumpParams.BufferType = Graphic3d_BT_Depth;
+    if (!myView->ToPixMap (aDepthImage, aDumpParams))
+    {
+      Message::SendFail() << "Error: depth pass dump failed";
+      return false;
+    }
+    aDepthTimer.Stop();
+
+    anIdTimer.Start();
+    Image_AlienPixMap anIdImage;
+    std::vector<TCollection_AsciiString> aNodeIds;
+    if (!renderIdPass (anIdImage, aNodeIds, aDumpParams))
+    {
+      Message::SendFail() << "Error: id pass dump failed";
+      return false;
+    }
+    anIdTimer.Stop();
+
+    // ids are encoded into 24-bit RGB as (r + g * 256 + b * 65536)
+    aNormalTimer.Start();
+    std::vector<int>   anIds    (size_t(aSizeX) * aSizeY, 0);
+    std::vector<float> aDepths  (size_t(aSizeX) * aSizeY, 1.0f);
+    std::vector<float> aNormals (size_t(aSizeX) * aSizeY * 3, 0.0f);
+    size_t aNbCovered = 0;
+    for (int aRow = 0; aRow < aSizeY; ++aRow)
+    {
+      const float* aDepthRow = (const float* )aDepthImage.Row (aRow);
+      for (int aCol = 0; aCol < aSizeX; ++aCol)
+      {
+        const size_t aPixIndex = size_t(aRow) * aSizeX + aCol;
+        aDepths[aPixIndex] = aDepthRow[aCol];
+        const Image_ColorRGB& aPixel = anIdImage.Value<Image_ColorRGB> (aRow, aCol);
+        const int anId = int(aPixel.r()) | (int(aPixel.g()) << 8) | (int(aPixel.b()) << 16);
+        if (anId > 0 && anId < (int )aNodeIds.size())
+        {
+          anIds[aPixIndex] = anId;
+          ++aNbCovered;
+        }
+      }
+    }
+    reconstructNormals (aSizeX, aSizeY, anIds, aDepths, aNormals);
+    aNormalTimer.Stop();
+
+    aSaveTimer.Start();
+    bool isSaved = aColorImage.Save (theFolder + "/color.png")
+                && anIdImage.Save (theFolder + "/id.png")
+                && savePfm (theFolder + "/depth.pfm", aSizeX, aSizeY, 1, aDepths.data())
+                && savePfm (theFolder + "/normal.pfm", aSizeX, aSizeY, 3, aNormals.data());
+    if (isSaved)
+    {
+      std::ofstream aJson ((theFolder + "/passes.json").ToCString(), std::ios::out | std::ios::trunc);
+      aJson << "{\n"
+            << "  \"width\": " << aSizeX << ",\n"
+            << "  \"height\": " << aSizeY << ",\n"
+            << "  \"color\": \"color.png\",\n"
+            << "  \"depth\": \"depth.pfm\",\n"
+            << "  \"normal\": \"normal.pfm\",\n"
+            << "  \"id\": \"id.png\",\n"
+            << "  \"idEncoding\": \"r + g * 256 + b * 65536, 0 is background\",\n"
+            << "  \"ids\": {";
+      for (size_t anIdIter = 1; anIdIter < aNodeIds.size(); ++anIdIter)
+      {
+        aJson << (anIdIter > 1 ? "," : "") << "\n    \"" << anIdIter << "\": \"" << jsonEscape (aNodeIds[anIdIter]).ToCString() << "\"";
+      }
+      aJson << "\n  }\n}\n";
+      isSaved = aJson.good();
+    }
+    aSaveTimer.Stop();
+    if (!isSaved)
+    {
+      Message::SendFail() << "Error: unable to save passes into folder '" << theFolder << "'";
+      return false;
+    }
+
+    Message::SendInfo() << "Exported passes " << aSizeX << "x" << aSizeY << " into '" << theFolder << "' ("
+                        << (int )(aNodeIds.size() - 1) << " node ids, " << (int )aNbCovered << " covered pixels): color "
+                        << 1000.0 * aColorTimer.ElapsedTime() << " ms, depth "
+                        << 1000.0 * aDepthTimer.ElapsedTime() << " ms, ids "
+                        << 1000.0 * anIdTimer.ElapsedTime() << " ms, normals "
+                        << 1000.0 * aNormalTimer.ElapsedTime() << " ms, save "
+                        << 1000.0 * aSaveTimer.ElapsedTime() << " ms";
+    return true;
+  }
+
+private:
+
+  //! Actions of presentations synchronization.
+  enum MySyncAction
+  {
+    MySyncAction_Relocate = 0x01, //!< update local transformation
+    MySyncAction_Restyle  = 0x02, //!< recompute presentation
+    MySyncAction_Remesh   = 0x04, //!< mesh shape before recomputing
+  };
+
+  //! Collect leaves of partially loaded document with part bounding boxes stored by SaveXBF(),
+  //! fit view to them and display visible parts; only leaves could be displayed separately in this mode.
+  void displayLazyDocument()
+  {
+    OcctTraceScope aTrace ("DisplayLazyDocument");
+    myIsExploded = true;
+    myLabelNodes.Clear();
+    myLazyNodes.clear();
+    myLazyParts.Clear();
+    Bnd_Box aSceneBox;
+    for (XCAFPrs_DocumentExplorer aDocExp (myXdeDoc, XCAFPrs_DocumentExplorerFlags_None); aDocExp.More(); aDocExp.Next())
+    {
+      if (!registerNode (aDocExp)) { continue; }
+
+      MyLazyNode aNode;
+      aNode.Node = aDocExp.Current();
+      Handle(TDataStd_RealArray) aBoxAttr;
+      if (aNode.Node.RefLabel.FindAttribute (lazyBoxGuid(), aBoxAttr)
+       && aBoxAttr->Length() == 6)
+      {
+        aNode.Box.Update (aBoxAttr->Value (1), aBoxAttr->Value (2), aBoxAttr->Value (3),
+                          aBoxAttr->Value (4), aBoxAttr->Value (5), aBoxAttr->Value (6));
+        aNode.Box = aNode.Box.Transformed (aNode.Node.Location);
+        aSceneBox.Add (aNode.Box);
+      }
+
+      MyLazyPart* aPart = myLazyParts.ChangeSeek (aNode.Node.RefLabel);
+      if (aPart == NULL)
+      {
+        aPart = myLazyParts.Bound (aNode.Node.RefLabel, MyLazyPart());
+        TDF_Tool::Entry (aNode.Node.RefLabel, aPart->Entry);
+      }
+      aPart->Nodes.push_back (myLazyNodes.size());
+      myLazyNodes.push_back (aNode);
+    }
+
+    if (!aSceneBox.IsVoid()) { myView->FitAll (aSceneBox, 0.01, false); }
+    UpdateLazyParts();
+    AIS_ViewController::ProcessExpose();
+  }
+
+  //! Erase nodes of the part and release its shapes from document.
+  void unloadPart (const TDF_Label& theLabel)
+  {
+    MyLazyPart& aPart = myLazyParts.ChangeFind (theLabel);
+    for (size_t aNodeIter : aPart.Nodes)
+    {
+      const TCollection_AsciiString& anId = myLazyNodes[aNodeIter].Node.Id;
+      Handle(XCAFPrs_AISObject) aPrs;
+      if (myNodePrsMap.Find (anId, aPrs))
+      {
+        myContext->Remove (aPrs, false);
+        myNodePrsMap.UnBind (anId);
+      }
+    }
+
+    // sub-shapes are stored on child labels
+    for (TDF_ChildIterator aChildIter (theLabel, true); aChildIter.More(); aChildIter.Next())
+    {
+      aChildIter.Value().ForgetAttribute (TNaming_NamedShape::GetID());
+    }
+    theLabel.ForgetAttribute (TNaming_NamedShape::GetID());
+    myLazyMemory -= aPart.Memory;
+    aPart.Memory = 0;
+    aPart.IsLoaded = false;
+  }
+
+  //! Return TRUE if box intersects view frustum defined by view-projection matrix.
+  static bool isInFrustum (const Graphic3d_Mat4d& theViewProj,
+                           const Bnd_Box& theBox)
+  {
+    // box is outside when all its corners are outside the same clip plane
+    const gp_Pnt aMin = theBox.CornerMin(), aMax = theBox.CornerMax();
+    int anOutside[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int aCornerIter = 0; aCornerIter < 8; ++aCornerIter)
+    {
+      const Graphic3d_Vec4d aClip = theViewProj * Graphic3d_Vec4d ((aCornerIter & 1) != 0 ? aMax.X() : aMin.X(),
+                                                                   (aCornerIter & 2) != 0 ? aMax.Y() : aMin.Y(),
+                                                                   (aCornerIter & 4) != 0 ? aMax.Z() : aMin.Z(), 1.0);
+      if (aClip.x() < -aClip.w()) { ++anOutside[0]; }
+      if (aClip.x() >  aClip.w()) { ++anOutside[1]; }
+      if (aClip.y() < -aClip.w()) { ++anOutside[2]; }
+      if (aClip.y() >  aClip.w()) { ++anOutside[3]; }
+      if (aClip.z() < -aClip.w()) { ++anOutside[4]; }
+      if (aClip.z() >  aClip.w()) { ++anOutside[5]; }
+    }
+    for (int aPlaneIter = 0; aPlaneIter < 6; ++aPlaneIter)
+    {
+      if (anOutside[aPlaneIter] == 8) { return false; }
+    }
+    return true;
+  }
+
+  //! Register labels of the current explorer node within label index.
+  //! @return TRUE if node should be displayed as dedicated presentation
+  bool registerNode (const XCAFPrs_DocumentExplorer& theExp)
+  {
+    const XCAFPrs_DocumentNode& aNode = theExp.Current();
+    if (!myIsExploded)
+    {
+      // roots are displayed as a whole, so that any nested label affects root presentation
+      const TCollection_AsciiString& aRootId = theExp.Current (0).Id;
+      bindLabelNode (aNode.Label, aRootId);
+      bindLabelNode (aNode.RefLabel, aRootId);
+      return theExp.CurrentDepth() == 0;
+    }
+
+    if (aNode.IsAssembly) { return false; } // handle only leaves
+    for (int aDepth = 0; aDepth <= theExp.CurrentDepth(); ++aDepth)
+    {
+      const XCAFPrs_DocumentNode& aParent = theExp.Current (aDepth);
+      bindLabelNode (aParent.Label, aNode.Id);
+      bindLabelNode (aParent.RefLabel, aNode.Id);
+    }
+    return true;
+  }
+
+  //! Add node Id to the list of label nodes.
+  void bindLabelNode (const TDF_Label& theLabel,
+                      const TCollection_AsciiString& theId)
+  {
+    NCollection_List<TCollection_AsciiString>* aNodes = myLabelNodes.ChangeSeek (theLabel);
+    if (aNodes == NULL)
+    {
+      aNodes = myLabelNodes.Bound (theLabel, NCollection_List<TCollection_AsciiString>());
+    }
+    else if (aNodes->Last() == theId)
+    {
+      return; // instance and prototype labels of a free shape coincide
+    }
+    aNodes->Append (theId);
   }
 
-  //! Display XCAF document within AIS context.
-  void DisplayXCafDocument (bool theToExplode)
+  //! Display presentation of document node.
+  void displayNode (const XCAFPrs_DocumentNode& theNode)
   {
-    if (myXdeDoc.IsNull()) { return; }
+    Handle(XCAFPrs_AISObject) aPrs = new MyXCafPrsObject (theNode.RefLabel);
+    if (!theNode.Location.IsIdentity()) { aPrs->SetLocalTransformation (theNode.Location); }
+
+    // AIS object's owner is an application-owned property; it is set to string object in this sample
+    aPrs->SetOwner (new TCollection_HAsciiString (theNode.Id));
+
+    myContext->Display (aPrs, AIS_Shaded, 0, false);
+    myNodePrsMap.Bind (theNode.Id, aPrs);
+  }
+
+  //! Walk over document structure to display new nodes and erase removed ones; label index is rebuilt.
+  void syncStructure (MySyncStats& theStats)
+  {
+    OcctTraceScope aTrace ("SyncStructure");
+    const Handle(Prs3d_Drawer)& aDefDrawer = myContext->DefaultDrawer();
+    NCollection_Map<TCollection_AsciiString> aLiveIds;
+    myLabelNodes.Clear();
     for (XCAFPrs_DocumentExplorer aDocExp (myXdeDoc, XCAFPrs_DocumentExplorerFlags_None); aDocExp.More(); aDocExp.Next())
     {
+      if (!registerNode (aDocExp)) { continue; }
+
       const XCAFPrs_DocumentNode& aNode = aDocExp.Current();
-      if (theToExplode)
+      aLiveIds.Add (aNode.Id);
+      if (!myNodePrsMap.IsBound (aNode.Id))
       {
-        if (aNode.IsAssembly) { continue; } // handle only leaves
+        meshShape (XCAFDoc_ShapeTool::GetShape (aNode.RefLabel), aDefDrawer);
+        displayNode (aNode);
+        ++theStats.NbAdded;
       }
-      else
+    }
+
+    NCollection_List<TCollection_AsciiString> aRemovedIds;
+    for (MyNodePrsMap::Iterator aNodeIter (myNodePrsMap); aNodeIter.More(); aNodeIter.Next())
+    {
+      if (!aLiveIds.Contains (aNodeIter.Key()))
       {
-        if (aDocExp.CurrentDepth() != 0) { continue; } // handle only roots
+        myContext->Remove (aNodeIter.Value(), false);
+        aRemovedIds.Append (aNodeIter.Key());
       }
+    }
+    for (NCollection_List<TCollection_AsciiString>::Iterator anIdIter (aRemovedIds); anIdIter.More(); anIdIter.Next())
+    {
+      myNodePrsMap.UnBind (anIdIter.Value());
+      ++theStats.NbRemoved;
+    }
+    if (theStats.NbAdded != 0
+     || theStats.NbRemoved != 0)
+    {
+      rebindPresentations();
+    }
+  }
 
-      Handle(XCAFPrs_AISObject) aPrs = new XCAFPrs_AISObject (aNode.RefLabel);
-      if (!aNode.Location.IsIdentity()) { aPrs->SetLocalTransformation (aNode.Location); }
+  //! Rebuild section parts, box proxies and playback bindings referring to presentations,
+  //! which should be called after presentations have been removed or recreated.
+  void rebindPresentations()
+  {
+    // proxies are rebuilt on next navigation; parts hidden by shown proxies are made visible again
+    if (myIsProxyShown)
+    {
+      for (MyNodePrsMap::Iterator aPrsIter (myNodePrsMap); aPrsIter.More(); aPrsIter.Next())
+      {
+        myContext->SetViewAffinity (aPrsIter.Value(), myView, true);
+      }
+      myIsProxyShown = false;
+    }
+    if (!myProxyPrs.IsNull())
+    {
+      if (myContext->IsDisplayed (myProxyPrs)) { myContext->Remove (myProxyPrs, false); }
+      myProxyPrs.Nullify();
+    }
+    myNbProxyParts = 0;
 
-      // AIS object's owner is an application-owned property; it is set to string object in this sample
-      aPrs->SetOwner (new TCollection_HAsciiString (aNode.Id));
+    if (!mySectionPlane.IsNull())
+    {
+      // parts still displayed are restored before section is classified again, removed ones are just dropped
+      const gp_Pln aPlane = mySectionPlane->ToPlane();
+      for (MySectionPart& aPart : mySectionParts)
+      {
+        if (myContext->IsDisplayed (aPart.Prs)) { setSectionSide (aPart, MySectionSide_Kept); }
+      }
+      mySectionParts.clear();
+      mySectionPlane.Nullify();
+      SetSectionPlane (aPlane);
+    }
 
-      myContext->Display (aPrs, AIS_Shaded, 0, false);
+    if (!myPlayback.IsNull())
+    {
+      myPlayback->Resolve (myNodePrsMap);
     }
+  }
 
-    myView->FitAll (0.01, false);
-    AIS_ViewController::ProcessExpose();
+  //! Set location of assembly instance (component) label.
+  static void setInstanceLocation (const TDF_Label& theLabel,
+                                   const TopLoc_Location& theLoc)
+  {
+    TDF_Label aRefLabel;
+    XCAFDoc_ShapeTool::GetReferredShape (theLabel, aRefLabel);
+    XCAFDoc_Location::Set (theLabel, theLoc);
+    TNaming_Builder aBuilder (theLabel);
+    aBuilder.Generated (XCAFDoc_ShapeTool::GetShape (aRefLabel).Located (theLoc));
   }
 
-private:
+  //! Mesh shape using the same deflection parameters as presentation.
+  static void meshShape (const TopoDS_Shape& theShape,
+                         const Handle(Prs3d_Drawer)& theDefDrawer)
+  {
+    if (theShape.IsNull()) { return; }
+
+    OcctTraceScope aTraceMesh ("MeshShape");
+    // GetDeflection() modifies drawer, so that local drawer is used within thread
+    Handle(Prs3d_Drawer) aDrawer = new Prs3d_Drawer();
+    aDrawer->SetLink (theDefDrawer);
+    const double aDeflection = StdPrs_ToolTriangulatedShape::GetDeflection (theShape, aDrawer);
+    BRepMesh_IncrementalMesh aMesher (theShape, aDeflection, false, aDrawer->DeviationAngle(), false);
+  }
 
   //! Create XCAF application instance.
   bool createXCAFApp()
@@ -226,20 +1736,72 @@ private:
   //! Create new document.
   void newDocument()
   {
-    // close old document
-    if (!myXdeDoc.IsNull())
-    {
-      if (myXdeDoc->HasOpenCommand()) { myXdeDoc->AbortCommand(); }
-      myXdeDoc->Main().Root().ForgetAllAttributes (true);
-      myXdeApp->Close (myXdeDoc);
-      myXdeDoc.Nullify();
-    }
+    closeDocument();
 
     // create new document
     if (!myXdeApp.IsNull()) { myXdeApp->NewDocument (TCollection_ExtendedString ("BinXCAF"), myXdeDoc); }
     if (!myXdeDoc.IsNull()) { myXdeDoc->SetUndoLimit(10); } // set the maximum number of available "undo" actions
   }
 
+  //! Close current document and remove its presentations.
+  //! Destruction of document data (millions of labels, attributes, shapes and triangulations within large assemblies)
+  //! takes seconds, so that by default it is moved to a background thread, and the next document could be opened immediately.
+  //! Presentations are removed from context within this thread, as they hold graphic resources;
+  //! only erased AIS objects and document data are released in background.
+  void closeDocument()
+  {
+    if (myXdeDoc.IsNull()) { return; }
+
+    OcctTraceScope aTrace ("CloseDocument");
+    OSD_Timer aTimer;
+    aTimer.Start();
+    ObjectsAnimation()->Clear();
+    myPlayback.Nullify();
+    mySectionParts.clear();
+    mySectionPlane.Nullify();
+    myProxyPrs.Nullify();
+    myNbProxyParts = 0;
+    myIsProxyShown = false;
+    myContext->RemoveAll (false);
+
+    // Close() detaches document from application; its data is released after
+    if (myXdeDoc->HasOpenCommand()) { myXdeDoc->AbortCommand(); }
+    myXdeApp->Close (myXdeDoc);
+
+    // previous teardown is awaited to avoid piling up released documents
+    waitTeardown();
+    std::shared_ptr<MyDocumentTeardown> aTeardown = std::make_shared<MyDocumentTeardown>();
+    aTeardown->Document = myXdeDoc;
+    aTeardown->Presentations.Exchange (myNodePrsMap);
+    aTeardown->LabelNodes.Exchange (myLabelNodes);
+    myXdeDoc.Nullify();
+    myLazyNodes.clear();
+    myLazyParts.Clear();
+    myLazyMemory = 0;
+    myIsLazy = false;
+    if (myToCloseAsync)
+    {
+      myTeardownThread = std::thread ([aTeardown]() { aTeardown->Release(); });
+    }
+    else
+    {
+      aTeardown->Release();
+    }
+    aTimer.Stop();
+    Message::SendInfo() << "Previous document closed in " << 1000.0 * aTimer.ElapsedTime() << " ms"
+                        << (myToCloseAsync ? " (released in background)" : "");
+  }
+
+  //! Wait for background teardown of previous document.
+  void waitTeardown()
+  {
+    if (myTeardownThread.joinable())
+    {
+      OcctTraceScope aTrace ("WaitTeardown");
+      myTeardownThread.join();
+    }
+  }
+
   //! Format XCAF node's name(s) starting from parent to leaf.
   static TCollection_AsciiString getXCafNodePathNames (const XCAFPrs_DocumentExplorer& theExp,
                                                        const bool theIsInstanceName,
@@ -319,6 +1881,325 @@ private:
     }
   }
 
+  //! Render id pass: each node presentation is highlighted by a flat color encoding its index
+  //! as (r + g * 256 + b * 65536) within unlit view without anti-aliasing, and read back by ToPixMap().
+  //! View state (shading model, rendering parameters, background, trihedron and highlighting) is restored afterwards.
+  //! @param[out] theImage   id image
+  //! @param[out] theNodeIds node Ids indexed by id value; value 0 is reserved for background
+  //! @param[in]  theParams  dump parameters
+  bool renderIdPass (Image_AlienPixMap& theImage,
+                     std::vector<TCollection_AsciiString>& theNodeIds,
+                     V3d_ImageDumpOptions theParams)
+  {
+    Handle(OpenGl_GraphicDriver) aDriver = Handle(OpenGl_GraphicDriver)::DownCast (myContext->CurrentViewer()->Driver());
+    const Handle(OpenGl_Context)& aGlCtx = aDriver->GetSharedContext();
+
+    // id color should reach framebuffer unchanged, so that it is defined in the color space of framebuffer
+    const Quantity_TypeOfColor aColorSpace = !aGlCtx.IsNull() && aGlCtx->ToRenderSRGB() ? Quantity_TOC_sRGB : Quantity_TOC_RGB;
+    myContext->ClearDetected (false);
+    theNodeIds.assign (1, TCollection_AsciiString());
+    for (MyNodePrsMap::Iterator aPrsIter (myNodePrsMap); aPrsIter.More(); aPrsIter.Next())
+    {
+      const int anId = (int )theNodeIds.size();
+      theNodeIds.push_back (aPrsIter.Key());
+
+      Handle(Prs3d_Drawer) anIdStyle = new Prs3d_Drawer();
+      anIdStyle->SetMethod (Aspect_TOHM_COLOR);
+      anIdStyle->SetDisplayMode (AIS_Shaded);
+      anIdStyle->SetTransparency (0.0f);
+      anIdStyle->SetColor (Quantity_Color (double(anId & 0xFF) / 255.0,
+                                           double((anId >> 8) & 0xFF) / 255.0,
+                                           double((anId >> 16) & 0xFF) / 255.0, aColorSpace));
+      myContext->HilightWithColor (aPrsIter.Value(), anIdStyle, false);
+    }
+
+    Graphic3d_RenderingParams& aParams = myView->ChangeRenderingParams();
+    const Graphic3d_RenderingParams aPrevParams = aParams;
+    const Graphic3d_TypeOfShadingModel aPrevShadingModel = myView->ShadingModel();
+    const Quantity_Color aPrevBgColor = myView->BackgroundColor();
+    aParams.Method = Graphic3d_RM_RASTERIZATION;
+    aParams.NbMsaaSamples = 0;
+    aParams.RenderResolutionScale = 1.0f;
+    aParams.IsAntialiasingEnabled = false;
+    aParams.ToneMappingMethod = Graphic3d_ToneMappingMethod_Disabled;
+    myView->SetShadingModel (Graphic3d_TOSM_UNLIT);
+    myView->SetBackgroundColor (Quantity_NOC_BLACK);
+    myView->TriedronErase();
+
+    theParams.BufferType = Graphic3d_BT_RGB;
+    const bool isDone = myView->ToPixMap (theImage, theParams);
+
+    myView->TriedronDisplay (Aspect_TOTP_LEFT_LOWER, Quantity_NOC_WHITE, 0.1);
+    myView->SetBackgroundColor (aPrevBgColor);
+    myView->SetShadingModel (aPrevShadingModel);
+    aParams = aPrevParams;
+    for (MyNodePrsMap::Iterator aPrsIter (myNodePrsMap); aPrsIter.More(); aPrsIter.Next())
+    {
+      myContext->Unhilight (aPrsIter.Value(), false);
+    }
+    myContext->HilightSelected (false);
+    return isDone;
+  }
+
+  //! Reconstruct world-space normals from depth buffer.
+  //! Pixels are unprojected by inverted view-projection matrix (default [-1, 1] NDC depth range),
+  //! and the normal is a cross product of horizontal and vertical tangents; for each direction the neighbor
+  //! with the same id and the smaller depth difference is taken to avoid crossing silhouettes and creases.
+  //! Pixels without neighbors of the same id in both directions get zero normal.
+  //! @param[in]  theSizeX   image width
+  //! @param[in]  theSizeY   image height
+  //! @param[in]  theIds     id per pixel (0 for background) in top-down row order
+  //! @param[in]  theDepths  depth per pixel within [0, 1] range in top-down row order
+  //! @param[out] theNormals normal per pixel in top-down row order
+  void reconstructNormals (int theSizeX, int theSizeY,
+                           const std::vector<int>& theIds,
+                           const std::vector<float>& theDepths,
+                           std::vector<float>& theNormals) const
+  {
+    const Handle(Graphic3d_Camera)& aCam = myView->Camera();
+    Graphic3d_Mat4d anInvViewProj;
+    (aCam->ProjectionMatrix() * aCam->OrientationMatrix()).Inverted (anInvViewProj);
+
+    std::vector<gp_XYZ> aPoints (theIds.size());
+    OSD_Parallel::For (0, theSizeY, [&](int theRow)
+    {
+      for (int aCol = 0; aCol < theSizeX; ++aCol)
+      {
+        const size_t aPixIndex = size_t(theRow) * theSizeX + aCol;
+        if (theIds[aPixIndex] == 0) { continue; }
+
+        const Graphic3d_Vec4d aNdc (2.0 * (aCol + 0.5) / theSizeX - 1.0,
+                                    1.0 - 2.0 * (theRow + 0.5) / theSizeY,
+                                    2.0 * theDepths[aPixIndex] - 1.0, 1.0);
+        const Graphic3d_Vec4d aPnt = anInvViewProj * aNdc;
+        aPoints[aPixIndex] = gp_XYZ (aPnt.x(), aPnt.y(), aPnt.z()) / aPnt.w();
+      }
+    });
+
+    // return tangent towards the neighbor with the same id and closer position, or zero vector
+    auto aTangent = [&](size_t thePixIndex, bool theHasPrev, size_t thePrev, bool theHasNext, size_t theNext)
+    {
+      const int anId = theIds[thePixIndex];
+      const gp_XYZ& aPnt = aPoints[thePixIndex];
+      const bool isPrev = theHasPrev && theIds[thePrev] == anId;
+      const bool isNext = theHasNext && theIds[theNext] == anId;
+      if (isPrev && isNext)
+      {
+        return (aPnt - aPoints[thePrev]).SquareModulus() < (aPoints[theNext] - aPnt).SquareModulus()
+             ? aPnt - aPoints[thePrev]
+             : aPoints[theNext] - aPnt;
+      }
+      return isPrev ? aPnt - aPoints[thePrev] : (isNext ? aPoints[theNext] - aPnt : gp_XYZ());
+    };
+
+    const gp_XYZ anEye = aCam->Eye().XYZ(), aViewDir = aCam->Direction().XYZ();
+    OSD_Parallel::For (0, theSizeY, [&](int theRow)
+    {
+      for (int aCol = 0; aCol < theSizeX; ++aCol)
+      {
+        const size_t aPixIndex = size_t(theRow) * theSizeX + aCol;
+        if (theIds[aPixIndex] == 0) { continue; }
+
+        const gp_XYZ aTangX = aTangent (aPixIndex, aCol > 0, aPixIndex - 1, aCol + 1 < theSizeX, aPixIndex + 1);
+        const gp_XYZ aTangY = aTangent (aPixIndex, theRow > 0, aPixIndex - theSizeX, theRow + 1 < theSizeY, aPixIndex + theSizeX);
+        gp_XYZ aNormal = aTangX.Crossed (aTangY);
+        const double aModulus = aNormal.Modulus();
+        if (aModulus <= gp::Resolution()) { continue; }
+
+        // orient towards the viewer
+        aNormal /= aModulus;
+        const gp_XYZ aToViewer = aCam->IsOrthographic() ? aViewDir.Reversed() : anEye - aPoints[aPixIndex];
+        if (aNormal.Dot (aToViewer) < 0.0) { aNormal.Reverse(); }
+
+        float* aNormalOut = &theNormals[aPixIndex * 3];
+        aNormalOut[0] = (float )aNormal.X();
+        aNormalOut[1] = (float )aNormal.Y();
+        aNormalOut[2] = (float )aNormal.Z();
+      }
+    });
+  }
+
+  //! Wait for completion of submitted rendering commands to measure frame time.
+  void finishRendering()
+  {
+    Handle(OpenGl_GraphicDriver) aDriver = Handle(OpenGl_GraphicDriver)::DownCast (myContext->CurrentViewer()->Driver());
+    const Handle(OpenGl_Context)& aGlCtx = aDriver->GetSharedContext();
+    if (!aGlCtx.IsNull()) { aGlCtx->core11fwd->glFinish(); }
+  }
+
+  //! Classify parts against section plane and update only those that changed their side.
+  void updateSection()
+  {
+    OcctTraceScope aTrace ("UpdateSection");
+    const gp_Pln aPlane = mySectionPlane->ToPlane();
+    const gp_XYZ aNorm = aPlane.Axis().Direction().XYZ();
+    const gp_XYZ anOrig = aPlane.Location().XYZ();
+    for (MySectionPart& aPart : mySectionParts)
+    {
+      // signed distance of box center and projected half-extent of box onto plane normal
+      const gp_XYZ aMin = aPart.Box.CornerMin().XYZ(), aMax = aPart.Box.CornerMax().XYZ();
+      const gp_XYZ aHalf = (aMax - aMin) * 0.5;
+      const double aDist = ((aMin + aHalf) - anOrig).Dot (aNorm);
+      const double aRadius = std::abs (aHalf.X() * aNorm.X()) + std::abs (aHalf.Y() * aNorm.Y()) + std::abs (aHalf.Z() * aNorm.Z());
+      const MySectionSide aSide = aDist - aRadius > 0.0
+                                ? MySectionSide_Kept
+                                : (aDist + aRadius < 0.0 ? MySectionSide_Clipped : MySectionSide_Cut);
+      setSectionSide (aPart, aSide);
+    }
+    myView->Invalidate();
+  }
+
+  //! Update presentation of section part for a new side of plane.
+  void setSectionSide (MySectionPart& thePart,
+                       MySectionSide theSide)
+  {
+    if (thePart.Side == theSide) { return; }
+
+    if (thePart.Side == MySectionSide_Cut)     { thePart.Prs->RemoveClipPlane (mySectionPlane); }
+    if (thePart.Side == MySectionSide_Clipped) { myContext->SetViewAffinity (thePart.Prs, myView, true); }
+    if (theSide == MySectionSide_Cut)          { thePart.Prs->AddClipPlane (mySectionPlane); }
+    if (theSide == MySectionSide_Clipped)      { myContext->SetViewAffinity (thePart.Prs, myView, false); }
+    thePart.Side = theSide;
+  }
+
+  //! Handle key press; PageUp/PageDown keys move section plane.
+  virtual void KeyDown (Aspect_VKey theKey,
+                        double theTime,
+                        double thePressure) override
+  {
+    AIS_ViewController::KeyDown (theKey, theTime, thePressure);
+    if (!mySectionPlane.IsNull()
+     && (theKey == Aspect_VKey_PageUp || theKey == Aspect_VKey_PageDown))
+    {
+      MoveSectionPlane (theKey == Aspect_VKey_PageUp ? mySectionStep : -mySectionStep);
+      FlushViewEvents (myContext, myView, true);
+    }
+  }
+
+  //! Switch between detailed parts and box proxies depending on camera motion and the last full detail frame time.
+  void updateNavigationProxies (const Handle(V3d_View)& theView)
+  {
+    const Graphic3d_WorldViewProjState& aCamState = theView->Camera()->WorldViewProjState();
+    const bool isMoving = aCamState.IsChanged (myNavCamState)
+                       || PressedMouseButtons() != Aspect_VKeyMouse_NONE
+                       || !ViewAnimation()->IsStopped();
+    myNavCamState = aCamState;
+    if (isMoving)
+    {
+      myNavIdleTimer.Reset();
+      myNavIdleTimer.Start();
+    }
+
+    if (isMoving
+    && !myIsProxyShown
+    &&  myNavFrameTime > myNavFrameBudget
+    && !myNodePrsMap.IsEmpty())
+    {
+      showNavigationProxies (true);
+    }
+    else if (!isMoving
+          && myIsProxyShown
+          && myNavIdleTimer.ElapsedTime() > 0.2)
+    {
+      showNavigationProxies (false);
+      Message::SendInfo() << "Navigation: " << myNbProxyFrames << " proxy frames, "
+                          << 1000.0 * myProxyFramesTime / std::max (myNbProxyFrames, 1) << " ms per frame; full detail "
+                          << 1000.0 * myNavFrameTime << " ms";
+    }
+
+    // keep redrawing while proxies are shown to detect the end of motion
+    if (myIsProxyShown) { myToAskNextFrame = true; }
+  }
+
+  //! Return box proxy color of part presentation.
+  //! XCAFPrs_AISObject keeps colors in XCAF styles rather than in AIS color property (HasColor() is FALSE),
+  //! so that surface color of the part itself is taken, or the first one assigned to its subshapes.
+  static Quantity_Color proxyColor (const Handle(XCAFPrs_AISObject)& thePrs)
+  {
+    TopLoc_Location aLoc;
+    XCAFPrs_IndexedDataMapOfShapeStyle aStyles;
+    XCAFPrs::CollectStyleSettings (thePrs->GetLabel(), aLoc, aStyles);
+    const TopoDS_Shape aShape = XCAFDoc_ShapeTool::GetShape (thePrs->GetLabel());
+    if (const XCAFPrs_Style* aShapeStyle = aStyles.Seek (aShape))
+    {
+      if (aShapeStyle->IsSetColorSurf()) { return aShapeStyle->GetColorSurf(); }
+    }
+    for (XCAFPrs_IndexedDataMapOfShapeStyle::Iterator aStyleIter (aStyles); aStyleIter.More(); aStyleIter.Next())
+    {
+      if (aStyleIter.Value().IsSetColorSurf()) { return aStyleIter.Value().GetColorSurf(); }
+    }
+    return Quantity_Color (Quantity_NOC_GRAY70);
+  }
+
+  //! Show merged box proxies instead of detailed parts or restore detailed parts.
+  void showNavigationProxies (bool theToShow)
+  {
+    OcctTraceScope aTrace (theToShow ? "ShowProxies" : "HideProxies");
+    if (theToShow
+     && (myProxyPrs.IsNull() || myNbProxyParts != myNodePrsMap.Extent()))
+    {
+      if (!myProxyPrs.IsNull()) { myContext->Remove (myProxyPrs, false); }
+
+      // part boxes are computed from already displayed presentations
+      myProxyPrs = new MyBoxProxyPrs();
+      for (MyNodePrsMap::Iterator aPrsIter (myNodePrsMap); aPrsIter.More(); aPrsIter.Next())
+      {
+        Bnd_Box aBox;
+        aPrsIter.Value()->BoundingBox (aBox);
+        if (!aBox.IsVoid()) { myProxyPrs->AddBox (aBox.Transformed (aPrsIter.Value()->Transformation()), proxyColor (aPrsIter.Value())); }
+      }
+      myNbProxyParts = myNodePrsMap.Extent();
+      myContext->Display (myProxyPrs, AIS_Shaded, -1, false);
+    }
+
+    for (MyNodePrsMap::Iterator aPrsIter (myNodePrsMap); aPrsIter.More(); aPrsIter.Next())
+    {
+      myContext->SetViewAffinity (aPrsIter.Value(), myView, !theToShow);
+    }
+    for (const MySectionPart& aPart : mySectionParts)
+    {
+      if (aPart.Side == MySectionSide_Clipped) { myContext->SetViewAffinity (aPart.Prs, myView, false); }
+    }
+    myContext->SetViewAffinity (myProxyPrs, myView, theToShow);
+    myIsProxyShown = theToShow;
+    myNbProxyFrames = 0;
+    myProxyFramesTime = 0.0;
+  }
+
+  //! Redraw the view.
+  virtual void handleViewRedraw (const Handle(AIS_InteractiveContext)& theCtx,
+                                 const Handle(V3d_View)& theView) override
+  {
+    OcctTraceScope aTrace ("Frame");
+    if (myIsLazy
+     && theView->Camera()->WorldViewProjState().IsChanged (myLazyCamState))
+    {
+      UpdateLazyParts();
+    }
+    if (!ObjectsAnimation()->IsStopped())
+    {
+      myNbProxyParts = 0; // animated parts move away from their boxes
+    }
+    if (myNavFrameBudget > 0.0)
+    {
+      updateNavigationProxies (theView);
+    }
+
+    OSD_Timer aFrameTimer;
+    aFrameTimer.Start();
+    AIS_ViewController::handleViewRedraw (theCtx, theView);
+    aFrameTimer.Stop();
+    if (myIsProxyShown)
+    {
+      ++myNbProxyFrames;
+      myProxyFramesTime += aFrameTimer.ElapsedTime();
+    }
+    else
+    {
+      myNavFrameTime = aFrameTimer.ElapsedTime();
+    }
+  }
+
   //! Handle expose event.
   virtual void ProcessExpose() override
   {
@@ -378,6 +2259,33 @@ private:
 
   Handle(TDocStd_Application)    myXdeApp;  //!< XDE application instance
   Handle(TDocStd_Document)       myXdeDoc;  //!< XDE document instance
+  MyNodePrsMap                   myNodePrsMap; //!< displayed presentations by node Id
+  MyLabelNodesMap                myLabelNodes; //!< displayed node Ids by document labels
+  bool                           myIsExploded; //!< document leaves are displayed as dedicated presentations
+  bool                           myToCloseAsync; //!< release closed document in background
+  std::thread                    myTeardownThread; //!< background teardown of closed document
+
+  TCollection_AsciiString        myXbfPath;      //!< opened XBF file for partial loading
+  std::vector<MyLazyNode>        myLazyNodes;    //!< leaves of partially loaded document
+  NCollection_DataMap<TDF_Label, MyLazyPart, TDF_LabelMapHasher> myLazyParts; //!< parts of partially loaded document
+  Graphic3d_WorldViewProjState   myLazyCamState; //!< camera state of the last partial loading update
+  size_t                         myLazyBudget;   //!< memory budget for loaded shapes
+  size_t                         myLazyMemory;   //!< estimated memory of loaded shapes
+  int                            myLazyFrame;    //!< counter of partial loading updates
+  bool                           myIsLazy;       //!< document is loaded partially
+  Handle(Graphic3d_ClipPlane)    mySectionPlane; //!< section plane or NULL if section view is disabled
+  std::vector<MySectionPart>     mySectionParts; //!< displayed parts classified against section plane
+  double                         mySectionStep;  //!< section plane step for key navigation
+  Handle(MyBoxProxyPrs)          myProxyPrs;     //!< merged bounding box proxies of displayed parts
+  Graphic3d_WorldViewProjState   myNavCamState;  //!< camera state of the last frame for motion detection
+  OSD_Timer                      myNavIdleTimer; //!< time since the last camera motion
+  double                         myNavFrameBudget;  //!< frame time budget for switching to proxies (0 to disable)
+  double                         myNavFrameTime;    //!< time of the last full detail frame
+  double                         myProxyFramesTime; //!< accumulated time of proxy frames
+  int                            myNbProxyFrames;   //!< number of frames drawn with proxies
+  int                            myNbProxyParts;    //!< number of presentations proxies were built for (0 to rebuild)
+  bool                           myIsProxyShown;    //!< proxies are displayed instead of detailed parts
+  Handle(MyPlaybackAnimation)    myPlayback;   //!< kinematic playback
 };
 
 //! Fill in array of program arguments.
@@ -402,6 +2310,24 @@ static void fillAppArguments (std::vector<TCollection_AsciiString>& theArgsOut,
 #endif
 }
 
+//! Open STEP or XBF file.
+//! @param[in] theToLoadLazy load shapes of XBF file on demand
+static void openModel (MyViewer& theViewer,
+                       const TCollection_AsciiString& thePath,
+                       bool theToLoadLazy)
+{
+  TCollection_AsciiString aNameLower = thePath;
+  aNameLower.LowerCase();
+  if (aNameLower.EndsWith (".xbf"))
+  {
+    theViewer.OpenXBF (thePath, theToLoadLazy);
+  }
+  else //if (aNameLower.EndsWith (".stp") || aNameLower.EndsWith (".step"))
+  {
+    theViewer.OpenSTEP (thePath);
+  }
+}
+
 int main (int theNbArgs, char** theArgVec)
 {
   OSD::SetSignal (false);
@@ -409,18 +2335,144 @@ int main (int theNbArgs, char** theArgVec)
   std::vector<TCollection_AsciiString> anArgs;
   fillAppArguments (anArgs, theNbArgs, theArgVec);
 
-  TCollection_AsciiString aModelPath;
-  if (anArgs.size() > 2)
+  TCollection_AsciiString aModelPath, aNextModelPath, aRecordPath, aPlayPath, anExportFolder, aPassesFolder, aSaveXbfPath, aReportPath, aClashPath;
+  TCollection_AsciiString aTracePath = OSD_Environment ("OCCT_TRACE_FILE").Value();
+  int    aNbRecordFrames = 300;
+  int    aNbBenchEdits = 0;
+  int    aNbSectionFrames = 0;
+  double aNavFps = 0.0;
+  double aFps = 30.0;
+  bool   isOffscreen = false;
+  bool   isSyncClose = false;
+  bool   isLazy = false;
+  bool   toDedup = false;
+  double aLazyBudgetMiB = 1024.0;
+  double aClashTol = 0.0;
+  for (size_t anArgIter = 1; anArgIter < anArgs.size(); ++anArgIter)
+  {
+    TCollection_AsciiString anArg = anArgs[anArgIter];
+    anArg.LowerCase();
+    if (anArg == "-trace"
+     && anArgIter + 1 < anArgs.size())
+    {
+      aTracePath = anArgs[++anArgIter];
+    }
+    else if (anArg == "-record"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aRecordPath = anArgs[++anArgIter];
+    }
+    else if (anArg == "-frames"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aNbRecordFrames = std::max (anArgs[++anArgIter].IntegerValue(), 2);
+    }
+    else if (anArg == "-play"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aPlayPath = anArgs[++anArgIter];
+    }
+    else if (anArg == "-export"
+          && anArgIter + 1 < anArgs.size())
+    {
+      anExportFolder = anArgs[++anArgIter];
+    }
+    else if (anArg == "-fps"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aFps = std::max (anArgs[++anArgIter].RealValue(), 1.0);
+    }
+    else if (anArg == "-passes"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aPassesFolder = anArgs[++anArgIter];
+    }
+    else if (anArg == "-editbench"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aNbBenchEdits = std::max (anArgs[++anArgIter].IntegerValue(), 1);
+    }
+    else if (anArg == "-next"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aNextModelPath = anArgs[++anArgIter];
+    }
+    else if (anArg == "-syncclose")
+    {
+      isSyncClose = true;
+    }
+    else if (anArg == "-report"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aReportPath = anArgs[++anArgIter];
+    }
+    else if (anArg == "-clash"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aClashPath = anArgs[++anArgIter];
+    }
+    else if (anArg == "-clashtol"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aClashTol = std::max (anArgs[++anArgIter].RealValue(), 0.0);
+    }
+    else if (anArg == "-section"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aNbSectionFrames = std::max (anArgs[++anArgIter].IntegerValue(), 1);
+    }
+    else if (anArg == "-navfps"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aNavFps = std::max (anArgs[++anArgIter].RealValue(), 1.0);
+    }
+    else if (anArg == "-dedup")
+    {
+      toDedup = true;
+    }
+    else if (anArg == "-lazy")
+    {
+      isLazy = true;
+    }
+    else if (anArg == "-lazybudget"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aLazyBudgetMiB = std::max (anArgs[++anArgIter].RealValue(), 1.0);
+    }
+    else if (anArg == "-savexbf"
+          && anArgIter + 1 < anArgs.size())
+    {
+      aSaveXbfPath = anArgs[++anArgIter];
+    }
+    else if (anArg == "-offscreen")
+    {
+      isOffscreen = true;
+    }
+    else if (aModelPath.IsEmpty())
+    {
+      aModelPath = anArgs[anArgIter];
+    }
+    else
+    {
+      Message::SendFail() << "Syntax error at '" << anArgs[anArgIter] << "'";
+      return 1;
+    }
+  }
+
+  if (isLazy
+   && (toDedup || !aReportPath.IsEmpty() || !aClashPath.IsEmpty()))
   {
-    Message::SendFail() << "Syntax error: wrong number of arguments";
+    // partially loaded document has no shapes of invisible parts to process
+    Message::SendFail() << "Syntax error: -lazy cannot be combined with -dedup, -report or -clash";
     return 1;
   }
 
-  if (anArgs.size() == 2)
+  if (!aTracePath.IsEmpty())
   {
-    aModelPath = anArgs[1];
+    OcctTrace::Instance().Start (aTracePath);
   }
-  else
+
+  if (aModelPath.IsEmpty())
   {
     OSD_Environment aVarModDir ("SAMPLE_MODELS_DIR");
     if (!aVarModDir.Value().IsEmpty())
@@ -433,24 +2485,91 @@ int main (int theNbArgs, char** theArgVec)
     }
   }
 
-  MyViewer aViewer;
+  MyViewer aViewer (isOffscreen);
+  aViewer.SetAsyncClose (!isSyncClose);
+  aViewer.SetLazyBudget (size_t(aLazyBudgetMiB * 1024.0 * 1024.0));
+  aViewer.SetNavigationBudget (aNavFps > 0.0 ? 1.0 / aNavFps : 0.0);
   if (!aModelPath.IsEmpty())
   {
-    TCollection_AsciiString aNameLower = aModelPath;
-    aNameLower.LowerCase();
-    if (aNameLower.EndsWith (".xbf"))
-    {
-      aViewer.OpenXBF (aModelPath);
-    }
-    else //if (aNameLower.EndsWith (".stp") || aNameLower.EndsWith (".step"))
+    openModel (aViewer, aModelPath, isLazy);
+    if (toDedup) { aViewer.DeduplicateParts(); }
+    if (!aReportPath.IsEmpty()
+     && !aViewer.SaveMassReport (aReportPath))
     {
-      aViewer.OpenSTEP (aModelPath);
+      return 1;
     }
-
     aViewer.DumpXCafDocumentTree();
     aViewer.DisplayXCafDocument (true);
   }
 
+  if (!aNextModelPath.IsEmpty())
+  {
+    // measure switching to the next file with a document already loaded
+    OSD_Timer aTimer;
+    aTimer.Start();
+    openModel (aViewer, aNextModelPath, isLazy);
+    if (toDedup) { aViewer.DeduplicateParts(); }
+    aViewer.DisplayXCafDocument (true);
+    aTimer.Stop();
+    Message::SendInfo() << "Next file '" << aNextModelPath << "' opened and displayed in " << aTimer.ElapsedTime() << " s";
+  }
+
+  if (!aClashPath.IsEmpty()
+   && !aViewer.DetectClashes (aClashPath, aClashTol))
+  {
+    return 1;
+  }
+
+  if (aNbSectionFrames > 0
+   && !aViewer.RunSectionBenchmark (aNbSectionFrames))
+  {
+    return 1;
+  }
+
+  if (!aPassesFolder.IsEmpty()
+   && !aViewer.ExportPasses (aPassesFolder))
+  {
+    return 1;
+  }
+
+  if (aNbBenchEdits > 0
+   && !aViewer.RunEditBenchmark (aNbBenchEdits))
+  {
+    return 1;
+  }
+
+  if (!aSaveXbfPath.IsEmpty()
+   && !aViewer.SaveXBF (aSaveXbfPath, true))
+  {
+    return 1;
+  }
+
+  if (!aRecordPath.IsEmpty())
+  {
+    if (!aViewer.RecordDemoPlayback (aRecordPath, aNbRecordFrames, aFps))
+    {
+      return 1;
+    }
+    if (aPlayPath.IsEmpty()) { aPlayPath = aRecordPath; }
+  }
+  if (!aPlayPath.IsEmpty())
+  {
+    if (!aViewer.LoadPlayback (aPlayPath))
+    {
+      return 1;
+    }
+    if (!anExportFolder.IsEmpty()
+     && !aViewer.ExportPlayback (anExportFolder, aFps))
+    {
+      return 1;
+    }
+    aViewer.StartPlayback();
+  }
+  if (isOffscreen)
+  {
+    return 0;
+  }
+
 #ifdef _WIN32
   // WinAPI message loop
   for (;;)